@@ -144,6 +144,9 @@ public:
     void setIsSalvage(const bool issalvage) {setFlag(IsSalvage, issalvage); }
     void setManualExit(const bool isterminate) {setFlag(ManualExit, isterminate); }
 
+    int value() const { return mFlags; } ///< all flags as a single integer (e.g. for checkpoints)
+    void setValue(const int flags) { mFlags = flags; } ///< set all flags (see value())
+
 private:
     /// (binary coded)  flags
     enum Flags { Active=1,  // if false, the activity has already been executed
@@ -36,7 +36,11 @@
 #include "species.h"
 
 #include "statdata.h"
+#include "standstatistics.h"
 #include "debugtimer.h"
+#include "logqueue.h"
+
+#include <QDataStream>
 
 namespace ABE {
 
@@ -71,6 +75,11 @@ FMStand::FMStand(FMUnit *unit, const int id)
     mStems = 0.;
     mDbh = 0.;
     mHeight = 0.;
+    mTopHeight = 0.;
+    mIncremental = false;
+    mAgeSum = mDbhSum = mHeightSum = 0.;
+    mTreeCount = 0;
+    mTopHeightDirty = false;
     mScheduledHarvest = 0.;
     mFinalHarvested = 0.;
     mThinningHarvest = 0.;
@@ -201,8 +210,21 @@ bool relBasalAreaIsHigher(const SSpeciesStand &a, const SSpeciesStand &b)
 
 void FMStand::reload(bool force)
 {
-    if (!force && mLastUpdate == ForestManagementEngine::instance()->currentYear())
-        return;
+    bool validate = false;
+    if (mLastUpdate == ForestManagementEngine::instance()->currentYear()) {
+        if (!force)
+            return;
+        // the trees removed since the last reload are subtracted from the statistics (see notifyTreeRemoval()).
+        // The full reload is only used for validation.
+        if (mIncremental) {
+            applyRemovedTrees();
+            if (!StandStatistics::validationMode())
+                return;
+            validate = true;
+        }
+    }
+    // the incrementally updated values (validation mode only)
+    const double incremental[7] = { mTotalBasalArea, mVolume, mAge, mDbh, mHeight, mStems, validate ? topHeight() : 0. };
 
     DebugTimer t("ABE:FMStand::reload");
     // load all trees that are located on this stand
@@ -229,9 +251,16 @@ void FMStand::reload(bool force)
     // calculate top-height: diameter of the 100 thickest trees per ha
     QVector<double> dbhvalues;
     dbhvalues.reserve(trees->trees().size());
+    mDbhHeight.clear();
+    mDbhHeight.reserve(trees->trees().size());
+    mRemovedDbhHeight.clear();
+    mRemovedTrees.clear();
 
-    for ( QVector<QPair<Tree*, double> >::const_iterator it=treelist.constBegin(); it!=treelist.constEnd(); ++it)
+    for ( QVector<QPair<Tree*, double> >::const_iterator it=treelist.constBegin(); it!=treelist.constEnd(); ++it) {
         dbhvalues.push_back(it->first->dbh());
+        mDbhHeight.push_back(QPair<double, double>(it->first->dbh(), it->first->height()));
+    }
+    std::sort(mDbhHeight.begin(), mDbhHeight.end());
 
     double topheight_threshhold=0.;
     double topheight_height = 0.;
@@ -255,6 +284,10 @@ void FMStand::reload(bool force)
             ++topheight_trees;
         }
     }
+    mAgeSum = mAge;
+    mDbhSum = mDbh;
+    mHeightSum = mHeight;
+    mTreeCount = treelist.size();
     if (mTotalBasalArea>0.) {
         mAge /= mTotalBasalArea;
         mDbh /= mTotalBasalArea;
@@ -266,9 +299,108 @@ void FMStand::reload(bool force)
     if (topheight_trees>0) {
         mTopHeight = topheight_height / double(topheight_trees);
     }
+    mTopHeightDirty = false;
     mStems *= area_factor; // convert to stems/ha
     // sort species data by relative share....
     std::sort(mSpeciesData.begin(), mSpeciesData.end(), relBasalAreaIsHigher);
+    // from now on, removed trees are subtracted from the statistics (until the end of the management of the year)
+    mIncremental = true;
+
+    if (validate) {
+        const double full[7] = { mTotalBasalArea, mVolume, mAge, mDbh, mHeight, mStems, mTopHeight };
+        for (int i=0;i<7;++i) {
+            if (qAbs(incremental[i] - full[i]) > 1e-6 * qMax(1., qAbs(full[i]))) {
+                qCWarning(abe) << context() << "stand statistics validation: (BA, volume, age, dbh, height, stems, topheight) incremental:"
+                               << incremental[0] << incremental[1] << incremental[2] << incremental[3] << incremental[4] << incremental[5] << incremental[6]
+                               << "full:" << full[0] << full[1] << full[2] << full[3] << full[4] << full[5] << full[6];
+                break;
+            }
+        }
+    }
+}
+
+void FMStand::applyRemovedTrees()
+{
+    if (mRemovedTrees.isEmpty())
+        return;
+    for (const SRemovedTree &t : mRemovedTrees) {
+        mTotalBasalArea -= t.basalArea;
+        mAgeSum -= t.age * t.basalArea;
+        mDbhSum -= t.dbh * t.basalArea;
+        mHeightSum -= t.height * t.basalArea;
+        --mTreeCount;
+        speciesData(t.species).basalArea -= t.basalArea;
+        mRemovedDbhHeight.push_back(QPair<double, double>(t.dbh, t.height));
+    }
+    mRemovedTrees.clear();
+    if (mTreeCount <= 0) {
+        // the last tree is removed: reset the sums (avoid rounding residues, as in StandStatistics)
+        mTreeCount = 0;
+        mTotalBasalArea = mAgeSum = mDbhSum = mHeightSum = 0.;
+        mVolume = 0.;
+        for (int i=0;i<mSpeciesData.count();++i)
+            mSpeciesData[i].basalArea = 0.;
+    }
+    mTopHeightDirty = true;
+    updateMeanValues();
+}
+
+void FMStand::updateMeanValues()
+{
+    if (mTotalBasalArea>0.) {
+        mAge = mAgeSum / mTotalBasalArea;
+        mDbh = mDbhSum / mTotalBasalArea;
+        mHeight = mHeightSum / mTotalBasalArea;
+        for (int i=0;i<mSpeciesData.count();++i)
+            mSpeciesData[i].relBasalArea =  mSpeciesData[i].basalArea / mTotalBasalArea;
+    } else {
+        mTotalBasalArea = 0.;
+        mAge = mDbh = mHeight = 0.;
+        for (int i=0;i<mSpeciesData.count();++i)
+            mSpeciesData[i].relBasalArea = 0.;
+    }
+    mStems = mTreeCount / area();
+    std::sort(mSpeciesData.begin(), mSpeciesData.end(), relBasalAreaIsHigher);
+}
+
+void FMStand::updateTopHeight()
+{
+    // drop the removed trees from the (sorted) list of trees
+    if (!mRemovedDbhHeight.isEmpty()) {
+        std::sort(mRemovedDbhHeight.begin(), mRemovedDbhHeight.end());
+        QVector<QPair<double, double> > remaining;
+        remaining.reserve(mDbhHeight.size());
+        int r = 0;
+        for (int i=0;i<mDbhHeight.size();++i) {
+            while (r<mRemovedDbhHeight.size() && mRemovedDbhHeight[r] < mDbhHeight[i])
+                ++r;
+            if (r<mRemovedDbhHeight.size() && mRemovedDbhHeight[r] == mDbhHeight[i]) {
+                ++r; // skip the removed tree
+                continue;
+            }
+            remaining.push_back(mDbhHeight[i]);
+        }
+        mDbhHeight.swap(remaining);
+        mRemovedDbhHeight.clear();
+    }
+    // top height: mean height of the 100 thickest trees per ha (see reload())
+    mTopHeight = 0.;
+    mTopHeightDirty = false;
+    if (mDbhHeight.isEmpty())
+        return;
+    int k = StatData::percentileIndex(static_cast<int>( 100.*(1.- area()*100./mDbhHeight.size()) ), mDbhHeight.size());
+    double threshold = mDbhHeight[k].first;
+    double topheight_height = 0.;
+    int topheight_trees = 0;
+    for (int i=k; i>=0 && mDbhHeight[i].first >= threshold; --i) {
+        topheight_height += mDbhHeight[i].second;
+        ++topheight_trees;
+    }
+    for (int i=k+1; i<mDbhHeight.size(); ++i) {
+        topheight_height += mDbhHeight[i].second;
+        ++topheight_trees;
+    }
+    mTopHeight = topheight_height / double(topheight_trees);
 }
 
 Patches *FMStand::patches() const
@@ -303,6 +435,7 @@ bool FMStand::execute()
     }
 
     FomeScript::setExecutionContext(this);
+    LogContext log_context(LogContext::resourceUnit(), id());
     mContextStr = QString("S%2Y%1:").arg(ForestManagementEngine::instance()->currentYear()).arg(id());
 
 
@@ -483,6 +616,18 @@ void FMStand::notifyTreeRemoval(Tree *tree, int reason)
     double removed_volume = tree->volume();
     mVolume -= removed_volume/area();
 
+    if (mIncremental) {
+        // remember the tree: the statistics are updated with the next forced reload (see applyRemovedTrees()),
+        // i.e. the values seen by the STP remain unchanged until then.
+        SRemovedTree removed;
+        removed.species = tree->species();
+        removed.basalArea = tree->basalArea() / area();
+        removed.age = tree->age();
+        removed.dbh = tree->dbh();
+        removed.height = tree->height();
+        mRemovedTrees.push_back(removed);
+    }
+
     // for MAI calculations: store removal regardless of the reason
     mRemovedVolumeDecade+=removed_volume / area();
     mRemovedVolumeTotal+=removed_volume / area();
@@ -601,6 +746,48 @@ void FMStand::setLastExecution(int index)
     mLastExecution = ForestManagementEngine::instance()->currentYear();
 }
 
+void FMStand::saveState(QDataStream &out) const
+{
+    out << (mSTP ? mSTP->name() : QString());
+    out << static_cast<int>(mPhase) << mU << mThinningIntensityClass << mSpeciesCompositionIndex;
+    out << mRotationStartYear << mYearsToWait << mCurrentIndex << mLastUpdate << mLastExecution << mLastExecutedIndex << mLastRotationAge;
+    out << mFinalHarvested << mThinningHarvest << mDisturbed << mSalvaged;
+    out << mRemovedVolumeDecade << mRemovedVolumeTotal << mLastMAIVolume << mMAIdecade << mMAItotal;
+    out << static_cast<int>(mStandFlags.size());
+    for (const ActivityFlags &f : mStandFlags)
+        out << f.value();
+}
+
+void FMStand::restoreState(QDataStream &in)
+{
+    QString stp_name;
+    int phase, n_flags;
+    in >> stp_name;
+    if (!stp_name.isEmpty() && (!mSTP || mSTP->name()!=stp_name)) {
+        FMSTP *stp = ForestManagementEngine::instance()->stp(stp_name);
+        if (!stp)
+            throw IException(QString("FMStand::restoreState: stand %1: STP '%2' not available.").arg(id()).arg(stp_name));
+        reset(stp);
+        mStandFlags = mSTP->defaultFlags();
+    }
+    in >> phase >> mU >> mThinningIntensityClass >> mSpeciesCompositionIndex;
+    mPhase = static_cast<Activity::Phase>(phase);
+    in >> mRotationStartYear >> mYearsToWait >> mCurrentIndex >> mLastUpdate >> mLastExecution >> mLastExecutedIndex >> mLastRotationAge;
+    in >> mFinalHarvested >> mThinningHarvest >> mDisturbed >> mSalvaged;
+    in >> mRemovedVolumeDecade >> mRemovedVolumeTotal >> mLastMAIVolume >> mMAIdecade >> mMAItotal;
+    in >> n_flags;
+    for (int i=0;i<n_flags;++i) {
+        int value;
+        in >> value;
+        if (i < mStandFlags.size()) {
+            mStandFlags[i].setValue(value);
+            // the scheduler is not part of the state: pending activities are re-scheduled
+            mStandFlags[i].setIsPending(false);
+        }
+    }
+    mLastUpdate = -1; // force a reload of stand statistics
+}
+
 // storage for properties (static)
 QHash<const FMStand*, QHash<QString, QJSValue> > FMStand::mStandPropertyStorage;
 
@@ -26,6 +26,7 @@
 
 class Species; // forward (iLand species)
 class Tree; // forward (iLand tree)
+class QDataStream; // forward
 //enum TreeRemovalType; // forward
 
 namespace ABE {
@@ -65,6 +66,8 @@ public:
     void setArea(const double new_area_ha) { mArea = new_area_ha; } // area in ha
 
     void reload(bool force=false); // fetch new data from the forest stand
+    /// stop the incremental update of the stand statistics (the next reload() re-builds the statistics from all trees)
+    void endIncrementalUpdates() { mIncremental = false; }
     // general properties
     int id() const {return mId; }
     const FMUnit *unit() const { return mUnit; }
@@ -109,7 +112,7 @@ public:
     /// mean tree height (basal area weighted, of trees>4m), in m
     double height() const {return mHeight; }
     /// top height (mean height of the 100 thickest trees/ha), in m
-    double topHeight() const {return mTopHeight; }
+    double topHeight() const { if (mTopHeightDirty) const_cast<FMStand*>(this)->updateTopHeight(); return mTopHeight; }
     /// scheduled harvest (planned harvest by activities, m3)
     double scheduledHarvest() const {return mScheduledHarvest; }
     /// total realized harvest (m3 on the full stand area)
@@ -192,6 +195,9 @@ public:
     int lastExecutionAge() const { return absoluteAge()>0 ? static_cast<int>(absoluteAge()) : mLastRotationAge; }
 
     void setLastExecution(int index);
+    // checkpoints
+    void saveState(QDataStream &out) const; ///< save the management state (STP, activity, counters, flags) of the stand
+    void restoreState(QDataStream &in); ///< restore the state saved with saveState()
     // custom property storage
     static void clearAllProperties() { mStandPropertyStorage.clear(); }
     /// set a property value for the current stand with the name 'name'
@@ -249,6 +255,25 @@ private:
     int mThinningIntensityClass; ///< currently active thinning intensity level
 
     void newRotatation(); ///< reset
+    void applyRemovedTrees(); ///< subtract the trees removed since the last reload from the statistics (see notifyTreeRemoval())
+    void updateMeanValues(); ///< derive the stand level means from the sums (after removal of trees)
+    void updateTopHeight(); ///< re-calculate the top height from the list of remaining trees
+
+    // incrementally updated statistics (see notifyTreeRemoval())
+    bool mIncremental; ///< true if removed trees are subtracted from the statistics (since the last reload)
+    struct SRemovedTree {
+        const Species *species;
+        double basalArea; ///< basal area (m2/ha)
+        double age, dbh, height;
+    };
+    QVector<SRemovedTree> mRemovedTrees; ///< trees removed since the last reload (applied with the next forced reload)
+    double mAgeSum; ///< sum of age * basal area (per ha)
+    double mDbhSum; ///< sum of dbh * basal area (per ha)
+    double mHeightSum; ///< sum of height * basal area (per ha)
+    int mTreeCount; ///< number of trees of the stand
+    bool mTopHeightDirty; ///< true if the top height needs to be re-calculated
+    QVector<QPair<double, double> > mDbhHeight; ///< (dbh, height) of the trees (sorted), used for the top height
+    QVector<QPair<double, double> > mRemovedDbhHeight; ///< (dbh, height) of trees removed since the last update of the top height
 
     // storage for stand meta data (species level)
     QVector<SSpeciesStand> mSpeciesData;
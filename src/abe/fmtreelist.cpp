@@ -342,6 +342,77 @@ QJSValue FMTreeList::treeObject(int index)
 
 }
 
+QJSValue FMTreeList::column(QString name)
+{
+    try {
+        return ScriptTreeColumns::values(ForestManagementEngine::scriptEngine(), mTrees, name);
+    } catch(const IException &e) {
+        qCWarning(abe) << "treelist: column:" << e.message();
+        return QJSValue();
+    }
+}
+
+QJSValue FMTreeList::columns(QStringList names)
+{
+    try {
+        return ScriptTreeColumns::values(ForestManagementEngine::scriptEngine(), mTrees, names);
+    } catch(const IException &e) {
+        qCWarning(abe) << "treelist: columns:" << e.message();
+        return QJSValue();
+    }
+}
+
+int FMTreeList::filterMask(QJSValue mask)
+{
+    try {
+        QVector<bool> m = ScriptTreeColumns::mask(ForestManagementEngine::scriptEngine(), mask, mTrees.count());
+        int j = 0;
+        for (int i=0;i<mTrees.count();++i)
+            if (m[i])
+                mTrees[j++] = mTrees[i];
+        mTrees.resize(j);
+    } catch(const IException &e) {
+        qCWarning(abe) << "treelist: filterMask:" << e.message();
+    }
+    return mTrees.count();
+}
+
+int FMTreeList::killMask(QJSValue mask)
+{
+    return remove_trees_mask(mask, false);
+}
+
+int FMTreeList::harvestMask(QJSValue mask)
+{
+    return remove_trees_mask(mask, true);
+}
+
+int FMTreeList::markMask(QJSValue mask, QString mark, bool value)
+{
+    int n = 0;
+    try {
+        QVector<bool> m = ScriptTreeColumns::mask(ForestManagementEngine::scriptEngine(), mask, mTrees.count());
+        int type = QStringList({"cut", "harvest", "crop", "competitor"}).indexOf(mark);
+        if (type<0)
+            throw IException(QString("invalid mark '%1' (allowed: 'cut', 'harvest', 'crop', 'competitor').").arg(mark));
+        for (int i=0;i<mTrees.count();++i) {
+            if (!m[i])
+                continue;
+            Tree *t = mTrees[i].first;
+            switch (type) {
+            case 0: t->markForCut(value); break;
+            case 1: t->markForHarvest(value); break;
+            case 2: t->markCropTree(value); break;
+            case 3: t->markCropCompetitor(value); break;
+            }
+            ++n;
+        }
+    } catch(const IException &e) {
+        qCWarning(abe) << "treelist: markMask:" << e.message();
+    }
+    return n;
+}
+
 int FMTreeList::kill(QString filter)
 {
     return remove_trees(filter, 1. /* all trees, 100%*/, false);
@@ -457,25 +528,7 @@ int FMTreeList::remove_trees(QString expression, double fraction, bool managemen
             // if expression evaluates to true and if random number below threshold...
             if (expr.calculate(tw) && drandom() <=fraction) {
                 // remove from system
-                if (management) {
-                    if (simulate()) {
-                        tp->first->markForHarvest(true);
-                        mStand->addScheduledHarvest(tp->first->volume());
-                    } else {
-                        tp->first->markForHarvest(true);
-                        tp->first->remove(removeFoliage(), removeBranch(), removeStem()); // management with removal fractions
-                    }
-                } else {
-                    if (simulate()) {
-                        tp->first->markForCut(true);
-                        tp->first->setDeathCutdown();
-                        mStand->addScheduledHarvest(tp->first->volume());
-                    } else {
-                        tp->first->markForCut(true);
-                        tp->first->setDeathCutdown();
-                        tp->first->remove(); // kill
-                    }
-                }
+                remove_tree(tp->first, management);
                 // remove from tree list
                 *tp = empty_tree;
                 n++;
@@ -489,6 +542,49 @@ int FMTreeList::remove_trees(QString expression, double fraction, bool managemen
 
 }
 
+/// remove a single tree from the system (or mark the tree for removal in simulation mode)
+void FMTreeList::remove_tree(Tree *tree, bool management)
+{
+    if (management) {
+        tree->markForHarvest(true);
+        if (simulate())
+            mStand->addScheduledHarvest(tree->volume());
+        else
+            tree->remove(removeFoliage(), removeBranch(), removeStem()); // management with removal fractions
+    } else {
+        tree->markForCut(true);
+        tree->setDeathCutdown();
+        if (simulate())
+            mStand->addScheduledHarvest(tree->volume());
+        else
+            tree->remove(); // kill
+    }
+}
+
+/** remove all trees with a true value in 'mask' and reduce the list.
+  */
+int FMTreeList::remove_trees_mask(const QJSValue &mask, bool management)
+{
+    int n = 0;
+    try {
+        QVector<bool> m = ScriptTreeColumns::mask(ForestManagementEngine::scriptEngine(), mask, mTrees.count());
+        int j = 0;
+        for (int i=0;i<mTrees.count();++i) {
+            // trees marked as "NoHarvest" are skipped
+            if (m[i] && !mTrees[i].first->isMarkedNoHarvest()) {
+                remove_tree(mTrees[i].first, management);
+                ++n;
+            } else {
+                mTrees[j++] = mTrees[i];
+            }
+        }
+        mTrees.resize(j);
+    } catch(const IException &e) {
+        qCWarning(abe) << "treelist: remove trees (mask):" << e.message();
+    }
+    return n;
+}
+
 double FMTreeList::aggregate_function(QString expression, QString filter, QString type)
 {
     QVector<QPair<Tree*, double> >::iterator tp=mTrees.begin();
@@ -106,6 +106,20 @@ public slots:
     /// return a copy of a tree
     QJSValue treeObject(int index);
 
+    // column-wise access (typed arrays, see ScriptTreeColumns)
+    /// return the attribute 'name' (e.g. 'dbh', 'height', 'species', 'x', 'y', 'age', 'flags') of all trees in the list as a typed array
+    QJSValue column(QString name);
+    /// return an object with a typed array for each attribute in 'names'
+    QJSValue columns(QStringList names);
+    /// keep only trees with a true value in 'mask' (typed array or array with one value per tree), return the number of remaining trees
+    int filterMask(QJSValue mask);
+    /// kill (i.e., cut down) trees with a true value in 'mask', return the number of removed trees
+    int killMask(QJSValue mask);
+    /// harvest trees with a true value in 'mask', return the number of removed trees
+    int harvestMask(QJSValue mask);
+    /// set (or clear) the mark 'mark' ('cut', 'harvest', 'crop', 'competitor') for trees with a true value in 'mask', return the number of trees
+    int markMask(QJSValue mask, QString mark, bool value=true);
+
 
     /** kill "number" of stems
      *  in the percentile interval "from" - "to".
@@ -174,6 +188,8 @@ private:
     ///
     int remove_percentiles(int pctfrom, int pctto, int number, bool management);
     int remove_trees(QString expression, double fraction, bool management);
+    int remove_trees_mask(const QJSValue &mask, bool management);
+    void remove_tree(Tree *tree, bool management);
     double aggregate_function(QString expression, QString filter, QString type);
     double aggregate_function_sapling(QString expression, QString filter, QString type);
     bool remove_single_tree(int index, bool harvest=true);
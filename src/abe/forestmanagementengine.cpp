@@ -733,6 +733,10 @@ void ForestManagementEngine::run(int debug_year)
         qCDebug(abe) << "ForestManagementEngine: ABE is currently disabled.";
     }
 
+    // trees grow (and die) after management: the stand statistics are re-built in the next year
+    foreach (FMStand *stand, mStands)
+        stand->endIncrementalUpdates();
+
 
 
 
@@ -869,6 +873,35 @@ FMSTP *ForestManagementEngine::stp(QString stp_name) const
     return nullptr;
 }
 
+QByteArray ForestManagementEngine::saveState() const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << static_cast<int>(mStands.size());
+    for (const FMStand *stand : mStands) {
+        out << stand->id();
+        stand->saveState(out);
+    }
+    return data;
+}
+
+void ForestManagementEngine::restoreState(const QByteArray &data)
+{
+    QDataStream in(data);
+    int n_stands, stand_id, n_restored=0;
+    in >> n_stands;
+    for (int i=0;i<n_stands;++i) {
+        in >> stand_id;
+        FMStand *fms = stand(stand_id);
+        if (!fms)
+            throw IException(QString("ABE: restore state: stand %1 is not available in the current landscape.").arg(stand_id));
+        fms->restoreState(in);
+        fms->reload(true);
+        ++n_restored;
+    }
+    qCDebug(abe) << "restored the state of" << n_restored << "stands.";
+}
+
 FMStand *ForestManagementEngine::stand(int stand_id) const
 {
     if (mStandHash.contains(stand_id))
@@ -20,6 +20,7 @@
 #define FORESTMANAGEMENTENGINE_H
 #include <QMultiMap>
 #include <QVector>
+#include <QByteArray>
 #include <QJSValue>
 
 #include "abegrid.h"
@@ -98,6 +99,10 @@ public:
     QVariantList standIds() const;
 
     FMStand *standAt(QPointF coord) const { return mFMStandGrid.constValueAt(coord); }
+
+    // checkpoints
+    QByteArray saveState() const; ///< save the management state of all stands
+    void restoreState(const QByteArray &data); ///< restore the state of stands (see saveState())
     // functions
 
     void addRepeatJS(int stand_id, QJSValue obj, QJSValue callback, int repeatInterval=1, int repeatTimes=-1);
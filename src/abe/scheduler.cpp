@@ -30,6 +30,7 @@
 
 #include "mapgrid.h"
 #include "expression.h"
+#include "logqueue.h"
 
 namespace ABE {
 
@@ -65,6 +66,7 @@ void Scheduler::addTicket(FMStand *stand, ActivityFlags *flags, double prob_sche
     item->forbiddenTo = 0;
     item->calculate(); // set score
     mItems.push_back(item);
+    mStandItems.insert(stand->id(), item);
 }
 
 int Scheduler::clearItemsOfStand(const FMStand *stand)
@@ -74,10 +76,14 @@ int Scheduler::clearItemsOfStand(const FMStand *stand)
     QList<SchedulerItem*>::iterator it = mItems.begin();
     while (it!=mItems.end()) {
         if ((*it)->stand == stand) {
+            SchedulerItem *item = *it;
+            unqueue(item);
+            mStandItems.remove(item->stand->id(), item);
             it = mItems.erase(it);
             ++n;
+        } else {
+            ++it;
         }
-        ++it;
     }
     return n;
 }
@@ -98,6 +104,11 @@ void Scheduler::run()
 
     int current_year = ForestManagementEngine::instance()->currentYear();
 
+    // the position in the list (i.e. the ranking of the last year) breaks ties between items with
+    // the same year and score. Relabeling keeps the order of the queue intact.
+    for (int i=0;i<mItems.size();++i)
+        mItems[i]->rank = i;
+
     // update the schedule probabilities....
     QList<SchedulerItem*>::iterator it = mItems.begin();
     while (it!=mItems.end()) {
@@ -110,8 +121,11 @@ void Scheduler::run()
           p_sched = item->flags->activity()->scheduleProbability(item->stand);
         }
 
+        double score = item->scoreFor(p_sched);
+        if (score != item->score)
+            unqueue(item); // the position in the ranking changes
         item->scheduleScore = p_sched;
-        item->calculate();
+        item->score = score;
         if (item->stand->trace())
             qCDebug(abe) << item->stand->context() << "scheduler scores (harvest schedule total): " << item->harvestScore << item->scheduleScore << item->score;
 
@@ -125,7 +139,7 @@ void Scheduler::run()
 
             item->stand->afterExecution(true); // execution canceled
             it = mItems.erase(it);
-            delete item;
+            deleteItem(item);
         } else {
 
             // handle item
@@ -137,10 +151,19 @@ void Scheduler::run()
     if (mUnit->agent()->schedulerOptions().useScheduler)
         updateCurrentPlan();
 
-    // sort the probabilities (sort by scheduled year, then by score)
-    //qSort(mItems);
-    //qSort(mItems.begin(), mItems.end(), )
-    std::sort(mItems.begin(), mItems.end(), ItemComparator());
+    // sort the probabilities (sort by scheduled year, then by score):
+    // only new items and items with a changed year or score are (re-)inserted into the ranked queue,
+    // the order of the queue is the same as a stable sort of the list.
+    for (it=mItems.begin(); it!=mItems.end(); ++it)
+        if (!(*it)->inQueue) {
+            mQueue.insert(*it);
+            (*it)->inQueue = true;
+        }
+    mItems.clear();
+    mItems.reserve(static_cast<int>(mQueue.size()));
+    for (std::set<SchedulerItem*, ItemComparator>::const_iterator qit=mQueue.cbegin(); qit!=mQueue.cend(); ++qit)
+        mItems.push_back(*qit);
+
     if (FMSTP::verbose())
         dump();
 
@@ -221,6 +244,7 @@ void Scheduler::run()
                              << "cum.realized total:" << total_final_harvested+total_thinning_harvested;
             harvest_scheduled += item->harvest;
 
+            LogContext log_context(LogContext::resourceUnit(), item->stand->id());
             bool executed = item->flags->activity()->execute(item->stand);
             item->stand->setLastExecution( item->stand->currentActivityIndex() );
             if (final_harvest)
@@ -242,9 +266,11 @@ void Scheduler::run()
                 // simple rule: do not allow harvests for neighboring stands for 7 years
                 item->forbiddenTo = current_year + 7;
                 QList<int> neighbors = ForestManagementEngine::instance()->standGrid()->neighborsOf(item->stand->id());
-                for (QList<SchedulerItem*>::iterator nit = mItems.begin(); nit!=mItems.end(); ++nit)
-                    if (neighbors.contains((*nit)->stand->id()))
-                        (*nit)->forbiddenTo = current_year + 7;
+                foreach (int neighbor_id, neighbors) {
+                    QMultiHash<int, SchedulerItem*>::iterator nit = mStandItems.find(neighbor_id);
+                    for (; nit!=mStandItems.end() && nit.key()==neighbor_id; ++nit)
+                        nit.value()->forbiddenTo = current_year + 7;
+                }
 
             }
 
@@ -256,7 +282,7 @@ void Scheduler::run()
             if (item->stand->trace())
                 qCDebug(abe) << item->stand->context() << "removing activity" << item->flags->activity()->name() << "from scheduler.";
             it = mItems.erase(it);
-            delete item;
+            deleteItem(item);
 
         } else {
             ++it;
@@ -459,7 +485,10 @@ void Scheduler::updateCurrentPlan()
 
     // write back the execution plan....
     for (QMultiHash<int, SchedulerItem*>::iterator it=mSchedule.begin(); it!=mSchedule.end(); ++it)
-        it.value()->scheduledYear = it.key();
+        if (it.value()->scheduledYear != it.key()) {
+            unqueue(it.value()); // the position in the ranking changes
+            it.value()->scheduledYear = it.key();
+        }
 
     if (FMSTP::verbose()) {
         QString dump_string = "ABE Final Plan:";
@@ -494,6 +523,13 @@ void Scheduler::dump() const
     }
 }
 
+void Scheduler::deleteItem(Scheduler::SchedulerItem *item)
+{
+    unqueue(item);
+    mStandItems.remove(item->stand->id(), item);
+    delete item;
+}
+
 Scheduler::SchedulerItem *Scheduler::item(const int stand_id) const
 {
     for (QList<SchedulerItem*>::const_iterator nit = mItems.constBegin(); nit!=mItems.constEnd(); ++nit)
@@ -515,15 +551,17 @@ bool Scheduler::SchedulerItem::operator<(const Scheduler::SchedulerItem &item)
         return this->scheduledYear < item.scheduledYear;
 }
 
-void Scheduler::SchedulerItem::calculate()
+double Scheduler::SchedulerItem::scoreFor(const double schedule_score) const
 {
+    double result;
     if (flags->isExecuteImmediate())
-        score = 1.1; // above 1
+        result = 1.1; // above 1
     else
-        score = scheduleScore * harvestScore;
+        result = schedule_score * harvestScore;
 
-    if (score<0.)
-        score = 0.;
+    if (result<0.)
+        result = 0.;
+    return result;
 }
 
 
@@ -577,6 +615,8 @@ bool Scheduler::ItemComparator::operator()(const Scheduler::SchedulerItem *lx, c
         //    // if both items have a high score, then put large stands in front
         //    return lx->harvest > rx->harvest;
         //else
+        if (lx->score == rx->score)
+            return lx->rank < rx->rank; // keep the order of the previous year
         return lx->score > rx->score;
     } else {
         // earlier years first
@@ -21,6 +21,7 @@
 #define SCHEDULER_H
 #include <QList>
 #include <QHash>
+#include <set>
 
 #include "activity.h"
 class Expression;
@@ -109,9 +110,10 @@ private:
     void updateCurrentPlan();
     class SchedulerItem {
     public:
-        SchedulerItem(): stand(nullptr), score(0.), scheduledYear(-1) {}
+        SchedulerItem(): stand(nullptr), score(0.), scheduledYear(-1), rank(0), inQueue(false) {}
         bool operator<(const SchedulerItem &item);
-        void calculate(); ///< calculate the final score
+        void calculate() { score = scoreFor(scheduleScore); } ///< calculate the final score
+        double scoreFor(const double schedule_score) const; ///< the final score for a given schedule probability
         FMStand *stand; ///< the stand to be harvested
         double harvest; ///< the scheduled harvest in m3
         double harvestPerHa; ///< harvest per ha
@@ -124,12 +126,21 @@ private:
         int scheduledYear; ///< planned execution year
         int forbiddenTo; ///< year until which the harvest operation is forbidden
         ActivityFlags *flags; ///< the details of the activity/stand context
+        int rank; ///< position in the ranking of the previous year (tie-breaker for equal year and score)
+        bool inQueue; ///< true if the item is part of the ranked queue (mQueue)
     };
+    /// sort order: scheduled year, score (descending), rank of the previous year
     struct ItemComparator
     {
         bool operator()( const SchedulerItem *lx, const SchedulerItem *rx ) const;
     };
-    QList<SchedulerItem*> mItems; ///< the list of active tickets
+    /// remove 'item' from the ranked queue (required before changing year or score)
+    void unqueue(SchedulerItem *item) { if (item->inQueue) { mQueue.erase(item); item->inQueue=false; } }
+    /// remove 'item' from all indices and free the memory
+    void deleteItem(SchedulerItem *item);
+    QList<SchedulerItem*> mItems; ///< the list of active tickets (ranked order of the last run, followed by new tickets)
+    std::set<SchedulerItem*, ItemComparator> mQueue; ///< ranked index of the tickets; only items with a changed year or score are re-inserted
+    QMultiHash<int, SchedulerItem*> mStandItems; ///< tickets by stand id
     QMultiHash<int, SchedulerItem*> mSchedule;
     /// find scheduler item for 'stand_id' or return NULL.
     SchedulerItem* item(const int stand_id) const;
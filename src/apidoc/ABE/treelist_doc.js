@@ -386,6 +386,83 @@ See also: {{#crossLink "TreeList/tree:method"}}{{/crossLink}}
 
 **/
 
+/**
+`column(name)` returns the attribute `name` of all trees in the list as a typed array (one element per tree, in the
+order of the list). This is much faster than accessing trees individually with {{#crossLink "TreeList/tree:method"}}{{/crossLink}}.
+The available columns are: `dbh` (cm), `height` (m), `x`, `y` (m), `species` (index of the species), `age` (years), `flags`,
+`id`, `ru` (index of the resource unit), `leafArea` (m2), `basalArea` (m2), `volume` (m3), `lri` and `stressIndex`. Integer columns
+(species, age, flags, id, ru) are returned as `Int32Array`, all others as `Float32Array`. The arrays are a copy (snapshot) of the
+current state of the trees.
+
+@method column
+@param {string} name the name of the attribute (see above)
+@return {TypedArray} a `Float32Array` or `Int32Array` with the values
+@Example
+    stand.trees.loadAll();
+    var h = stand.trees.column('height');
+    var hmax=0;
+    for (var i=0;i<h.length;++i) hmax = Math.max(hmax, h[i]);
+
+**/
+
+/**
+`columns(names)` returns an object with one typed array (see {{#crossLink "TreeList/column:method"}}{{/crossLink}}) for each element in `names`.
+
+@method columns
+@param {array} names list of attribute names
+@return {object} object with a property for each name
+
+**/
+
+/**
+`filterMask(mask)` keeps only those trees in the list for which the corresponding element in `mask` is true (non-zero). `mask` is
+a typed array (e.g. `Uint8Array`) or an array with one element per tree in the list.
+
+@method filterMask
+@param {TypedArray} mask one value per tree
+@return {integer} the number of trees remaining in the list
+
+**/
+
+/**
+`killMask(mask)` kills (cuts down) all trees for which the corresponding element in `mask` is true (see {{#crossLink "TreeList/kill:method"}}{{/crossLink}}).
+Trees marked as 'no harvest' are not affected. The removed trees are removed from the list.
+
+@method killMask
+@param {TypedArray} mask one value per tree
+@return {integer} the number of removed trees
+
+**/
+
+/**
+`harvestMask(mask)` harvests all trees for which the corresponding element in `mask` is true (see {{#crossLink "TreeList/harvest:method"}}{{/crossLink}}).
+Trees marked as 'no harvest' are not affected. The removed trees are removed from the list.
+
+@method harvestMask
+@param {TypedArray} mask one value per tree
+@return {integer} the number of removed trees
+@Example
+    stand.trees.loadAll();
+    var c = stand.trees.columns(['dbh', 'x', 'y']);
+    var mask = new Uint8Array(c.dbh.length);
+    for (var i=0;i<mask.length;++i)
+        mask[i] = c.dbh[i] > 50 && c.x[i] < 1000;
+    stand.trees.harvestMask(mask);
+
+**/
+
+/**
+`markMask(mask, mark, value)` sets (or clears, if `value` is false) the mark `mark` for all trees for which the corresponding element in `mask` is true.
+Valid marks are 'cut', 'harvest', 'crop' (crop trees), and 'competitor' (competitors of crop trees).
+
+@method markMask
+@param {TypedArray} mask one value per tree
+@param {string} mark the mark to set ('cut', 'harvest', 'crop', 'competitor')
+@param {bool} value set (true, default) or clear (false) the mark
+@return {integer} the number of affected trees
+
+**/
+
 /**
 Set a given `flag` for all trees in the list to `value`. Note that not all possible flags are allowed to be changed.
 Trying to alter such a flag yields an exception.
@@ -323,6 +323,26 @@ See also: {{#crossLink "Globals/saveModelSnapshot:method"}}{{/crossLink}}
 @return {boolean} true on succes.
 */
 
+/**
+runs a spin-up of the soil pools (ICBM/2N) to equilibrium. Instead of simulating hundreds of years with the full model, the
+soil inputs (litter and deadwood, and the climate factor 're') recorded during a simulation are cycled through the soil model only.
+Recording requires the setting `model.settings.soil.recordInputs`. The spin-up starts from the analytical steady state for the average inputs
+and cycles the recorded years until the relative change of total soil carbon per cycle is below `tolerance`. The calculation runs in parallel for all resource units.
+Snag pools are not affected.
+
+The resulting pools replace the current state of the soil; they can be saved as a snapshot ({{#crossLink "Globals/saveModelSnapshot:method"}}{{/crossLink}}),
+or (if `file_name` is provided) as a table in the format of the environment file (columns `id`, `model.site.youngLabileC`, ...).
+
+    // run the model for 50 years with 'recordInputs' enabled, then:
+    Globals.soilSpinup(200, 0.0001, 'temp/soil_equilibrium.csv');
+
+@method soilSpinup
+@param max_cycles {integer} maximum number of cycles through the recorded inputs (default: 100)
+@param tolerance {double} relative change of total soil carbon per cycle that is considered as equilibrium (default: 0.0001)
+@param file_name {string} (optional) file name of the table with the resulting pools (relative to the home directory)
+@return {integer} the number of resource units that reached the equilibrium.
+*/
+
 /**
   `viewOptions` allow some control over the visualization of the landscape in the iLand GUI. The `viewOptions` is an object with the following elements:
 
@@ -427,6 +427,74 @@ See also: {{#crossLink "TreeList/tree:method"}}{{/crossLink}}
 
 **/
 
+/**
+`column(name)` returns the attribute `name` of all trees in the list as a typed array (one element per tree, in the
+order of the list). This is much faster than accessing trees individually with {{#crossLink "Management/tree:method"}}{{/crossLink}}.
+The available columns are: `dbh` (cm), `height` (m), `x`, `y` (m), `species` (index of the species), `age` (years), `flags`,
+`id`, `ru` (index of the resource unit), `leafArea` (m2), `basalArea` (m2), `volume` (m3), `lri` and `stressIndex`. Integer columns
+(species, age, flags, id, ru) are returned as `Int32Array`, all others as `Float32Array`. The arrays are a copy (snapshot) of the
+current state of the trees.
+
+@method column
+@param {string} name the name of the attribute (see above)
+@return {TypedArray} a `Float32Array` or `Int32Array` with the values
+@Example
+    management.loadAll();
+    var dbh = management.column('dbh');
+    var sum=0;
+    for (var i=0;i<dbh.length;++i) sum += dbh[i];
+
+**/
+
+/**
+`columns(names)` returns an object with one typed array (see {{#crossLink "Management/column:method"}}{{/crossLink}}) for each element in `names`.
+
+@method columns
+@param {array} names list of attribute names
+@return {object} object with a property for each name
+@Example
+    var c = management.columns(['dbh', 'height']);
+    console.log(c.height[0] / c.dbh[0] * 100); // h/d ratio of the first tree
+
+**/
+
+/**
+`filterMask(mask)` keeps only those trees in the list for which the corresponding element in `mask` is true (non-zero). `mask` is
+a typed array (e.g. `Uint8Array`) or an array with one element per tree in the list.
+
+@method filterMask
+@param {TypedArray} mask one value per tree
+@return {integer} the number of trees remaining in the list
+
+**/
+
+/**
+`killMask(mask)` kills all trees for which the corresponding element in `mask` is true (non-zero), see {{#crossLink "Management/filterMask:method"}}{{/crossLink}}.
+The killed trees are removed from the list.
+
+@method killMask
+@param {TypedArray} mask one value per tree
+@return {integer} the number of killed trees
+@Example
+    management.loadAll();
+    var c = management.columns(['dbh', 'species']);
+    var mask = new Uint8Array(c.dbh.length);
+    for (var i=0;i<mask.length;++i)
+        mask[i] = c.dbh[i] > 40 && c.species[i] == 2;
+    management.killMask(mask);
+
+**/
+
+/**
+`manageMask(mask)` removes all trees for which the corresponding element in `mask` is true (non-zero) using the removal fractions (see
+{{#crossLink "Management/manage:method"}}{{/crossLink}}). The removed trees are removed from the list.
+
+@method manageMask
+@param {TypedArray} mask one value per tree
+@return {integer} the number of removed trees
+
+**/
+
 
 
 
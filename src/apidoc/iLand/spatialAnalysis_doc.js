@@ -77,7 +77,12 @@ See also: {{#crossLink "SpatialAnalysis/rumpleIndex:property"}}{{/crossLink}}
 Perform a patch analysis on the input `grid` and return a {{#crossLink "Grid"}}{{/crossLink}} with unique patch IDs
 assigned to each patch (starting with 1, 2, 3, ...). A 'patch' is a number of adjacent pixels with a value > 0. In other words,
 all connected non-zero areas are flagged with unique Ids in the output grid.
-Internally, a simple flood-fill algorithm searching in the Moore-neighborhood (8 neighbors) is used and applied repeatedly.
+By default, pixels are adjacent in the Moore-neighborhood (8 neighbors); with `connectivity`=4 only the 4 direct neighbors are considered.
+Internally, a parallel union-find algorithm is used; patch IDs are numbered in the order of the first pixel of each patch (from the lower left).
+
+The function returns an object with the properties `grid` (the patch grid), `areas` (the number of pixels per patch, see
+{{#crossLink "SpatialAnalysis/patchsizes:property"}}{{/crossLink}}) and `patches`, a list of objects with statistics per patch:
+`id`, `size` (pixels), the bounding box (`xmin`, `ymin`, `xmax`, `ymax`; cell indices), and the centroid (`x`, `y`; metric coordinates).
 
 If a patch has a size which is smaller than `min_size`, the cells of the grid are set to 0, and the patch is not recorded. A list of all
 patches (and patchsizes) is available with the {{#crossLink "SpatialAnalysis/patchsizes:property"}}{{/crossLink}} property.
@@ -88,6 +93,7 @@ See also: {{#crossLink "SpatialAnalysis/patchsizes:property"}}{{/crossLink}}
 @method patches
 @param {Grid} grid grid to analyze
 @param {integer} min_size ignore patches with an area below `min_size` pixels.
+@param {integer} connectivity 8 (default) or 4 neighbors.
 */
 /**
 The `patchsizes` property provides a list of with the number of pixels of each extracted patch in a prior call to  See also: {{#crossLink "SpatialAnalysis/patches:method"}}{{/crossLink}}.
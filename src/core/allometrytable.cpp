@@ -0,0 +1,84 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#include "global.h"
+#include "allometrytable.h"
+
+#include <limits>
+
+bool AllometryTable::mEnabled = false;
+bool AllometryTable::mValidation = false;
+
+void AllometryTable::setupMode(const bool enabled, const bool validation)
+{
+    mEnabled = enabled;
+    // the validation compares with the direct calculation; it requires the tables
+    mValidation = validation && enabled;
+    if (mEnabled)
+        qDebug() << "allometries: using lookup tables" << (mValidation ? "(validation mode)" : "");
+}
+
+void AllometryTable::setup(const double a, const double b)
+{
+    mA = a;
+    mB = b;
+    mCoef.resize(4 * (cMaxExponent - cMinExponent) * cSegments);
+    mErrorBound = 0.;
+    // |f''''(x)| = |a*b*(b-1)*(b-2)*(b-3)| * x^(b-4)
+    const double d4 = fabs(a * b * (b-1.) * (b-2.) * (b-3.));
+    int i = 0;
+    for (int k=cMinExponent; k<cMaxExponent; ++k) {
+        const double h = ldexp(1., k) / cSegments; // width of the segments in the octave
+        for (int s=0; s<cSegments; ++s, i+=4) {
+            const double x0 = ldexp(1., k) + s * h;
+            const double x1 = x0 + h;
+            // cubic Hermite polynomial in t (0..1), with the derivatives scaled to the segment width
+            const double f0 = exact(x0), f1 = exact(x1);
+            const double d0 = h * a * b * pow(x0, b-1.);
+            const double d1 = h * a * b * pow(x1, b-1.);
+            mCoef[i] = f0;
+            mCoef[i+1] = d0;
+            mCoef[i+2] = 3.*(f1 - f0) - 2.*d0 - d1;
+            mCoef[i+3] = 2.*(f0 - f1) + d0 + d1;
+
+            // error bound of the segment: both the derivative and f are monotonic, i.e. the extremes are at the ends of the segment
+            const double max_d4 = d4 * qMax(pow(x0, b-4.), pow(x1, b-4.));
+            const double min_f = qMin(fabs(f0), fabs(f1));
+            if (min_f == 0.) {
+                mErrorBound = std::numeric_limits<double>::max();
+                continue;
+            }
+            const double bound = h*h*h*h / 384. * max_d4 / min_f;
+            mErrorBound = qMax(mErrorBound, bound);
+        }
+    }
+    // add a margin for the rounding errors of the polynomial evaluation
+    mErrorBound += 1e-14;
+    mValid = mErrorBound < cTolerance;
+    if (!mValid)
+        qDebug() << "AllometryTable: error bound" << mErrorBound << "for a=" << a << ", b=" << b << "is too large, the lookup table is not used.";
+}
+
+double AllometryTable::validate(const double x, const double table_value) const
+{
+    const double exact_value = exact(x);
+    if (fabs(table_value - exact_value) > mErrorBound * fabs(exact_value))
+        qWarning() << "AllometryTable: validation: x=" << x << "a=" << mA << "b=" << mB << ": table" << table_value << "exact" << exact_value
+                   << "(relative error" << fabs(table_value - exact_value) / fabs(exact_value) << ", bound" << mErrorBound << ")";
+    return table_value;
+}
@@ -0,0 +1,83 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#ifndef ALLOMETRYTABLE_H
+#define ALLOMETRYTABLE_H
+
+#include <QVector>
+#include <cmath>
+
+/** @class AllometryTable is a lookup table for a power function y = a * x^b (the biomass allometries of the species).
+  @ingroup core
+  The range of x (0.125..1024, i.e. dbh in cm) is split into octaves (2^k..2^(k+1)) with 16 segments each; on each
+  segment, the function is approximated by a cubic Hermite polynomial. The segment is found with frexp() (no transcendental
+  function is called), and the polynomial is evaluated with 3 multiplications.
+  The relative error of the table is bounded analytically (error of the Hermite interpolation: h^4/384 * max|f''''|);
+  if the bound exceeds the tolerance (1e-6), the table is not used and the value is calculated directly.
+  Tables are used only if enabled (system.settings.allometryTables); in validation mode (system.settings.allometryValidation)
+  each value is additionally calculated directly, and values that violate the error bound are written to the log.
+  */
+class AllometryTable
+{
+public:
+    AllometryTable(): mA(0.), mB(0.), mErrorBound(0.), mValid(false) {}
+    /// build the table for y = a * x^b
+    void setup(const double a, const double b);
+    /// the value a*x^b: from the table (if enabled), otherwise calculated directly
+    inline double value(const double x) const;
+    double exact(const double x) const { return mA * pow(x, mB); } ///< the value a*x^b (calculated directly)
+    double errorBound() const { return mErrorBound; } ///< upper bound of the relative error of the table
+    bool isValid() const { return mValid; } ///< true if the error bound of the table is below the tolerance
+
+    /// setup from the project file
+    static void setupMode(const bool enabled, const bool validation);
+    static bool enabled() { return mEnabled; }
+    static bool validationMode() { return mValidation; }
+private:
+    double validate(const double x, const double table_value) const; ///< compare with the exact value (validation mode)
+    static constexpr int cSegments = 16; ///< number of segments per octave
+    static constexpr int cMinExponent = -3; ///< the table starts at 2^cMinExponent
+    static constexpr int cMaxExponent = 10; ///< the table ends at 2^cMaxExponent
+    static constexpr double cMinX = 0.125; ///< 2^cMinExponent
+    static constexpr double cMaxX = 1024.; ///< 2^cMaxExponent
+    static constexpr double cTolerance = 1e-6; ///< maximum allowed relative error
+    double mA, mB; ///< parameters of the power function
+    double mErrorBound;
+    bool mValid;
+    QVector<double> mCoef; ///< coefficients of the cubic polynomials (4 per segment)
+    static bool mEnabled;
+    static bool mValidation;
+};
+
+inline double AllometryTable::value(const double x) const
+{
+    if (!mEnabled || !mValid || !(x >= cMinX && x < cMaxX))
+        return exact(x);
+    int e;
+    const double m = frexp(x, &e); // x = m * 2^e, with 0.5 <= m < 1
+    const double pos = (m * 2. - 1.) * cSegments; // position within the octave (0..cSegments)
+    const int seg = static_cast<int>(pos);
+    const double t = pos - seg;
+    const double *c = mCoef.constData() + 4 * ((e - 1 - cMinExponent) * cSegments + seg);
+    const double y = c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+    if (mValidation)
+        return validate(x, y);
+    return y;
+}
+
+#endif // ALLOMETRYTABLE_H
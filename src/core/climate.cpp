@@ -80,6 +80,7 @@ QString Sun::dump()
 Climate::Climate()
 {
     mLoadYears = 1;
+    mQueryRow = -1;
     mInvalidDay.dayOfMonth=mInvalidDay.month=mInvalidDay.year=-1;
     mBegin = mEnd = 0;
     mIsSetup = false;
@@ -190,6 +191,7 @@ void Climate::setup(bool do_log)
     mSun.setup(Model::settings().latitude);
     mCurrentYear--; // go to "-1" -> the first call to next year will go to year 0.
     sampled_years.clear();
+    mLoadHistory.clear();
 
     co2Pathway = xml.value("co2pathway", "No");
     co2Startyear = xml.valueInt("co2startYear", 1980);
@@ -320,9 +322,10 @@ void Climate::nextYear()
 
     if (!mDoRandomSampling) {
         // default behaviour: simply advance to next year, call load() if end reached
-        if (mCurrentYear >= mLoadYears-1) // need to load more data
+        if (mCurrentYear >= mLoadYears-1) { // need to load more data
+            mLoadHistory.push_back(GlobalSettings::instance()->currentYear());
             load();
-        else
+        } else
             mCurrentYear++;
     } else {
         // random sampling
@@ -348,7 +351,11 @@ void Climate::nextYear()
         if (logLevelDebug())
             qDebug() << "Climate: current year (randomized):" << mCurrentYear;
     }
+    setupCurrentYear();
+}
 
+void Climate::setupCurrentYear()
+{
     // update ambient CO2 level
     updateCO2concentration();
 
@@ -380,6 +387,60 @@ void Climate::nextYear()
         mPhenology[i].calculate();
 }
 
+/// the state consists of the relative position within the loaded data, the history of
+/// load operations (to replay the sequential reading from the database) and the random sampling state.
+void Climate::saveState(QDataStream &out) const
+{
+    out << mName << mCurrentYear << mRandomListIndex << mLoadHistory << sampled_years;
+    out << mTemperatureShift << mPrecipitationShift;
+}
+
+void Climate::restoreState(QDataStream &in)
+{
+    QString name;
+    int current_year, random_list_index;
+    QVector<int> load_history;
+    in >> name >> current_year >> random_list_index >> load_history >> sampled_years;
+    if (name != mName)
+        throw IException(QString("Climate::restoreState: climate table '%1' in checkpoint does not match '%2'.").arg(name, mName));
+
+    // replay the load operations: the climate data is read sequentially from the database
+    int year = GlobalSettings::instance()->currentYear();
+    for (int i=mLoadHistory.size(); i<load_history.size(); ++i) {
+        GlobalSettings::instance()->setCurrentYear(load_history[i]);
+        load();
+    }
+    GlobalSettings::instance()->setCurrentYear(year);
+    mLoadHistory = load_history;
+    in >> mTemperatureShift >> mPrecipitationShift;
+    mRandomListIndex = random_list_index;
+    mCurrentYear = current_year;
+    setupCurrentYear();
+}
+
+void Climate::closeQuery()
+{
+    mQueryString = mClimateQuery.lastQuery();
+    mQueryRow = mClimateQuery.at();
+    mClimateQuery.finish();
+    mClimateQuery = QSqlQuery();
+}
+
+void Climate::reopenQuery()
+{
+    mClimateQuery = QSqlQuery(GlobalSettings::instance()->dbclimate());
+    if (!mClimateQuery.exec(mQueryString))
+        throw IException(QString("Climate: error re-opening the climate table: %1\n%2").arg(mQueryString, mClimateQuery.lastError().text()));
+    // continue at the same row: after the last row, the next load() rewinds the table
+    bool ok = true;
+    if (mQueryRow == QSql::AfterLastRow)
+        ok = mClimateQuery.last();
+    else if (mQueryRow >= 0)
+        ok = mClimateQuery.seek(mQueryRow);
+    if (!ok)
+        throw IException(QString("Climate: error re-opening the climate table '%1': cannot go to row %2.").arg(mName).arg(mQueryRow));
+}
+
 void Climate::climateCalculations(const ClimateDay &lastDay)
 {
     ClimateDay *c = mStore.data();
@@ -71,6 +71,12 @@ public:
     const QString &name() const { return mName; } ///< table name of this climate
     // activity
     void nextYear();
+    // checkpoints
+    void saveState(QDataStream &out) const; ///< save the position within the climate data (e.g. for checkpoints)
+    void restoreState(QDataStream &in); ///< restore the position saved with saveState() (re-loads the climate data from the database)
+    // forked processes (see Model::closeInputs())
+    void closeQuery(); ///< release the query on the climate database (the position within the table is kept)
+    void reopenQuery(); ///< re-execute the query (on a re-opened climate database) and continue at the kept position
     // access to climate data
     const ClimateDay *dayOfYear(const int dayofyear) const { return mBegin + dayofyear;} ///< get pointer to climate structure by day of year (0-based-index)
     const ClimateDay *day(const int month, const int day) const; ///< gets pointer to climate structure of given day (0-based indices, i.e. month=11=december!)
@@ -109,11 +115,13 @@ private:
     void setupPhenology(); ///< setup of phenology groups
     void climateCalculations(const ClimateDay &lastDay); ///< more calculations done after loading of climate data
     void updateCO2concentration();
+    void setupCurrentYear(); ///< set pointers and annual aggregates for the current year (mCurrentYear)
     ClimateDay mInvalidDay;
     int mLoadYears; // count of years to load ahead
     int mCurrentYear; // current year (relative)
     int mMinYear; // lowest year in store (relative)
     int mMaxYear;  // highest year in store (relative)
+    QVector<int> mLoadHistory; ///< simulation years in which load() was invoked by nextYear()
     double mTemperatureShift; // add this to daily temp
     double mPrecipitationShift; // multiply prec with that
     ClimateDay *mBegin; // pointer to the first day of the current year
@@ -121,6 +129,8 @@ private:
     std::vector<ClimateDay> mStore; ///< storage of climate data
     QVector<int> mDayIndices; ///< store indices for month / years within store
     QSqlQuery mClimateQuery; ///< sql query for db access
+    QString mQueryString; ///< the executed query (see closeQuery())
+    int mQueryRow; ///< row of the query when it was closed (see closeQuery())
     QList<Phenology> mPhenology; ///< phenology calculations
     QVector<int> mRandomYearList; ///< for random sampling of years
     int mRandomListIndex; ///< current index of the randomYearList for random sampling
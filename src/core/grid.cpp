@@ -19,6 +19,243 @@
 #include "grid.h"
 #include "exception.h"
 
+#include <QtConcurrent/QtConcurrent>
+#include <QCryptographicHash>
+#include <QSaveFile>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+/***************************************************************************/
+/************************  GridStorage  ************************************/
+/***************************************************************************/
+QString GridStorage::mSpillPath;
+qint64 GridStorage::mMinBytes = 0;
+#ifdef Q_OS_UNIX
+static QMutex grid_storage_mutex;
+static QHash<void*, int> grid_storage_files; // file descriptors of file backed grids
+#endif
+
+void GridStorage::setup(const QString &spill_path, const qint64 min_bytes)
+{
+#ifdef Q_OS_UNIX
+    mSpillPath = spill_path;
+    mMinBytes = min_bytes;
+    if (mMinBytes>0)
+        qDebug() << "GridStorage: grids >" << mMinBytes/(1024*1024) << "MB use virtual memory" << (mSpillPath.isEmpty() ? QString() : QString("backed by files in %1").arg(mSpillPath));
+#else
+    Q_UNUSED(spill_path); Q_UNUSED(min_bytes);
+    mMinBytes = 0; // only available on Unix-like systems
+#endif
+}
+
+void *GridStorage::allocate(const size_t bytes)
+{
+#ifdef Q_OS_UNIX
+    int fd = -1;
+    void *data;
+    if (!mSpillPath.isEmpty()) {
+        // create a temporary file (removed immediately, the file lives as long as the mapping)
+        QByteArray templ = QDir(mSpillPath).filePath("ilandgrid_XXXXXX").toLocal8Bit();
+        fd = mkstemp(templ.data());
+        if (fd<0)
+            throw IException(QString("GridStorage: cannot create a file in '%1'.").arg(mSpillPath));
+        unlink(templ.constData());
+        if (ftruncate(fd, off_t(bytes)) != 0) {
+            close(fd);
+            throw IException(QString("GridStorage: cannot create a file of %1 MB in '%2'.").arg(bytes/(1024*1024)).arg(mSpillPath));
+        }
+        data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    } else {
+        data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+    if (data == MAP_FAILED) {
+        if (fd>=0)
+            close(fd);
+        throw IException(QString("GridStorage: cannot allocate %1 MB.").arg(bytes/(1024*1024)));
+    }
+    if (fd>=0) {
+        QMutexLocker lock(&grid_storage_mutex);
+        grid_storage_files[data] = fd;
+    }
+    return data;
+#else
+    Q_UNUSED(bytes);
+    throw IException("GridStorage: not available.");
+#endif
+}
+
+void GridStorage::release(void *data, const size_t bytes)
+{
+#ifdef Q_OS_UNIX
+    munmap(data, bytes);
+    QMutexLocker lock(&grid_storage_mutex);
+    if (grid_storage_files.contains(data))
+        close(grid_storage_files.take(data));
+#else
+    Q_UNUSED(data); Q_UNUSED(bytes);
+#endif
+}
+
+void GridStorage::zero(void *data, const size_t bytes)
+{
+#ifdef Q_OS_UNIX
+    int fd = -1;
+    {
+        QMutexLocker lock(&grid_storage_mutex);
+        fd = grid_storage_files.value(data, -1);
+    }
+    if (fd<0) {
+        // anonymous private memory: the pages are re-created (with zeros) when accessed
+        if (madvise(data, bytes, MADV_DONTNEED)==0)
+            return;
+    }
+#if defined(Q_OS_LINUX) && defined(FALLOC_FL_PUNCH_HOLE)
+    else if (fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0, off_t(bytes))==0) {
+        return; // the file (and the mapped pages) are zero now
+    }
+#endif
+#endif
+    memset(data, 0, bytes);
+}
+
+
+/***************************************************************************/
+/************************  GridFile  ***************************************/
+/***************************************************************************/
+bool GridFile::mCacheEnabled = false;
+QString GridFile::mCachePath;
+static const char *grid_cache_magic = "iLandGridCache1";
+
+void GridFile::setupCache(const bool enabled, const QString &cache_path)
+{
+    mCacheEnabled = enabled;
+    mCachePath = cache_path;
+    if (mCacheEnabled && !mCachePath.isEmpty() && !QDir().mkpath(mCachePath))
+        throw IException(QString("GridFile: cannot create the cache directory '%1'.").arg(mCachePath));
+    if (mCacheEnabled)
+        qDebug() << "GridFile: binary cache for raster files enabled" << (mCachePath.isEmpty() ? QString("(next to the raster files)") : mCachePath);
+}
+
+QString GridFile::cacheFileName(const QString &source_file, const char *cell_type)
+{
+    QFileInfo fi(source_file);
+    QString name = QString("%1.%2.gridcache").arg(fi.fileName()).arg(cell_type);
+    if (mCachePath.isEmpty())
+        return fi.absoluteDir().filePath(name);
+    // files with the same name in different folders have different cache files
+    QByteArray path_hash = QCryptographicHash::hash(fi.absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex().left(8);
+    return QDir(mCachePath).filePath(QString::fromLatin1(path_hash) + "_" + name);
+}
+
+QByteArray GridFile::cacheKey(const QString &source_file, const char *cell_type, const QByteArray &params)
+{
+    // the key consists of the type, additional parameters, size, and modification time of the file, and a hash of
+    // the first and the last MB of the file (hashing the full file would take almost as long as loading it).
+    QFile file(source_file);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    QFileInfo fi(source_file);
+    const qint64 block = 1024*1024;
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(QByteArray(cell_type));
+    hash.addData(params);
+    hash.addData(QByteArray::number(fi.size()));
+    hash.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+    hash.addData(file.read(block));
+    if (fi.size() > block) {
+        file.seek(qMax(block, fi.size() - block));
+        hash.addData(file.read(block));
+    }
+    return hash.result();
+}
+
+bool GridFile::openCache(const QString &source_file, const char *cell_type, QRectF &rect, double &cellsize, int &size_x, int &size_y, QFile &file, const QByteArray &params)
+{
+    file.setFileName(cacheFileName(source_file, cell_type));
+    if (!file.exists() || !file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream in(&file);
+    QByteArray magic, key;
+    double x, y, w, h;
+    in >> magic >> key >> x >> y >> w >> h >> cellsize >> size_x >> size_y;
+    if (in.status() != QDataStream::Ok || magic != grid_cache_magic || key != cacheKey(source_file, cell_type, params)) {
+        qDebug() << "GridFile: cache" << file.fileName() << "is outdated.";
+        file.close();
+        return false;
+    }
+    rect = QRectF(x, y, w, h);
+    return true;
+}
+
+void GridFile::saveCache(const QString &source_file, const char *cell_type, const QRectF &rect, const double cellsize, const int size_x, const int size_y, const char *data, const qint64 bytes, const QByteArray &params)
+{
+    // the file is written to a temporary file and renamed at the end (no partially written cache files)
+    QSaveFile file(cacheFileName(source_file, cell_type));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "GridFile: cannot write the cache file" << file.fileName();
+        return;
+    }
+    QDataStream out(&file);
+    out << QByteArray(grid_cache_magic) << cacheKey(source_file, cell_type, params)
+        << rect.x() << rect.y() << rect.width() << rect.height()
+        << cellsize << size_x << size_y;
+    if (file.write(data, bytes) != bytes || !file.commit()) {
+        qWarning() << "GridFile: error writing the cache file" << file.fileName();
+        return;
+    }
+    qDebug() << "GridFile: created the cache" << file.fileName() << "for" << source_file;
+}
+
+bool GridFile::parseASCIIRows(QList<QByteArray> &lines, const int first_line, const int ncol, const int nrow, double *target)
+{
+    // find the data lines (skip empty lines)
+    QVector<int> data_lines;
+    data_lines.reserve(nrow);
+    for (int i=first_line; i<lines.count(); ++i) {
+        const QByteArray &l = lines[i];
+        for (const char *p = l.constData(); *p; ++p)
+            if (!strchr(" \r\t", *p)) {
+                data_lines.push_back(i);
+                break;
+            }
+    }
+    if (data_lines.count() != nrow)
+        return false;
+
+    // parse the rows in parallel
+    QVector<int> rows(nrow);
+    for (int i=0;i<nrow;++i)
+        rows[i]=i;
+    QAtomicInt failed(0);
+    QtConcurrent::blockingMap(rows, [&](const int row) {
+        char *p = lines[data_lines[row]].data();
+        // decimal commas are accepted
+        for (char *p2 = p; *p2; ++p2)
+            if (*p2==',')
+                *p2='.';
+        double *out = target + size_t(row)*size_t(ncol);
+        char *end;
+        for (int j=0;j<ncol;++j) {
+            out[j] = strtod(p, &end);
+            if (end==p) {
+                failed.storeRelaxed(1); // not enough values in the line
+                return;
+            }
+            p = end;
+        }
+        // there must not be additional values on the line
+        while (*p && strchr(" \r\t", *p))
+            ++p;
+        if (*p)
+            failed.storeRelaxed(1);
+    });
+    return failed.loadRelaxed() == 0;
+}
+
 
 QString gridToString(const FloatGrid &grid, const QChar sep, const int newline_after)
 {
@@ -28,11 +28,72 @@
 //#include <cstring>
 #include <string>
 #include <sstream>
+#include <type_traits>
+#include <typeinfo>
 
 #include "geotiff.h"
 #include "global.h"
 #include "helper.h"
 
+/** @class GridStorage provides memory for large grids.
+@ingroup tools
+Large grids (e.g. the 2m LIF grid of huge landscapes) are not allocated on the heap, but as virtual memory
+that the operating system provides page by page ("tiles" of 4kb) when they are first written:
+- pages that are never written (e.g. zero-valued regions of seed maps) do not consume physical memory.
+  wipe() (and initialize() with 0) releases the pages of a grid.
+- optionally, the memory is backed by a (temporary) file in a "spill" directory on a local disk. The
+  operating system then writes pages to disk under memory pressure (instead of failing to allocate).
+The contiguous memory layout (and thus the interface of Grid<T>, pointer arithmetic, GridRunner, ...) is unchanged.
+Only grids with trivial cell types and a size above a threshold use the storage (and only on Unix-like systems).
+  */
+class GridStorage
+{
+public:
+    /// setup: 'spill_path': directory for file backed grids (empty: anonymous memory), 'min_bytes': minimum size of grids using the storage (<=0: disabled)
+    static void setup(const QString &spill_path, const qint64 min_bytes);
+    /// returns true if a grid with 'bytes' bytes should use the storage
+    static bool useFor(const size_t bytes) { return mMinBytes>0 && bytes >= size_t(mMinBytes); }
+    static void *allocate(const size_t bytes); ///< allocate memory (initialized with zeros); throws an exception if this fails
+    static void release(void *data, const size_t bytes); ///< free memory created by allocate()
+    static void zero(void *data, const size_t bytes); ///< set the memory to 0 (and give the physical memory back to the system)
+    /// returns true if grids are backed by files; the (shared) mappings must not be used by forked processes
+    static bool isFileBacked() { return mMinBytes>0 && !mSpillPath.isEmpty(); }
+private:
+    static QString mSpillPath;
+    static qint64 mMinBytes;
+};
+
+/** @class GridFile contains helpers for loading raster files (ESRI ASCII grids and GeoTIFFs, see Grid::loadGridFromFile()).
+@ingroup tools
+- the data rows of ASCII grids are parsed in parallel (if each row of the grid is on a separate line).
+- optionally, a loaded grid is stored as a binary cache file ("sidecar": the name of the raster file + cell type + ".gridcache").
+  Subsequent loads of the same raster read the binary data directly. The cache is valid as long as the size,
+  the modification time and a hash of the (beginning and end of the) raster file do not change; the cache file
+  is either next to the raster file, or in a dedicated cache directory.
+  */
+class GridFile
+{
+public:
+    /// setup of the cache: 'cache_path': directory for the cache files (empty: next to the raster files)
+    static void setupCache(const bool enabled, const QString &cache_path);
+    static bool cacheEnabled() { return mCacheEnabled; }
+    /// open the cache of the raster 'source_file' for cells of type 'cell_type'. Returns false if no valid cache exists,
+    /// otherwise the grid metadata is set, and 'file' is positioned at the start of the cell data.
+    /// 'params': additional parameters the cached data depends on (e.g. the GIS transformation); the cache is valid only for the same 'params'.
+    static bool openCache(const QString &source_file, const char *cell_type, QRectF &rect, double &cellsize, int &size_x, int &size_y, QFile &file, const QByteArray &params=QByteArray());
+    /// write the cell data ('data', 'bytes') of the grid loaded from 'source_file' to the cache
+    static void saveCache(const QString &source_file, const char *cell_type, const QRectF &rect, const double cellsize, const int size_x, const int size_y, const char *data, const qint64 bytes, const QByteArray &params=QByteArray());
+    /// parse 'nrow' rows with 'ncol' values each from the data lines of an ASCII grid (starting at line 'first_line').
+    /// 'target' receives the values row by row (the first row is the northern row). Returns false if the data lines
+    /// do not match the rows of the grid (the caller uses then the (slower) generic parser).
+    static bool parseASCIIRows(QList<QByteArray> &lines, const int first_line, const int ncol, const int nrow, double *target);
+private:
+    static QString cacheFileName(const QString &source_file, const char *cell_type);
+    static QByteArray cacheKey(const QString &source_file, const char *cell_type, const QByteArray &params);
+    static bool mCacheEnabled;
+    static QString mCachePath;
+};
+
 
 /** Grid class (template).
 @ingroup tools
@@ -50,25 +111,27 @@ class Grid {
 public:
 
     Grid();
-    Grid(float cellsize, int sizex, int sizey) { mData=0; setup(cellsize, sizex, sizey); }
+    Grid(float cellsize, int sizex, int sizey) { mData=0; mAllocated=0; setup(cellsize, sizex, sizey); }
     /// create from a metric rect
-    Grid(const QRectF rect_metric, const float cellsize) { mData=0; setup(rect_metric,cellsize); }
+    Grid(const QRectF rect_metric, const float cellsize) { mData=0; mAllocated=0; setup(rect_metric,cellsize); }
     /// load a grid from an ASCII grid file
     /// the coordinates and cell size remain as in the grid file.
     bool loadGridFromFile(const QString &fileName);
     /// load a grid from an GeoTIF
     /// the coordinates and cell size remain as in the grid file.
     bool loadGridFromGeoTIFF(const QString &fileName);
+    /// load a grid from the binary cache of the raster file 'fileName' (see GridFile). Returns false if no valid cache is available.
+    bool loadGridFromCache(const QString &fileName);
 
     // copy ctor
     Grid(const Grid<T>& toCopy);
     ~Grid() { clear(); }
-    void clear() { if (mData) delete[] mData; mData=0; }
+    void clear() { freeData(); }
 
     bool setup(const float cellsize, const int sizex, const int sizey);
     bool setup(const QRectF& rect, const double cellsize);
     bool setup(const Grid<T>& source) { clear();  mRect = source.mRect; return setup(source.mRect, source.mCellsize); }
-    void initialize(const T& value) {for( T *p = begin();p!=end(); ++p) *p=value; }
+    void initialize(const T& value);
     void wipe(); ///< write 0-bytes with memcpy to the whole area
     void wipe(const T value); ///< overwrite the whole area with "value" size of T must be the size of "int" ERRORNOUS!!!
     /// copies the content of the source grid to this grid.
@@ -94,6 +157,7 @@ public:
     float cellsize() const { return mCellsize; }
     int count() const { return mCount; } ///< returns the number of elements of the grid
     bool isEmpty() const { return mData==NULL; } ///< returns false if the grid was not setup
+    bool isMapped() const { return mAllocated>0; } ///< returns true if the memory is provided by GridStorage
     // operations
     // query
     /// access (const) with index variables. use int.
@@ -192,9 +256,13 @@ public:
     /// returns the number of filled pixels
     int floodFill(QPoint start, T old_color, T color, int max_fill=-1);
 private:
+    void allocData(const int count); ///< allocate memory for 'count' elements
+    void freeData();
+    bool loadGridFromASCII(const QString &fileName); ///< load from an ESRI ASCII grid
 
     T* mData;
     T* mEnd; ///< pointer to 1 element behind the last
+    size_t mAllocated; ///< size (bytes) of memory allocated by GridStorage (0: heap memory)
     QRectF mRect;
     float mCellsize; ///< size of a cell in meter
     int mSizeX; ///< count of cells in x-direction
@@ -283,6 +351,7 @@ template <class T>
 Grid<T>::Grid(const Grid<T>& toCopy)
 {
     mData = 0;
+    mAllocated = 0;
     mRect = toCopy.mRect;
     setup(toCopy.metricRect(), toCopy.cellsize());
     //setup(toCopy.cellsize(), toCopy.sizeX(), toCopy.sizeY());
@@ -358,7 +427,7 @@ template <class T>
 Grid<T>::Grid()
 {
     mData = 0; mCellsize=0.f;
-    mEnd = 0;
+    mEnd = 0; mAllocated = 0;
     mSizeX=0; mSizeY=0; mCount=0;
 }
 
@@ -373,7 +442,7 @@ bool Grid<T>::setup(const float cellsize, const int sizex, const int sizey)
         // test if we can re-use the allocated memory.
         if (mSizeX*mSizeY > mCount || mCellsize != cellsize) {
             // we cannot re-use the memory - create new data
-            delete[] mData; mData=NULL;
+            freeData();
         }
     }
     mCellsize=cellsize;
@@ -381,11 +450,53 @@ bool Grid<T>::setup(const float cellsize, const int sizex, const int sizey)
     if (mCount<=0)
         return false;
     if (mData==NULL)
-        mData = new T[mCount];
+        allocData(mCount);
     mEnd = &(mData[mCount]);
     return true;
 }
 
+template <class T>
+void Grid<T>::allocData(const int count)
+{
+    size_t bytes = size_t(count) * sizeof(T);
+    if (std::is_trivial<T>::value && GridStorage::useFor(bytes)) {
+        mData = static_cast<T*>(GridStorage::allocate(bytes));
+        mAllocated = bytes;
+    } else {
+        mData = new T[count];
+        mAllocated = 0;
+    }
+}
+
+template <class T>
+void Grid<T>::freeData()
+{
+    if (mData) {
+        if (mAllocated>0)
+            GridStorage::release(mData, mAllocated);
+        else
+            delete[] mData;
+    }
+    mData=0; mAllocated=0;
+}
+
+template <class T>
+void Grid<T>::initialize(const T& value)
+{
+    if (mAllocated>0) {
+        // a zero value: release the memory pages instead of writing (see GridStorage)
+        const char *b = reinterpret_cast<const char*>(&value);
+        size_t i=0;
+        while (i<sizeof(T) && b[i]==0) ++i;
+        if (i==sizeof(T)) {
+            wipe();
+            return;
+        }
+    }
+    for( T *p = begin();p!=end(); ++p)
+        *p=value;
+}
+
 template <class T>
 bool Grid<T>::setup(const QRectF& rect, const double cellsize)
 {
@@ -489,7 +600,10 @@ void Grid<T>::limit(const T min_value, const T max_value)
 template <class T>
 void  Grid<T>::wipe()
 {
-    memset(mData, 0, mCount*sizeof(T));
+    if (mAllocated>0)
+        GridStorage::zero(mData, mCount*sizeof(T));
+    else
+        memset(mData, 0, mCount*sizeof(T));
 }
 template <class T>
 void  Grid<T>::wipe(const T value)
@@ -911,11 +1025,46 @@ bool gridToFile(const Grid<T> &grid, const QString &fileName, GeoTIFF::TIFDataty
 template <class T>
 bool Grid<T>::loadGridFromFile(const QString &fileName)
 {
+    bool use_cache = std::is_trivial<T>::value && GridFile::cacheEnabled();
+    if (use_cache && loadGridFromCache(fileName))
+        return true;
+
+    bool result;
+    if (fileName.endsWith(".tif", Qt::CaseInsensitive) )
+        result = loadGridFromGeoTIFF(fileName);
+    else
+        result = loadGridFromASCII(fileName);
+
+    if (result && use_cache)
+        GridFile::saveCache(fileName, typeid(T).name(), mRect, mCellsize, mSizeX, mSizeY,
+                            reinterpret_cast<const char*>(mData), qint64(mCount)*qint64(sizeof(T)));
+    return result;
+}
 
-    if (fileName.endsWith(".tif", Qt::CaseInsensitive) ) {
-        return loadGridFromGeoTIFF(fileName);
+template <class T>
+bool Grid<T>::loadGridFromCache(const QString &fileName)
+{
+    QRectF rect;
+    double cellsize;
+    int size_x, size_y;
+    QFile file;
+    if (!GridFile::openCache(fileName, typeid(T).name(), rect, cellsize, size_x, size_y, file))
+        return false;
+    setup(rect, cellsize);
+    if (mSizeX != size_x || mSizeY != size_y)
+        return false;
+    qint64 bytes = qint64(mCount)*qint64(sizeof(T));
+    if (file.read(reinterpret_cast<char*>(mData), bytes) != bytes) {
+        qWarning() << "Grid: error reading the cache of" << fileName;
+        return false;
     }
+    qDebug() << "Grid: loaded" << fileName << "from the cache" << file.fileName();
+    return true;
+}
 
+template <class T>
+bool Grid<T>::loadGridFromASCII(const QString &fileName)
+{
     // loads from a ESRI-Grid [RasterToFile] File.
     QFile file(fileName);
 
@@ -923,9 +1072,8 @@ bool Grid<T>::loadGridFromFile(const QString &fileName)
         qDebug() << "Grid::loadGridFromFile: " << fileName << "does not exist!";
         return false;
     }
-    QTextStream s(&file);
-    //s.setCodec("UTF-8");
-    QByteArray file_content=s.readAll().toLatin1();
+    // the file is read as bytes (the content is ASCII)
+    QByteArray file_content=file.readAll();
 
     if (file_content.isEmpty()) {
         qDebug() << "GISGrid: file" << fileName << "not present or empty.";
@@ -978,6 +1126,19 @@ bool Grid<T>::loadGridFromFile(const QString &fileName)
     QRectF rect(ox, oy, ncol*cellsize, nrow*cellsize);
     setup( rect, cellsize );
 
+    // fast path: one line per row, the rows are parsed in parallel
+    if (mSizeX==ncol && mSizeY==nrow) {
+        std::vector<double> values(size_t(ncol)*size_t(nrow));
+        if (GridFile::parseASCIIRows(lines, pos, ncol, nrow, values.data())) {
+            const double *v = values.data();
+            for (int i=nrow-1;i>=0;i--) {
+                T *row = ptr(0, i);
+                for (int j=0;j<ncol;++j, ++v)
+                    row[j] = *v==no_data_val ? nullValue() : T(*v);
+            }
+            return true;
+        }
+    }
 
     // loop thru datalines
     int i,j;
@@ -249,6 +249,30 @@ int Management::remove_trees(QString expression, double fraction, bool managemen
     return n;
 }
 
+int Management::remove_trees_mask(const QJSValue &mask, bool management)
+{
+    int n = 0;
+    try {
+        QVector<bool> m = ScriptTreeColumns::mask(mEngine, mask, mTrees.count());
+        QList<QPair<Tree*, double> > remaining;
+        for (int i=0;i<mTrees.count();++i) {
+            if (m[i]) {
+                if (management)
+                    mTrees[i].first->remove(removeFoliage(), removeBranch(), removeStem()); // management with removal fractions
+                else
+                    mTrees[i].first->remove(); // kill
+                n++;
+            } else {
+                remaining.push_back(mTrees[i]);
+            }
+        }
+        mTrees.swap(remaining);
+    } catch(const IException &e) {
+        ScriptGlobal::throwError(e.message());
+    }
+    return n;
+}
+
 // calculate aggregates for all trees in the internal list
 double Management::aggregate_function(QString expression, QString filter, QString type)
 {
@@ -361,6 +385,41 @@ QJSValue Management::treeObject(int index)
     return val;
 }
 
+QJSValue Management::column(QString name)
+{
+    try {
+        return ScriptTreeColumns::values(mEngine, mTrees, name);
+    } catch(const IException &e) {
+        ScriptGlobal::throwError(e.message());
+    }
+    return QJSValue();
+}
+
+QJSValue Management::columns(QStringList names)
+{
+    try {
+        return ScriptTreeColumns::values(mEngine, mTrees, names);
+    } catch(const IException &e) {
+        ScriptGlobal::throwError(e.message());
+    }
+    return QJSValue();
+}
+
+int Management::filterMask(QJSValue mask)
+{
+    try {
+        QVector<bool> m = ScriptTreeColumns::mask(mEngine, mask, mTrees.count());
+        QList<QPair<Tree*, double> > remaining;
+        for (int i=0;i<mTrees.count();++i)
+            if (m[i])
+                remaining.push_back(mTrees[i]);
+        mTrees.swap(remaining);
+    } catch(const IException &e) {
+        ScriptGlobal::throwError(e.message());
+    }
+    return mTrees.count();
+}
+
 int Management::filterIdList(QVariantList idList)
 {
     QVector<int> ids;
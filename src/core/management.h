@@ -61,6 +61,16 @@ public slots:
     QJSValue tree(int index);
     /// return a copy of a tree
     QJSValue treeObject(int index);
+    /// return the attribute 'name' (e.g. 'dbh', 'height', 'species', 'x', 'y', 'age', 'flags') of all trees in the list as a typed array
+    QJSValue column(QString name);
+    /// return an object with a typed array for each attribute in 'names'
+    QJSValue columns(QStringList names);
+    /// keep only trees with a true value in 'mask' (typed array or array with one value per tree), return the number of remaining trees
+    int filterMask(QJSValue mask);
+    /// kill trees with a true value in 'mask', return the number of removed trees
+    int killMask(QJSValue mask) { return remove_trees_mask(mask, false); }
+    /// manage (harvest) trees with a true value in 'mask' using the removal fractions, return the number of removed trees
+    int manageMask(QJSValue mask) { return remove_trees_mask(mask, true); }
 
     /// calculate the mean value for all trees in the internal list for 'expression' (filtered by the filter criterion)
     double mean(QString expression, QString filter=QString()) { return aggregate_function( expression, filter, "mean"); }
@@ -126,6 +136,7 @@ private:
     QString executeScript(QString cmd="");
     int remove_percentiles(int pctfrom, int pctto, int number, bool management);
     int remove_trees(QString expression, double fraction, bool management);
+    int remove_trees_mask(const QJSValue &mask, bool management);
     double aggregate_function(QString expression, QString filter, QString type);
 
     // removal fractions
@@ -53,6 +53,10 @@
 #include "dem.h"
 #include "grasscover.h"
 #include "svdstate.h"
+#include "checkpoint.h"
+#include "allometrytable.h"
+#include "soil.h"
+#include "logqueue.h"
 
 #include "outputmanager.h"
 
@@ -61,6 +65,7 @@
 
 #include <QtCore>
 #include <QtXml>
+#include <algorithm>
 
 /** iterate over all trees of the model. return NULL if all trees processed.
   Usage:
@@ -153,6 +158,7 @@ Model::~Model()
 void Model::initialize()
 {
    mSetup = false;
+   mSkipInactiveRU = true;
    GlobalSettings::instance()->setCurrentYear(0);
    mGrid = nullptr;
    mHeightGrid = nullptr;
@@ -163,10 +169,12 @@ void Model::initialize()
    mTimeEvents = nullptr;
    mStandGrid = nullptr;
    mModules = nullptr;
+   mCheckpoint = nullptr;
    mDEM = nullptr;
    mGrassCover = nullptr;
    mSaplings=nullptr;
    mSVDStates=nullptr;
+   mLIFBorderReady = false;
 }
 
 /** sets up the simulation space.
@@ -175,6 +183,7 @@ void Model::setupSpace()
 {
     setCurrentTask("setup landscape");
     GeoTIFF::clearProjection(); // first chance to load a tif
+    mLIFBorderReady = false; // the flags of the height grid are set up below
 
     XmlHelper xml(GlobalSettings::instance()->settings().node("model.world"));
     double cellSize = xml.value("cellSize", "2").toDouble();
@@ -405,6 +414,11 @@ void Model::setupSpace()
             GlobalSettings::instance()->controller()->addGrid(mDEM->slopeGrid(), "DEM - slope", GridViewRainbow, 0, 3);
             GlobalSettings::instance()->controller()->addGrid(mDEM->aspectGrid(), "DEM - aspect", GridViewRainbow, 0, 360);
             GlobalSettings::instance()->controller()->addGrid(mDEM->viewGrid(), "DEM - view", GridViewGray, 0, 1);
+            // precalculate the topographic position index for the given radii (m), e.g. "500,1000"
+            QStringList tpi_radii = xml.value("DEMtpiRadii").split(",");
+            foreach(const QString &radius, tpi_radii)
+                if (!radius.trimmed().isEmpty())
+                    GlobalSettings::instance()->controller()->addGrid(mDEM->tpiGrid(radius.trimmed().toFloat()), QString("DEM - TPI %1m").arg(radius.trimmed()), GridViewRainbow, -50, 50);
 
         }
 
@@ -507,6 +521,8 @@ void Model::clear()
         delete mSVDStates;
     if (mBiteEngine)
         delete  mBiteEngine;
+    if (mCheckpoint)
+        delete mCheckpoint;
 
     mGrid = nullptr;
     mHeightGrid = nullptr;
@@ -520,6 +536,7 @@ void Model::clear()
     mABEManagement = nullptr;
     mBiteEngine = nullptr;
     mSVDStates = nullptr;
+    mCheckpoint = nullptr;
 
     GlobalSettings::instance()->outputManager()->close();
 
@@ -595,6 +612,24 @@ void Model::loadProject()
 
     changeSettings().regenerationEnabled = xml.valueBool("model.settings.regenerationEnabled", false);
 
+    // memory of large grids (see GridStorage)
+    QString spill_path = xml.value("system.settings.gridStorage.spillPath");
+    if (!spill_path.isEmpty())
+        spill_path = g->path(spill_path, "temp");
+    GridStorage::setup(spill_path, qint64(xml.valueDouble("system.settings.gridStorage.minSizeMB", 0.) * 1024. * 1024.));
+    // binary cache of raster input files (see GridFile)
+    QString cache_path = xml.value("system.settings.gridCache.path");
+    if (!cache_path.isEmpty())
+        cache_path = g->path(cache_path, "temp");
+    GridFile::setupCache(xml.valueBool("system.settings.gridCache.enabled", false), cache_path);
+    // incrementally updated stand statistics (see StandStatistics::remove())
+    StandStatistics::setValidationMode(xml.valueBool("system.settings.standStatisticsValidation", false));
+    // lookup tables for the biomass allometries of the species (see AllometryTable)
+    AllometryTable::setupMode(xml.valueBool("system.settings.allometryTables", false), xml.valueBool("system.settings.allometryValidation", false));
+    // skip resource units without trees / regeneration in the per-RU phases
+    mSkipInactiveRU = xml.valueBool("system.settings.skipInactiveResourceUnits", true);
+    // record the soil inputs (for a spin-up of the soil pools, see SoilSpinup)
+    Soil::setRecordInputs(xml.valueBool("model.settings.soil.recordInputs", false));
 
     setupSpace();
     if (mRU.isEmpty())
@@ -641,6 +676,11 @@ void Model::loadProject()
         mBiteEngine->setup();
     }
 
+    // checkpoints (periodic save of the model state)
+    if (mCheckpoint)
+        delete mCheckpoint;
+    mCheckpoint = new Checkpoint();
+    mCheckpoint->setup();
 
 }
 
@@ -691,13 +731,55 @@ void Model::initOutputDatabase()
 
    // create table for run meta data
    QSqlQuery creator(g->dbout());
-   QString drop=QString("drop table if exists runinfo");
-   creator.exec(drop); // drop table (if exists)
-   creator.exec("create table runinfo (timestamp, version)");
+   if (Checkpoint::resumeMode()) {
+       // keep the data of the interrupted run (see Checkpoint)
+       creator.exec("create table if not exists runinfo (timestamp, version)");
+   } else {
+       QString drop=QString("drop table if exists runinfo");
+       creator.exec(drop); // drop table (if exists)
+       creator.exec("create table runinfo (timestamp, version)");
+   }
    SqlHelper::executeSql(QString("insert into runinfo (timestamp, version) values ('%1', '%2')").arg(timestamp).arg(verboseVersion()), g->dbout());
 
 }
 
+/** close the output database and re-create it (and all outputs) from the current settings.
+  This is required when the model state is inherited by a new process (see the branching mode of ilandc):
+  a writeable SQLite connection must not be shared between processes. The read-only connections
+  ("in", "climate") are handled by closeInputs() and reopenInputs(). */
+void Model::reopenOutputs()
+{
+    GlobalSettings *g = GlobalSettings::instance();
+    g->outputManager()->close();
+    if (g->dbout().isOpen())
+        g->dbout().close();
+
+    initOutputDatabase();
+    g->outputManager()->setup();
+}
+
+/** close the read-only database connections ("in", "climate") before the model state is inherited by a new process:
+  SQLite connections must not be carried across a fork(). The climates keep the position within the climate
+  tables, as the climate data is loaded from the database during the simulation. */
+void Model::closeInputs()
+{
+    foreach(Climate *c, mClimates)
+        c->closeQuery();
+    GlobalSettings::instance()->dbin().close();
+    GlobalSettings::instance()->dbclimate().close();
+}
+
+/// re-open the connections closed by closeInputs() (in the new process), and continue the climate queries.
+void Model::reopenInputs()
+{
+    GlobalSettings *g = GlobalSettings::instance();
+    const XmlHelper &xml = g->settings();
+    g->setupDatabaseConnection("in", g->path(xml.value("system.database.in"), "database"), true);
+    g->setupDatabaseConnection("climate", g->path(xml.value("system.database.climate"), "database"), true);
+    foreach(Climate *c, mClimates)
+        c->reopenQuery();
+}
+
 /// multithreaded run function for resource unit level establishment
 static void nc_establishment(ResourceUnit *unit)
 {
@@ -725,13 +807,33 @@ static void nc_sapling_growth(ResourceUnit *unit)
 
 
 
-/// multithreaded execution of the carbon cycle routine
-static void nc_carbonCycle(ResourceUnit *unit)
+/// multithreaded counting of the stocked pixels of the height grid
+static void nc_countStockedPixels(ResourceUnit *unit)
+{
+    unit->countStockedPixels();
+}
+
+/// multithreaded execution of the carbon cycle routine for a block of resource units
+static void nc_carbonCycle(QVector<ResourceUnit*> &block)
 {
     try {
-        // (1) do calculations on snag dynamics for the resource unit
-        unit->calculateCarbonCycle();
-        // (2) do the soil carbon and nitrogen dynamics calculations (ICBM/2N)
+        // (1) do calculations on snag dynamics for the resource units
+        QVector<Soil*> soils;
+        soils.reserve(block.size());
+        foreach(ResourceUnit *unit, block)
+            if (unit->snag()) {
+                LogContext context(unit->index());
+                unit->calculateSoilInput();
+                soils.push_back(unit->soil());
+            }
+        // (2) do the soil carbon and nitrogen dynamics calculations (ICBM/2N) for all soils of the block
+        Soil::calculateYears(soils.constData(), soils.size());
+        // (3) available nitrogen, debug outputs
+        foreach(ResourceUnit *unit, block)
+            if (unit->snag()) {
+                LogContext context(unit->index());
+                unit->finishCarbonCycle();
+            }
     } catch (const IException& e) {
         GlobalSettings::instance()->model()->threadExec().throwError(e.message());
     }
@@ -744,6 +846,16 @@ static void nc_carbonCycle(ResourceUnit *unit)
 ///             * setup of the climates
 void Model::beforeRun()
 {
+    // resume from a checkpoint: outputs append to the existing data
+    int resume_year = -1;
+    if (Checkpoint::resumeMode()) {
+        if (!mCheckpoint->isEnabled())
+            throw IException("Resume: checkpoints are not enabled (system.settings.checkpoint.enabled).");
+        resume_year = Checkpoint::checkpointYear(mCheckpoint->fileName());
+        if (resume_year < 0)
+            throw IException("Resume: no checkpoint available.");
+    }
+    Output::setResumeYear(resume_year);
     // setup outputs
     // setup output database
     if (GlobalSettings::instance()->dbout().isOpen())
@@ -807,6 +919,14 @@ void Model::beforeRun()
         mABEManagement->runOnInit(false);
     }
 
+    if (resume_year >= 0) {
+        // replace the initial state with the state of the checkpoint
+        setCurrentTask("loading checkpoint");
+        int year = mCheckpoint->restore();
+        GlobalSettings::instance()->setCurrentYear(year + 1);
+        return;
+    }
+
     setCurrentTask("outputs during startup");
     // outputs to create with inital state (without any growth) are called here:
     GlobalSettings::instance()->setCurrentYear(0); // set clock to "0" (for outputs with initial state)
@@ -891,8 +1011,8 @@ void Model::runYear()
     }
 
     // if trees are dead/removed because of management, the tree lists
-    // need to be cleaned (and the statistics need to be recreated)
-    cleanTreeLists(true); // recalculate statistics (LAIs per species needed later in production)
+    // need to be cleaned (removed trees are already subtracted from the statistics, LAIs per species are needed later in production)
+    cleanTreeLists(true); // recalculate statistics only in validation mode
 
     // process a cycle of individual growth
     setCurrentTask("apply LIP");
@@ -919,9 +1039,14 @@ void Model::runYear()
         Saplings::updateBrowsingPressure();
 
 
+        // RUs without seeds and saplings are skipped (the same set is used for establishment and sapling growth)
+        int n_active = activeResourceUnits(Saplings::isRegenerationActive, mRegenerationRU);
+        if (logLevelDebug())
+            qDebug() << "regeneration: active resource units:" << n_active << "of" << mRU.count();
+
         { DebugTimer t("establishment");
         setCurrentTask("Establishment");
-        executePerResourceUnit( nc_establishment, false /* true: force single threaded operation */);
+        threadRunner.run( nc_establishment, mRegenerationRU, false /* true: force single threaded operation */);
         GlobalSettings::instance()->systemStatistics()->tEstablishment+=t.elapsed();
         }
         { DebugTimer t("sapling growth");
@@ -933,7 +1058,7 @@ void Model::runYear()
             set->clearSaplingSeedMap();
         }
 
-        executePerResourceUnit( nc_sapling_growth, false /* true: force single threaded operation */);
+        threadRunner.run( nc_sapling_growth, mRegenerationRU, false /* true: force single threaded operation */);
         GlobalSettings::instance()->systemStatistics()->tSapling+=t.elapsed();
         }
 
@@ -954,14 +1079,31 @@ void Model::runYear()
     setCurrentTask("Disturbance modules");
     mModules->run();
     // cleanup of tree lists if external modules removed trees.
-    cleanTreeLists(false); // do not recalculate statistics - this is done in ru->yearEnd()
+    cleanTreeLists(false); // do not calculate statistics - this is done in ru->yearEnd()
 
 
     // calculate soil / snag dynamics
     if (settings().carbonCycleEnabled) {
         DebugTimer ccycle("carbon cylce");
         setCurrentTask("carbon cycle");
-        executePerResourceUnit( nc_carbonCycle, false /* true: force single threaded operation */);
+        // the resource units are processed in blocks (the soil model runs vectorized over the block);
+        // only valid resource units are included (as for executePerResourceUnit()).
+        // The block size gives several blocks per thread (at most 64 resource units per block).
+        int n_valid = 0;
+        foreach(ResourceUnit *ru, mRU)
+            if (ru->id()!=-1)
+                ++n_valid;
+        const int block_size = qBound(1, n_valid / (4 * qMax(QThread::idealThreadCount(), 1)), 64);
+        QVector<QVector<ResourceUnit*> > blocks;
+        n_valid = 0;
+        foreach(ResourceUnit *ru, mRU) {
+            if (ru->id()==-1)
+                continue;
+            if (n_valid++ % block_size == 0)
+                blocks.push_back(QVector<ResourceUnit*>());
+            blocks.last().push_back(ru);
+        }
+        threadRunner.run(nc_carbonCycle, blocks, false /* true: force single threaded operation */);
         GlobalSettings::instance()->systemStatistics()->tCarbonCycle+=ccycle.elapsed();
 
     }
@@ -1016,6 +1158,10 @@ void Model::runYear()
 
     GlobalSettings::instance()->setCurrentYear(GlobalSettings::instance()->currentYear()+1);
 
+    // write a checkpoint (if due)
+    if (mCheckpoint)
+        mCheckpoint->save();
+
     // try to clean up a bit of memory (useful if many large JS objects (e.g., grids) are used)
     GlobalSettings::instance()->scriptEngine()->collectGarbage();
 }
@@ -1027,6 +1173,9 @@ void Model::afterStop()
     // do some cleanup
 }
 
+/// resource units without trees are skipped in the tree related phases
+static bool hasTrees(const ResourceUnit *ru) { return ru->hasTrees(); }
+
 /// multithreaded running function for LIP printing
 static void nc_applyPattern(ResourceUnit *unit)
 {
@@ -1147,24 +1296,21 @@ void Model::applyPattern()
 {
 
     DebugTimer t("applyPattern()");
-    // intialize grids...
+    // intialize grids (LIF and height grid)...
     initializeGrid();
 
-    // initialize height grid with a default value of 4m. This is the height of the regeneration layer
-    for (HeightGridValue *h=mHeightGrid->begin();h!=mHeightGrid->end();++h) {
-        h->resetCount(); // set count = 0, but do not touch the flags
-        h->height = cSapHeight;
-        h->clearStemHeight();
-    }
-
-    threadRunner.run(nc_applyPattern);
+    // only RUs with trees need to be processed (for applyPattern(), readPattern() and grow())
+    int n_active = activeResourceUnits(hasTrees, mTreeRU);
+    if (logLevelDebug())
+        qDebug() << "applyPattern: resource units with trees:" << n_active << "of" << mRU.count();
+    threadRunner.run(nc_applyPattern, mTreeRU);
     GlobalSettings::instance()->systemStatistics()->tApplyPattern+=t.elapsed();
 }
 
 void Model::readPattern()
 {
     DebugTimer t("readPattern()");
-    threadRunner.run(nc_readPattern);
+    threadRunner.run(nc_readPattern, mTreeRU);
     GlobalSettings::instance()->systemStatistics()->tReadPattern+=t.elapsed();
 
 }
@@ -1188,7 +1334,14 @@ void Model::grow()
     }
 
     DebugTimer t("growTrees()");
-    threadRunner.run(nc_grow); // actual growth of individual trees
+    threadRunner.run(nc_grow, mTreeRU); // actual growth of individual trees
+    // RUs without trees: only reset the RU level values
+    foreach(ResourceUnit *ru, mRU) {
+        if (!mTreeRU[ru->index()]) {
+            ru->beforeGrow();
+            ru->calculateInterceptedArea();
+        }
+    }
 
     foreach(ResourceUnit *ru, mRU) {
        ru->cleanTreeList();
@@ -1198,25 +1351,31 @@ void Model::grow()
    GlobalSettings::instance()->systemStatistics()->tTreeGrowth+=t.elapsed();
 }
 
+int Model::activeResourceUnits(bool (*isactive)(const ResourceUnit *), QVector<bool> &rActive) const
+{
+    rActive.fill(true, mRU.count());
+    if (!mSkipInactiveRU)
+        return mRU.count();
+    int n=0;
+    foreach(const ResourceUnit *ru, mRU) {
+        rActive[ru->index()] = (*isactive)(ru);
+        if (rActive[ru->index()])
+            ++n;
+    }
+    return n;
+}
+
 /** calculate for each resource unit the fraction of area which is stocked.
   This is done by checking the pixels of the global height grid.
   */
 void Model::calculateStockedArea()
 {
-    // iterate over the whole heightgrid and count pixels for each ressource unit
-    HeightGridValue *end = mHeightGrid->end();
-    QPointF cp;
-    ResourceUnit *ru;
-    for (HeightGridValue *i=mHeightGrid->begin(); i!=end; ++i) {
-        cp = mHeightGrid->cellCenterPoint(mHeightGrid->indexOf(i));
-        if (mRUmap.coordValid(cp)) {
-            ru = mRUmap.valueAt(cp);
-            if (ru) {
-                ru->countStockedPixel( (*i).count()>0 );
-            }
-        }
-
-    }
+    // each resource unit counts the pixels of the heightgrid within its extent
+    executePerResourceUnit(nc_countStockedPixels);
+    // invalid resource units (id=-1) are not part of the thread runner
+    foreach(ResourceUnit *ru, mRU)
+        if (ru->id()==-1)
+            ru->countStockedPixels();
 }
 
 /** calculate for each resource unit the stockable area.
@@ -1282,13 +1441,12 @@ void Model::calculateStockableArea()
 
 }
 
-void Model::initializeGrid()
+/// the values of the LIF grid at the edge of the project area (see initializeGrid()).
+/// "Radiating" pixels of the height grid (pixels outside of the project area, but next to valid pixels)
+/// reduce the LIF within a distance of 7 LIF pixels. The list contains (index, value) with the minimum value per index, sorted by index.
+void Model::setupLIFBorder()
 {
-    // fill the whole grid with a value of "1."
-    mGrid->initialize(1.f);
-
-    // apply special values for grid cells border regions where out-of-area cells
-    // radiate into the main LIF grid.
+    QVector<QPair<int, float> > values;
     QPoint p;
     int ix_min, ix_max, iy_min, iy_max, ix_center, iy_center;
     const int px_offset = cPxPerHeight / 2; // for 5 px per height grid cell, the offset is 2
@@ -1309,17 +1467,73 @@ void Model::initializeGrid()
                     if (!mGrid->isIndexValid(x,y) ||  !(*mHeightGrid)(x/cPxPerHeight, y/cPxPerHeight).isValid())
                         continue;
                     float value = qMax(qAbs(x-ix_center), qAbs(y-iy_center)) * step_width;
-                    float &v = mGrid->valueAtIndex(x, y);
-                    if (value>=0.f && v>value)
-                        v = value;
+                    if (value>=0.f && value<1.f)
+                        values.push_back(QPair<int, float>(mGrid->index(x, y), value));
                 }
             }
             c_rad++;
         }
     }
+    // keep the minimum value per LIF pixel
+    std::sort(values.begin(), values.end());
+    mLIFBorder.clear();
+    for (int i=0;i<values.size();++i)
+        if (mLIFBorder.isEmpty() || mLIFBorder.last().first != values[i].first)
+            mLIFBorder.push_back(values[i]);
+    mLIFBorderReady = true;
     if (logLevelDebug())
-        qDebug() << "initialize grid:" << c_rad << "radiating pixels...";
+        qDebug() << "initialize grid:" << c_rad << "radiating pixels," << mLIFBorder.size() << "LIF pixels at the edge of the project area.";
+}
+
+/// a block of rows of the height grid and the corresponding rows of the LIF grid (see initializeGrid())
+struct GridResetBlock {
+    float *lif_begin, *lif_end;
+    HeightGridValue *height_begin, *height_end;
+    const QPair<int, float> *border_begin, *border_end; ///< precalculated LIF values within the block
+    float *lif_origin; ///< the first pixel of the LIF grid (the border values use the index of the full grid)
+};
+
+/// multithreaded reset of a block of the LIF grid and the height grid
+static void nc_resetGrids(GridResetBlock &block)
+{
+    // fill the LIF with a value of "1." and apply the values of border regions where out-of-area cells radiate into the LIF
+    std::fill(block.lif_begin, block.lif_end, 1.f);
+    for (const QPair<int, float> *p=block.border_begin; p!=block.border_end; ++p)
+        block.lif_origin[p->first] = p->second;
+
+    // initialize height grid with a default value of 4m. This is the height of the regeneration layer
+    for (HeightGridValue *h=block.height_begin; h!=block.height_end; ++h) {
+        h->resetCount(); // set count = 0, but do not touch the flags
+        h->height = cSapHeight;
+        h->clearStemHeight();
+    }
+}
 
+/// initialize the LIF grid and the height grid in one (parallel) pass over blocks of rows.
+void Model::initializeGrid()
+{
+    if (!mLIFBorderReady)
+        setupLIFBorder();
+
+    // rows of the height grid per block (one row of the height grid are 'cPxPerHeight' rows of the LIF grid)
+    const int block_rows = 16;
+    QVector<GridResetBlock> blocks;
+    const QPair<int, float> *border = mLIFBorder.constBegin();
+    for (int y=0; y<mHeightGrid->sizeY(); y+=block_rows) {
+        const int y_end = qMin(y + block_rows, mHeightGrid->sizeY());
+        GridResetBlock b;
+        b.height_begin = mHeightGrid->ptr(0, y);
+        b.height_end = y_end < mHeightGrid->sizeY() ? mHeightGrid->ptr(0, y_end) : mHeightGrid->end();
+        b.lif_begin = mGrid->begin() + qMin(y * cPxPerHeight, mGrid->sizeY()) * mGrid->sizeX();
+        b.lif_end = y_end < mHeightGrid->sizeY() ? mGrid->begin() + qMin(y_end * cPxPerHeight, mGrid->sizeY()) * mGrid->sizeX() : mGrid->end();
+        b.lif_origin = mGrid->begin();
+        b.border_begin = border;
+        while (border != mLIFBorder.constEnd() && mGrid->begin() + border->first < b.lif_end)
+            ++border;
+        b.border_end = border;
+        blocks.push_back(b);
+    }
+    threadRunner.run(nc_resetGrids, blocks);
 }
 
 
@@ -1337,10 +1551,14 @@ void Model::createStandStatistics()
 
 void Model::cleanTreeLists(bool recalculate_stats)
 {
+    // removed trees are already subtracted from the stand statistics (see Tree::die()),
+    // the statistics are re-built only in validation mode.
+    const bool validate = StandStatistics::validationMode();
     foreach(ResourceUnit *ru, GlobalSettings::instance()->model()->ruList()) {
         if (ru->hasDiedTrees()) {
             ru->cleanTreeList();
-            ru->recreateStandStatistics(recalculate_stats);
+            if (validate)
+                ru->validateStandStatistics(recalculate_stats);
         }
     }
 }
@@ -45,6 +45,7 @@ class Modules;
 class DEM;
 class GrassCover;
 class SVDStates;
+class Checkpoint;
 namespace BITE { class BiteEngine; }
 
 struct HeightGridValue
@@ -119,6 +120,7 @@ public:
     SpeciesSet *speciesSet() const { if (mSpeciesSets.count()==1) return mSpeciesSets.first(); return NULL; }
     const QList<Climate*> climates() const { return mClimates; }
     SVDStates *svdStates() const { return mSVDStates; }
+    Checkpoint *checkpoint() const { return mCheckpoint; }
 
     // global grids
     FloatGrid *grid() { return mGrid; } ///< this is the global 'LIF'-grid (light patterns) (currently 2x2m)
@@ -137,6 +139,9 @@ public:
     static ModelSettings &changeSettings() {return mSettings;} ///< write access to global model settings.
     void onlyApplyLightPattern() { applyPattern(); readPattern(); }
     void reloadABE(); ///< force a recreate of the agent based forest management engine
+    void reopenOutputs(); ///< re-create the output database and re-open all outputs (e.g. in a forked child process)
+    void closeInputs(); ///< close the input and climate databases (before the model state is inherited by a new process)
+    void reopenInputs(); ///< re-open the input and climate databases closed by closeInputs() (e.g. in a forked child process)
     QString currentTask() const { return mCurrentTask; }
     void setCurrentTask(QString what) { mCurrentTask = what; }
 
@@ -144,6 +149,7 @@ public:
     /// build stand statistics (i.e. stats based on resource units)
     void createStandStatistics();
     /// clean the tree data structures (remove harvested trees) - call after management operations.
+    /// The stand statistics are re-built only in validation mode (see StandStatistics::validationMode()).
     void cleanTreeLists(bool recalculate_stats);
     /// execute a function for each resource unit using multiple threads. "funcptr" is a ptr to a simple function
     void executePerResourceUnit(void (*funcptr)(ResourceUnit*), const bool forceSingleThreaded=false) { threadRunner.run(funcptr, forceSingleThreaded);}
@@ -158,8 +164,11 @@ private:
     void grow(); ///< grow - both on RU-level and tree-level
 
     void calculateStockedArea(); ///< calculate area stocked with trees for each RU
+    /// flag the resource units for which 'isactive' is true in 'rActive' (all RUs if skipping of inactive RUs is disabled). Returns the number of active RUs.
+    int activeResourceUnits(bool (*isactive)(const ResourceUnit*), QVector<bool> &rActive) const;
     void calculateStockableArea(); ///< calculate the stockable area for each RU (i.e.: with stand grid values <> -1)
-    void initializeGrid(); ///< initialize the LIF grid
+    void initializeGrid(); ///< initialize the LIF grid and the height grid
+    void setupLIFBorder(); ///< precalculate the values of the LIF grid at the edge of the project area
 
     void test();
     void debugCheckAllTrees();
@@ -168,6 +177,9 @@ private:
     static ModelSettings mSettings;
     QString mCurrentTask;
     bool mSetup;
+    bool mSkipInactiveRU; ///< if true, per-RU phases are executed only for active RUs (e.g., RUs with trees)
+    QVector<bool> mTreeRU; ///< flags of RUs with trees (applyPattern(), readPattern(), grow())
+    QVector<bool> mRegenerationRU; ///< flags of RUs with regeneration (establishment, sapling growth)
     /// container holding all ressource units
     QList<ResourceUnit*> mRU;
     /// grid specifying a map of ResourceUnits
@@ -184,6 +196,8 @@ private:
     // global grids...
     FloatGrid *mGrid; ///< the main LIF grid of the model (2x2m resolution)
     HeightGrid *mHeightGrid; ///< grid with 10m resolution that stores maximum-heights, tree counts and some flags
+    QVector<QPair<int, float> > mLIFBorder; ///< (index, value) of LIF pixels at the edge of the project area (sorted by index)
+    bool mLIFBorderReady; ///< true if mLIFBorder is set up
     Saplings *mSaplings;
     Management *mManagement; ///< management sub-module (simple mode)
     ABE::ForestManagementEngine *mABEManagement; ///< management sub-module (agent based management engine)
@@ -197,6 +211,8 @@ private:
     /// SVD States
     /// collection of all realized SVD states in the model
     SVDStates *mSVDStates;
+    /// periodic checkpoints of the model state
+    Checkpoint *mCheckpoint;
 };
 
 class Tree;
@@ -33,6 +33,7 @@
 #include "expression.h"
 #include "expressionwrapper.h"
 #include "../output/outputmanager.h"
+#include "../output/checkpoint.h"
 
 #include "species.h"
 #include "speciesset.h"
@@ -303,6 +304,8 @@ void ModelController::internalStop()
 {
     if (mRunning) {
         GlobalSettings::instance()->outputManager()->save();
+        if (mModel && mModel->checkpoint())
+            mModel->checkpoint()->waitForFinished(); // finish writing the last checkpoint
         DebugTimer::printAllTimers();
         saveDebugOutputs(true);
         //if (GlobalSettings::instance()->dbout().isOpen())
@@ -26,6 +26,7 @@ class WaterCycle; // forward
 struct ClimateDay; // forward
 class ResourceUnit; // forward
 class WaterOut; // forward
+class DebugList; // forward
 
 namespace Water {
 
@@ -88,6 +88,7 @@ ResourceUnit::ResourceUnit(const int index)
     mSnag = nullptr;
     mSoil = nullptr;
     mSaplings = nullptr;
+    mRegenerationIdle = false;
     mID = 0;
     mCreateDebugOutput = true;
     mSVDState.clear();
@@ -223,6 +224,15 @@ const ResourceUnitSpecies *ResourceUnit::constResourceUnitSpecies(const Species
     return mRUSpecies[species->index()];
 }
 
+/// count the pixels of the height grid within the resource unit, and the pixels that are stocked with trees.
+void ResourceUnit::countStockedPixels()
+{
+    mPixelCount = mStockedPixelCount = 0;
+    GridRunner<HeightGridValue> runner(GlobalSettings::instance()->model()->heightGrid(), boundingBox());
+    while (HeightGridValue *hgv = runner.next())
+        countStockedPixel( hgv->count()>0 );
+}
+
 double ResourceUnit::topHeight(bool &rIrregular) const
 {
     GridRunner<HeightGridValue> runner(GlobalSettings::instance()->model()->heightGrid(), boundingBox());
@@ -576,7 +586,8 @@ void ResourceUnit::createStandStatistics()
 
 /** recreate statistics. This is necessary after events that changed the structure
     of the stand *after* the growth of trees (where stand statistics are updated).
-    An example is after disturbances.  */
+    An example is after disturbances. Note that during the simulation, removed trees are subtracted
+    from the statistics (see Tree::die()), and a full re-build is only required after loading trees (e.g. snapshots). */
 void ResourceUnit::recreateStandStatistics(bool recalculate_stats)
 {
     // when called after disturbances (recalculate_stats=false), we
@@ -601,6 +612,39 @@ void ResourceUnit::recreateStandStatistics(bool recalculate_stats)
     }
 }
 
+/** compare the incrementally updated statistics (trees are removed in Tree::die(), Tree::remove(), ...)
+    with statistics that are built from scratch from all living trees. Differences are written to the log.
+    Afterwards, the statistics are re-created (see recreateStandStatistics()), i.e. the simulation uses
+    the full re-calculation in validation mode. */
+void ResourceUnit::validateStandStatistics(bool recalculate_stats)
+{
+    QVector<StandStatistics> full(mRUSpecies.count());
+    for (int i=0;i<mRUSpecies.count();i++)
+        full[i].setResourceUnitSpecies(mRUSpecies[i]);
+    foreach(const Tree &t, mTrees)
+        if (!t.isDead())
+            full[t.species()->index()].add(&t, nullptr);
+
+    for (int i=0;i<mRUSpecies.count();i++) {
+        const StandStatistics &stat = mRUSpecies[i]->statistics();
+        if (stat.isCalculated())
+            full[i].calculate();
+        const double values[4][2] = { {stat.count(), full[i].count()},
+                                      {stat.basalArea(), full[i].basalArea()},
+                                      {stat.leafAreaIndex(), full[i].leafAreaIndex()},
+                                      {stat.cStem(), full[i].cStem()} };
+        for (int v=0;v<4;++v) {
+            if (fabs(values[v][0] - values[v][1]) > 1e-6 * qMax(1., fabs(values[v][1]))) {
+                qWarning() << "Stand statistics validation: RU" << index() << "species" << mRUSpecies[i]->species()->id()
+                           << "(N, BA, LAI, cStem) incremental:" << stat.count() << stat.basalArea() << stat.leafAreaIndex() << stat.cStem()
+                           << "full:" << full[i].count() << full[i].basalArea() << full[i].leafAreaIndex() << full[i].cStem();
+                break;
+            }
+        }
+    }
+    recreateStandStatistics(recalculate_stats);
+}
+
 void ResourceUnit::analyzeMicroclimate()
 {
     if (mMicroclimate)
@@ -615,6 +659,13 @@ void ResourceUnit::calculateCarbonCycle()
     if (!snag())
         return;
 
+    calculateSoilInput();
+    soil()->calculateYear(); // update the ICBM/2N model
+    finishCarbonCycle();
+}
+
+void ResourceUnit::calculateSoilInput()
+{
     // (1) calculate the snag dynamics
     // because all carbon/nitrogen-flows from trees to the soil are routed through the snag-layer,
     // all soil inputs (litter + deadwood) are collected in the Snag-object.
@@ -624,8 +675,10 @@ void ResourceUnit::calculateCarbonCycle()
 
     soil()->setSoilInput( snag()->labileFlux(), snag()->refractoryFlux(),
                           snag()->labileFluxAbovegroundCarbon(), snag()->refractoryFluxAbovegroundCarbon());
+}
 
-    soil()->calculateYear(); // update the ICBM/2N model
+void ResourceUnit::finishCarbonCycle()
+{
     // use available nitrogen?
     if (Model::settings().useDynamicAvailableNitrogen)
         mUnitVariables.nitrogenAvailable = soil()->availableNitrogen();
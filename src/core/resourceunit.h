@@ -123,6 +123,10 @@ public:
     void cleanTreeList(); ///< remove dead trees from the tree storage.
     void treeDied() { mHasDeadTrees = true; } ///< sets the flag that indicates that the resource unit contains dead trees
     bool hasDiedTrees() const { return mHasDeadTrees; } ///< if true, the resource unit has dead trees and needs maybe some cleanup
+    bool hasTrees() const { return !mTrees.isEmpty(); } ///< true if the tree list is not empty (living or not yet removed dead trees)
+    /// true if establishment and sapling growth had nothing to do in the last year (no seeds, no saplings), see Saplings::isRegenerationActive()
+    bool regenerationIdle() const { return mRegenerationIdle; }
+    void setRegenerationIdle(const bool idle) { mRegenerationIdle = idle; }
     /// addWLA() is called by each tree to aggregate the total weighted leaf area on a unit
     void addWLA(const float LA, const float LRI) { mAggregatedWLA += LA*LRI; mAggregatedLA += LA; }
     void addLR(const float LA, const float LightResponse) { mAggregatedLR += LA*LightResponse; }
@@ -132,8 +136,10 @@ public:
     void addTreeAgingForAllTrees(); ///< calculate average tree aging for all trees of a RU. Used directly after stand initialization.
     // stocked area calculation
     void countStockedPixel(bool pixelIsStocked) { mPixelCount++; if (pixelIsStocked) mStockedPixelCount++; }
+    void countStockedPixels(); ///< (re-)count the stocked pixels of the height grid within the resource unit
     void createStandStatistics(); ///< helping function to create an initial state for stand statistics
     void recreateStandStatistics(bool recalculate_stats); ///< re-build stand statistics after some change happened to the resource unit
+    void validateStandStatistics(bool recalculate_stats); ///< compare the incrementally updated stand statistics with re-built statistics (validation mode)
     void setStockableArea(const double area) { mStockableArea = area; } ///< set stockable area (m2)
     void setCreateDebugOutput(const bool do_dbg) { mCreateDebugOutput = do_dbg; } ///< enable/disable output generation for RU
     bool shouldCreateDebugOutput() const { return mCreateDebugOutput; } ///< is debug output enabled for the RU?
@@ -144,6 +150,8 @@ public:
     // snag dynamics, soil carbon and nitrogen cycle
     void snagNewYear() { if (snag()) snag()->newYear(); } ///< clean transfer pools
     void calculateCarbonCycle(); ///< calculate snag dynamics at the end of a year
+    void calculateSoilInput(); ///< first part of the carbon cycle: snag dynamics and inputs to the soil
+    void finishCarbonCycle(); ///< last part of the carbon cycle (after the soil update): available nitrogen, debug outputs
     // model flow
     void newYear(); ///< reset values for a new simulation year
     // LIP/LIF-cylcle -> Model
@@ -158,6 +166,7 @@ private:
     int mIndex; ///< internal index
     int mID; ///< ID provided by external stand grid
     bool mHasDeadTrees; ///< flag that indicates if currently dead trees are in the tree list
+    bool mRegenerationIdle; ///< flag that indicates that the regeneration of the last year was a no-op
     Climate *mClimate; ///< pointer to the climate object of this RU
     SpeciesSet *mSpeciesSet; ///< pointer to the species set for this RU
     WaterCycle *mWater; ///< link to the Soil water calculation engine
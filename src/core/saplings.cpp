@@ -92,6 +92,43 @@ void Saplings::calculateInitialStatistics(const ResourceUnit *ru)
 
 /// establishment of saplings from seeds
 /// see https://iland-model.org/seed+kernel+and+seed+distribution and https://iland-model.org/establishment
+/// sum of the seed map values for the resource unit (the seed map has a resolution of 20m, i.e. 5x5 cells per RU)
+static float seedsOnResourceUnit(const ResourceUnitSpecies *rus, const QPoint &iseedmap)
+{
+    float seeds = 0.f;
+    Grid<float> &seedmap =  const_cast<Grid<float>& >(rus->species()->seedDispersal()->seedMap());
+    for (int iy=0;iy<5;++iy) {
+        float *p = seedmap.ptr(iseedmap.x(), iseedmap.y());
+        for (int ix=0;ix<5;++ix)
+            seeds += *p++;
+    }
+    return seeds;
+}
+
+bool Saplings::isRegenerationActive(const ResourceUnit *ru)
+{
+    if (!ru->regenerationIdle())
+        return true;
+    // statistics that have changed since the last year (e.g. saplings killed by disturbances)
+    foreach(const ResourceUnitSpecies *rus, ru->ruSpecies())
+        if (!rus->constSaplingStat().isEmpty())
+            return true;
+    // saplings (e.g. from planting or snapshots)
+    SaplingCell *s = ru->saplingCellArray();
+    if (s) {
+        for (int i=0;i<cPxPerRU*cPxPerRU;++i, ++s)
+            if (s->state!=SaplingCell::CellInvalid && s->n_occupied()>0)
+                return true;
+    }
+    // seeds
+    QPoint imap = ru->cornerPointOffset();
+    QPoint iseedmap = QPoint(imap.x()/10, imap.y()/10);
+    foreach(const ResourceUnitSpecies *rus, ru->ruSpecies())
+        if (seedsOnResourceUnit(rus, iseedmap) > 0.f)
+            return true;
+    return false;
+}
+
 void Saplings::establishment(const ResourceUnit *ru)
 {
     FloatGrid *lif_grid = GlobalSettings::instance()->model()->grid();
@@ -111,6 +148,7 @@ void Saplings::establishment(const ResourceUnit *ru)
 
 
     int species_idx;
+    bool any_seeds = false;
     QVector<int>::const_iterator sbegin, send;
     ru->speciesSet()->randomSpeciesOrder(sbegin, send);
     for (QVector<int>::const_iterator s_idx=sbegin; s_idx!=send;++s_idx) {
@@ -122,16 +160,12 @@ void Saplings::establishment(const ResourceUnit *ru)
         rus->establishment().clear();
 
         // check if there are seeds of the given species on the resource unit
-        float seeds = 0.f;
-        Grid<float> &seedmap =  const_cast<Grid<float>& >(rus->species()->seedDispersal()->seedMap());
-        for (int iy=0;iy<5;++iy) {
-            float *p = seedmap.ptr(iseedmap.x(), iseedmap.y());
-            for (int ix=0;ix<5;++ix)
-                seeds += *p++;
-        }
+        float seeds = seedsOnResourceUnit(rus, iseedmap);
         // if there are no seeds: no need to do more
         if (seeds==0.f)
             continue;
+        any_seeds = true;
+        Grid<float> &seedmap =  const_cast<Grid<float>& >(rus->species()->seedDispersal()->seedMap());
 
         // calculate the abiotic environment (TACA) (this could also trigger the execution of the water cycle)
         rus->establishment().calculateAbioticEnvironment();
@@ -194,6 +228,8 @@ void Saplings::establishment(const ResourceUnit *ru)
         // create debug output related to establishment
         rus->establishment().writeDebugOutputs();
     }
+    // without seeds the RU is idle (if sapling growth has nothing to do as well, see saplingGrowth())
+    const_cast<ResourceUnit*>(ru)->setRegenerationIdle(!any_seeds);
 
 }
 
@@ -235,6 +271,8 @@ void Saplings::saplingGrowth(const ResourceUnit *ru)
     for (QList<ResourceUnitSpecies*>::const_iterator i=ru->ruSpecies().constBegin(); i!=ru->ruSpecies().constEnd(); ++i) {
         (*i)->saplingStat().calculate((*i)->species(), const_cast<ResourceUnit*>(ru));
         (*i)->statistics().add(&((*i)->saplingStat()));
+        if (!(*i)->saplingStat().isEmpty())
+            const_cast<ResourceUnit*>(ru)->setRegenerationIdle(false);
     }
 
     // debug output related to saplings
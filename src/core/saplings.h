@@ -133,6 +133,8 @@ class SaplingStat
 public:
     SaplingStat() { clearStatistics(); }
     void clearStatistics();
+    /// true if there is nothing to report (no living, added, recruited or died cohorts)
+    bool isEmpty() const { return mLiving==0 && mAdded==0 && mAddedVegetative==0 && mRecruited==0 && mDied==0; }
     /// calculate statistics (and carbon flows) for the saplings of species 'species' on 'ru'.
     void calculate(const Species *species, ResourceUnit *ru);
     // actions
@@ -197,6 +199,10 @@ public:
     // main functions
     void establishment(const ResourceUnit *ru);
     void saplingGrowth(const ResourceUnit *ru);
+    /// returns false if establishment and sapling growth can be skipped for the resource unit 'ru', i.e.
+    /// when the RU was idle in the last year, and there are still no saplings and no seeds available.
+    /// The function is called after seed dispersal.
+    static bool isRegenerationActive(const ResourceUnit *ru);
 
     /// run the simplified grass cover for a RU
     void simplifiedGrassCover(const ResourceUnit *ru);
@@ -30,6 +30,7 @@
   */
 
 double Soil::mNitrogenDeposition = 0.;
+bool Soil::mRecordInputs = false;
 
 // site-specific parameters
 // i.e. parameters that need to be specified in the environment file
@@ -123,6 +124,15 @@ void Soil::setInitialState(const CNPool &young_labile_kg_ha,
 /// @param labile_aboveground_C Carbon in the labile input from aboveground sources (kg/ha)
 /// @param refr_aboveground_C Carbon in the woody input from aboveground sources (kg/ha)
 void Soil::setSoilInput(const CNPool &labile_input_kg_ha, const CNPool &refractory_input_kg_ha, double labile_aboveground_C, double refractory_aboveground_C)
+{
+    if (mRecordInputs) {
+        SoilInputRecord rec = { labile_input_kg_ha, refractory_input_kg_ha, labile_aboveground_C, refractory_aboveground_C, mRE };
+        mInputHistory.push_back(rec);
+    }
+    applySoilInput(labile_input_kg_ha, refractory_input_kg_ha, labile_aboveground_C, refractory_aboveground_C);
+}
+
+void Soil::applySoilInput(const CNPool &labile_input_kg_ha, const CNPool &refractory_input_kg_ha, double labile_aboveground_C, double refractory_aboveground_C)
 {
     // stockable area:
     // if the stockable area is < 1ha, then
@@ -176,110 +186,262 @@ void Soil::setSoilInput(const CNPool &labile_input_kg_ha, const CNPool &refracto
 /// See Appendix of Kaetterer et al 2001 for integrated equations
 void Soil::calculateYear()
 {
-    SoilParams &sp = *mParams;
-    // checks
-    if (mRE==0.) {
-        throw IException("Soil::calculateYear(): Invalid value for 're' (=0) for RU(index): " + QString::number(mRU->index()));
-    }
-    const double t = 1.; // timestep (annual)
-    // auxiliary calculations
-    CNPair total_before = mYL + mYR + mSOM;
-
-    CNPair total_in = mInputLab + mInputRef;
-    if (isnan(total_in.C) || isnan(mKyr))
-        qDebug() << "soil input is NAN.";
-
-    double ylss = mInputLab.C / (mKyl * mRE); // Yl stedy state C (eq A13)
-    double cl = sp.el * (1. - mH)/sp.qb - mH*(1.-sp.el)/sp.qh; // eta l in the paper
-    double ynlss = 0.;
-    if (!mInputLab.isEmpty()) {
-        ynlss = mInputLab.C / (mKyl*mRE*(1.-mH)) * ((1.-sp.el)/mInputLab.CN() + cl); // Yl steady state N
-        if (ynlss < 0.)
-            ynlss = 0.; // do not allow a negative value for steady state
-    }
-
-    double yrss = mInputRef.C / (mKyr * mRE); // Yr steady state C (eq A14)
-    double cr = sp.er * (1. - mH)/sp.qb - mH*(1.-sp.er)/sp.qh; // eta r in the paper
-    double ynrss = 0.;
-    if (!mInputRef.isEmpty()) {
-        ynrss = mInputRef.C / (mKyr*mRE*(1.-mH)) * ((1.-sp.er)/mInputRef.CN() + cr); // Yr steady state N
-        if (ynrss <0.)
-            ynrss = 0.; // do not allow negative steady state
-    }
+    Soil *soil = this;
+    calculateYears(&soil, 1);
+}
 
-    double oss = mH*total_in.C / (mKo*mRE); // O steady state C
-    double onss = mH*total_in.C / (sp.qh*mKo*mRE); // O steady state N
-
-    double al = mH*(mKyl*mRE* mYL.C - mInputLab.C) / ((mKo-mKyl)*mRE);
-    double ar = mH*(mKyr*mRE* mYR.C - mInputRef.C) / ((mKo-mKyr)*mRE);
-
-    // update of state variables
-    // precalculations
-    double lfactor = exp(-mKyl*mRE*t);
-    double rfactor = exp(-mKyr*mRE*t);
-    // young labile pool
-    CNPair yl=mYL;
-    mYL.C = ylss + (yl.C-ylss)*lfactor;
-    // N: see eq A18
-    mYL.N = ynlss + (yl.N-ynlss-cl/(sp.el-mH)*(yl.C-ylss))*exp(-mKyl*mRE*(1.-mH)*t/(1.-sp.el)) + cl/(sp.el-mH)*(yl.C-ylss)*lfactor;
-    if (mYL.N < 0.)
-        mYL.N = 0.;
-
-    mYL.setParameter( mKyl ); // update decomposition rate
-
-    // young ref. pool
-    CNPair yr=mYR;
-    mYR.C = yrss + (yr.C-yrss)*rfactor;
-    // N: see eq A19.
-    mYR.N = ynrss + (yr.N-ynrss-cr/(sp.er-mH)*(yr.C-yrss))*exp(-mKyr*mRE*(1.-mH)*t/(1.-sp.er)) + cr/(sp.er-mH)*(yr.C-yrss)*rfactor;
-    if (mYR.N < 0.) {
-        mYR.N = 0.;
-        //qDebug() << "YR.N <0 ";
-    }
-    mYR.setParameter( mKyr ); // update decomposition rate
-    // SOM pool (old)
-    CNPair o = mSOM;
-    mSOM.C = oss + (o.C -oss - al - ar)*exp(-mKo*mRE*t) + al*lfactor + ar*rfactor;
-    mSOM.N = onss + (o.N - onss -(al+ar)/sp.qh)*exp(-mKo*mRE*t) + al/sp.qh * lfactor + ar/sp.qh * rfactor;
-
-    if (!mYL.isValid() || !mYR.isValid() || !mSOM.isValid()) {
-        qDebug() << "Soil::calculateYear: invalid soil pools in yL, yR, or SOM";
+/** SoilBatch holds the inputs, state and results of the ICBM/2N model for a block of soils
+    as a structure of arrays (one array per variable, see Soil::calculateYears()). */
+struct SoilBatch {
+    static const int size = 64; ///< number of soils per block
+    // state variables (t/ha)
+    double ylC[size], ylN[size], yrC[size], yrN[size], somC[size], somN[size];
+    // inputs (t/ha) and parameters
+    double inLC[size], inLN[size], inRC[size], inRN[size];
+    double kyl[size], kyr[size], ko[size], h[size], re[size];
+    // results
+    double fluxC[size], fluxN[size]; ///< flux to the atmosphere (t/ha)
+    double navL[size], navR[size], navS[size]; ///< plant available nitrogen from the labile, refractory and SOM pools (kg/ha)
+};
+
+/// update the state of the first 'n' soils of the block 'b' (one year).
+/// The loop contains only arithmetic on local values (no member access, no function calls except exp()),
+/// i.e. the compiler is free to unroll/vectorize; the sequence of operations is the same as in the original scalar code.
+static void calculateSoilBatch(SoilBatch &b, const int n, const SoilParams &sp)
+{
+    const double t = 1.; // timestep (annual)
+    for (int i=0;i<n;++i) {
+        const double kyl = b.kyl[i], kyr = b.kyr[i], ko = b.ko[i], h = b.h[i], re = b.re[i];
+        const double in_lc = b.inLC[i], in_ln = b.inLN[i], in_rc = b.inRC[i], in_rn = b.inRN[i];
+        const double yl_c = b.ylC[i], yl_n = b.ylN[i], yr_c = b.yrC[i], yr_n = b.yrN[i];
+        const double o_c = b.somC[i], o_n = b.somN[i];
+
+        // auxiliary calculations
+        const double before_c = yl_c + yr_c + o_c, before_n = yl_n + yr_n + o_n;
+        const double in_c = in_lc + in_rc, in_n = in_ln + in_rn;
+
+        double ylss = in_lc / (kyl * re); // Yl stedy state C (eq A13)
+        double cl = sp.el * (1. - h)/sp.qb - h*(1.-sp.el)/sp.qh; // eta l in the paper
+        double ynlss = 0.;
+        if (in_lc != 0.) {
+            const double cn = in_ln > 0. ? in_lc / in_ln : 0.;
+            ynlss = in_lc / (kyl*re*(1.-h)) * ((1.-sp.el)/cn + cl); // Yl steady state N
+            if (ynlss < 0.)
+                ynlss = 0.; // do not allow a negative value for steady state
+        }
+
+        double yrss = in_rc / (kyr * re); // Yr steady state C (eq A14)
+        double cr = sp.er * (1. - h)/sp.qb - h*(1.-sp.er)/sp.qh; // eta r in the paper
+        double ynrss = 0.;
+        if (in_rc != 0.) {
+            const double cn = in_rn > 0. ? in_rc / in_rn : 0.;
+            ynrss = in_rc / (kyr*re*(1.-h)) * ((1.-sp.er)/cn + cr); // Yr steady state N
+            if (ynrss <0.)
+                ynrss = 0.; // do not allow negative steady state
+        }
+
+        double oss = h*in_c / (ko*re); // O steady state C
+        double onss = h*in_c / (sp.qh*ko*re); // O steady state N
+
+        double al = h*(kyl*re* yl_c - in_lc) / ((ko-kyl)*re);
+        double ar = h*(kyr*re* yr_c - in_rc) / ((ko-kyr)*re);
+
+        // update of state variables
+        // precalculations
+        double lfactor = exp(-kyl*re*t);
+        double rfactor = exp(-kyr*re*t);
+        // young labile pool
+        double ylc_new = ylss + (yl_c-ylss)*lfactor;
+        // N: see eq A18
+        double yln_new = ynlss + (yl_n-ynlss-cl/(sp.el-h)*(yl_c-ylss))*exp(-kyl*re*(1.-h)*t/(1.-sp.el)) + cl/(sp.el-h)*(yl_c-ylss)*lfactor;
+        if (yln_new < 0.)
+            yln_new = 0.;
+
+        // young ref. pool
+        double yrc_new = yrss + (yr_c-yrss)*rfactor;
+        // N: see eq A19.
+        double yrn_new = ynrss + (yr_n-ynrss-cr/(sp.er-h)*(yr_c-yrss))*exp(-kyr*re*(1.-h)*t/(1.-sp.er)) + cr/(sp.er-h)*(yr_c-yrss)*rfactor;
+        if (yrn_new < 0.)
+            yrn_new = 0.;
+
+        // SOM pool (old)
+        double oc_new = oss + (o_c -oss - al - ar)*exp(-ko*re*t) + al*lfactor + ar*rfactor;
+        double on_new = onss + (o_n - onss -(al+ar)/sp.qh)*exp(-ko*re*t) + al/sp.qh * lfactor + ar/sp.qh * rfactor;
+
+        b.ylC[i] = ylc_new; b.ylN[i] = yln_new;
+        b.yrC[i] = yrc_new; b.yrN[i] = yrn_new;
+        b.somC[i] = oc_new; b.somN[i] = on_new;
+
+        // calculate delta (i.e. flux to atmosphere)
+        b.fluxC[i] = before_c + in_c - (ylc_new + yrc_new + oc_new);
+        b.fluxN[i] = before_n + in_n - (yln_new + yrn_new + on_new);
+
+        // calculate plant available nitrogen (t/ha -> kg/ha)
+        double nav_l = kyl*re*(1.-h)/(1.-sp.el) * (yln_new - sp.el*ylc_new/sp.qb);  // N from labile...
+        double nav_r = kyr*re*(1-h)/(1.-sp.er)* (yrn_new - sp.er*yrc_new/sp.qb); // + N from refractory...
+        double nav_s = ko*re*on_new*(1.-sp.leaching); // + N from SOM pool (reduced by leaching (leaching modeled only from slow SOM Pool))
+        b.navL[i] = nav_l * 1000.;
+        b.navR[i] = nav_r * 1000.;
+        b.navS[i] = nav_s * 1000.;
     }
+}
 
-    // calculate delta (i.e. flux to atmosphere)
-    CNPair total_after = mYL + mYR + mSOM;
-    CNPair flux = total_before + total_in - total_after;
-    if (flux.C < 0.) {
-        qDebug() << "negative flux to atmosphere?!?";
-        flux.clear();
+/// calculate the soil dynamics of 'n' soils (see calculateYear()). The soils are processed in blocks of
+/// SoilBatch::size: the state of a block is copied into a structure of arrays, updated in a tight loop, and copied back.
+/// The results are identical to updating each soil separately.
+void Soil::calculateYears(Soil * const *soils, const int n)
+{
+    SoilParams &sp = *mParams;
+    SoilBatch b;
+    for (int start=0; start<n; start+=SoilBatch::size) {
+        const int count = qMin(n - start, static_cast<int>(SoilBatch::size));
+        Soil * const *block = soils + start;
+
+        // (1) gather inputs and state
+        for (int i=0;i<count;++i) {
+            Soil *s = block[i];
+            // checks
+            if (s->mRE==0.) {
+                throw IException("Soil::calculateYear(): Invalid value for 're' (=0) for RU(index): " + QString::number(s->mRU->index()));
+            }
+            if (isnan(s->mInputLab.C + s->mInputRef.C) || isnan(s->mKyr))
+                qDebug() << "soil input is NAN.";
+            b.ylC[i] = s->mYL.C; b.ylN[i] = s->mYL.N;
+            b.yrC[i] = s->mYR.C; b.yrN[i] = s->mYR.N;
+            b.somC[i] = s->mSOM.C; b.somN[i] = s->mSOM.N;
+            b.inLC[i] = s->mInputLab.C; b.inLN[i] = s->mInputLab.N;
+            b.inRC[i] = s->mInputRef.C; b.inRN[i] = s->mInputRef.N;
+            b.kyl[i] = s->mKyl; b.kyr[i] = s->mKyr; b.ko[i] = s->mKo;
+            b.h[i] = s->mH; b.re[i] = s->mRE;
+        }
+
+        // (2) update of the ICBM/2N model
+        calculateSoilBatch(b, count, sp);
+
+        // (3) write back the state and the results
+        for (int i=0;i<count;++i) {
+            Soil *s = block[i];
+            s->mYL.C = b.ylC[i]; s->mYL.N = b.ylN[i];
+            s->mYL.setParameter( s->mKyl ); // update decomposition rate
+            s->mYR.C = b.yrC[i]; s->mYR.N = b.yrN[i];
+            s->mYR.setParameter( s->mKyr ); // update decomposition rate
+            s->mSOM.C = b.somC[i]; s->mSOM.N = b.somN[i];
+
+            if (!s->mYL.isValid() || !s->mYR.isValid() || !s->mSOM.isValid()) {
+                qDebug() << "Soil::calculateYear: invalid soil pools in yL, yR, or SOM";
+            }
+
+            CNPair flux(b.fluxC[i], b.fluxN[i]);
+            if (flux.C < 0.) {
+                qDebug() << "negative flux to atmosphere?!?";
+                flux.clear();
+            }
+            s->mTotalToAtmosphere += flux;
+
+            s->mAvailableNitrogenFromLabile = b.navL[i];
+            s->mAvailableNitrogenFromRefractory = b.navR[i];
+            s->mAvailableNitrogen = b.navL[i] + b.navR[i] + b.navS[i];
+
+            if (s->mAvailableNitrogen<0.)
+                s->mAvailableNitrogen = 0.;
+            if (isnan(s->mAvailableNitrogen) || isnan(s->mYR.C))
+                qDebug() << "Available Nitrogen is NAN.";
+
+            // add nitrogen deposition
+            s->mAvailableNitrogen += mNitrogenDeposition;
+        }
     }
-    mTotalToAtmosphere += flux;
-
-
-    // calculate plant available nitrogen
-    mAvailableNitrogenFromLabile = mKyl*mRE*(1.-mH)/(1.-sp.el) * (mYL.N - sp.el*mYL.C/sp.qb);  // N from labile...
-    mAvailableNitrogenFromRefractory = mKyr*mRE*(1-mH)/(1.-sp.er)* (mYR.N - sp.er*mYR.C/sp.qb); // + N from refractory...
-    double nav_from_som = mKo*mRE*mSOM.N*(1.-sp.leaching); // + N from SOM pool (reduced by leaching (leaching modeled only from slow SOM Pool))
-
-    mAvailableNitrogenFromLabile *= 1000.; // t/ha -> kg/ha
-    mAvailableNitrogenFromRefractory *= 1000.; // t/ha -> kg/ha
-    nav_from_som *= 1000.; // t/ha -> kg/ha
-
-    mAvailableNitrogen = mAvailableNitrogenFromLabile + mAvailableNitrogenFromRefractory + nav_from_som;
-
-    if (mAvailableNitrogen<0.)
-        mAvailableNitrogen = 0.;
-    if (isnan(mAvailableNitrogen) || isnan(mYR.C))
-        qDebug() << "Available Nitrogen is NAN.";
+}
 
-    // add nitrogen deposition
-    mAvailableNitrogen += mNitrogenDeposition;
+/// set the pools to the analytical steady state for constant annual inputs (t/ha) and a constant climate factor 're'
+/// (see eqs. A13/A14 in Kaetterer et al 2001 and calculateYear()).
+void Soil::setSteadyState(CNPool labile_input, CNPool refractory_input, double labile_aboveground_C, double refractory_aboveground_C, double re)
+{
+    SoilParams &sp = *mParams;
+    if (labile_input.parameter()>0.)
+        mKyl = labile_input.parameter();
+    if (refractory_input.parameter()>0.)
+        mKyr = refractory_input.parameter();
+    if (mKyl<=0. || mKyr<=0. || re<=0.)
+        return; // keep the current state
+
+    double cl = sp.el * (1. - mH)/sp.qb - mH*(1.-sp.el)/sp.qh;
+    double cr = sp.er * (1. - mH)/sp.qb - mH*(1.-sp.er)/sp.qh;
+    mYL.C = labile_input.C / (mKyl * re);
+    mYL.N = labile_input.isEmpty() ? 0. : std::max(labile_input.C / (mKyl*re*(1.-mH)) * ((1.-sp.el)/labile_input.CN() + cl), 0.);
+    mYL.setParameter(mKyl);
+    mYR.C = refractory_input.C / (mKyr * re);
+    mYR.N = refractory_input.isEmpty() ? 0. : std::max(refractory_input.C / (mKyr*re*(1.-mH)) * ((1.-sp.er)/refractory_input.CN() + cr), 0.);
+    mYR.setParameter(mKyr);
+    mSOM.C = mH*(labile_input.C + refractory_input.C) / (mKo*re);
+    mSOM.N = mSOM.C / sp.qh;
+
+    mYLaboveground_frac = labile_input.C>0. ? limit(labile_aboveground_C / labile_input.C, 0., 1.) : 0.;
+    mYRaboveground_frac = refractory_input.C>0. ? limit(refractory_aboveground_C / refractory_input.C, 0., 1.) : 0.;
+}
 
-    // stedy state for n-available
-    //    double navss = mKyl*mRE*(1.-mH)/(1.-sp.el)*(ynlss-sp.el*ylss/sp.qb); // available nitrogen (steady state)
-    //    navss += mKyr*mRE*(1.-mH)/(1.-sp.er)*(ynrss - sp.er*yrss/sp.qb);
-    //    navss += mKo*mRE*onss*(1.-sp.leaching);
+/// Aitken's delta-squared extrapolation of a linearly converging sequence x0, x1, x2
+static double aitken(const double x0, const double x1, const double x2)
+{
+    double d1 = x1 - x0;
+    double d2 = x2 - x1;
+    double denom = d2 - d1;
+    if (fabs(d2) >= fabs(d1) || fabs(denom) < 1e-12)
+        return x2; // not converging (or already converged)
+    double x = x2 - d2*d2 / denom;
+    return x >= 0. ? x : x2;
+}
 
+/// The spin-up starts from the analytical steady state for the mean of the recorded inputs and climate factors. From there,
+/// the recorded years are cycled until the relative change of the total soil carbon after a full cycle is below 'tolerance'.
+/// The slow SOM pool is accelerated by an extrapolation (Aitken) every three cycles.
+int Soil::spinup(const int max_cycles, const double tolerance)
+{
+    if (mInputHistory.isEmpty())
+        return 0;
+    double area_ha = mRU?mRU->stockableArea() / cRUArea:1.;
+    if (area_ha==0.)
+        return 0;
+
+    // (1) steady state for the average inputs
+    CNPool lab_in, ref_in;
+    double lab_ag = 0., ref_ag = 0., re = 0.;
+    foreach(const SoilInputRecord &rec, mInputHistory) {
+        lab_in += rec.labile;
+        ref_in += rec.refractory;
+        lab_ag += rec.labileAbovegroundC;
+        ref_ag += rec.refractoryAbovegroundC;
+        re += rec.re;
+    }
+    double scale = 0.001 / area_ha / mInputHistory.size(); // kg/ha -> t/ha, mean value per year
+    setSteadyState(lab_in * scale, ref_in * scale, lab_ag * scale, ref_ag * scale, re / mInputHistory.size());
+
+    // (2) cycle through the recorded inputs
+    double c_prev = totalCarbon();
+    CNPair som[3];
+    int n_som = 0;
+    for (int cycle=1; cycle<=max_cycles; ++cycle) {
+        foreach(const SoilInputRecord &rec, mInputHistory) {
+            setClimateFactor(rec.re);
+            applySoilInput(rec.labile, rec.refractory, rec.labileAbovegroundC, rec.refractoryAbovegroundC);
+            calculateYear();
+        }
+        double c = totalCarbon();
+        if (fabs(c - c_prev) <= tolerance * std::max(c, 0.001)) {
+            newYear();
+            return cycle;
+        }
+        som[n_som++] = mSOM;
+        if (n_som==3) {
+            mSOM.C = aitken(som[0].C, som[1].C, som[2].C);
+            mSOM.N = aitken(som[0].N, som[1].N, som[2].N);
+            n_som = 0;
+            c = totalCarbon();
+        }
+        c_prev = c;
+    }
+    newYear();
+    return -1;
 }
 
 QList<QVariant> Soil::debugList()
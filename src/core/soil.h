@@ -20,11 +20,21 @@
 #ifndef SOIL_H
 #define SOIL_H
 
+#include <QVector>
 #include "snag.h"
 struct SoilParams; // forward
 class ResourceUnit; // forward
 class SoilInputOut; // forward
 
+/** SoilInputRecord stores the inputs of the soil model of one year (see Soil::setRecordInputs()). */
+struct SoilInputRecord {
+    CNPool labile; ///< input to the labile pool (kg/ha)
+    CNPool refractory; ///< input to the refractory pool (kg/ha)
+    double labileAbovegroundC; ///< C of the labile input from aboveground sources (kg/ha)
+    double refractoryAbovegroundC; ///< C of the refractory input from aboveground sources (kg/ha)
+    double re; ///< climate factor 're'
+};
+
 class Soil
 {
 public:
@@ -38,6 +48,11 @@ public:
     void setClimateFactor(const double climate_factor_re) { mRE = climate_factor_re; } ///< set the climate decomposition factor for the current year
     void newYear(); ///< reset of counters
     void calculateYear(); ///< main calculation function: calculates the update of state variables
+    /// calculate the update of the state variables for 'n' soils at once (block-wise, see SoilBatch in soil.cpp)
+    static void calculateYears(Soil * const *soils, const int n);
+    /// run the soil model repeatedly with the recorded inputs (see setRecordInputs()) until the pools reach a (dynamic) equilibrium.
+    /// Returns the number of cycles through the input history, -1 if no equilibrium was reached, and 0 if no inputs are recorded.
+    int spinup(const int max_cycles, const double tolerance);
 
     /// remove part of the biomass (e.g.: due to fire).
     /// @param DWDfrac fraction of downed woody debris (yR) to remove (0: nothing, 1: remove 100% percent)
@@ -63,9 +78,17 @@ public:
     const CNPair &fluxToDisturbance() const { return mTotalToDisturbance; } ///< total flux due to disturbance events (e.g. fire) kg/ha
 
     QList<QVariant> debugList(); ///< return a debug output
+
+    /// if 'record' is true, the inputs of each year are stored (e.g. to run a soil spin-up, see SoilSpinup)
+    static void setRecordInputs(const bool record) { mRecordInputs = record; }
+    static bool recordInputs() { return mRecordInputs; }
+    const QVector<SoilInputRecord> &inputHistory() const { return mInputHistory; } ///< recorded inputs (one element per year)
+    void clearInputHistory() { mInputHistory.clear(); }
 private:
     ResourceUnit *mRU; ///< link to containing resource unit
     void fetchParameters(); ///< set iland parameters for soil
+    void applySoilInput(const CNPool &labile_input_kg_ha, const CNPool &refractory_input_kg_ha, double labile_aboveground_C, double refractory_aboveground_C);
+    void setSteadyState(CNPool labile_input, CNPool refractory_input, double labile_aboveground_C, double refractory_aboveground_C, double re); ///< pools in equilibrium with constant inputs (t/ha)
     static SoilParams *mParams; // static container for parameters
     // variables
     double mRE; ///< climate factor 're' (see Snag::calculateClimateFactors())
@@ -91,6 +114,8 @@ private:
     CNPair mTotalToAtmosphere; ///< book-keeping disturbance envents (fire) (kg/ha)
 
     static double mNitrogenDeposition; ///< annual nitrogen deposition (kg N/ha*yr)
+    static bool mRecordInputs; ///< if true, inputs are stored in mInputHistory
+    QVector<SoilInputRecord> mInputHistory; ///< recorded inputs of the soil
     friend class Snapshot;
     friend class SoilInputOut;
 };
@@ -0,0 +1,118 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#include "global.h"
+#include "soilspinup.h"
+#include "globalsettings.h"
+#include "model.h"
+#include "resourceunit.h"
+#include "soil.h"
+#include "helper.h"
+#include "debugtimer.h"
+
+/** @class SoilSpinup
+  @ingroup core
+  The spin-up of the soil pools to equilibrium usually requires hundreds of years of simulation. SoilSpinup
+  uses instead the soil inputs (litter and deadwood, and the climate factor 're') that are recorded during a (shorter)
+  simulation (setting 'model.settings.soil.recordInputs'), and cycles these inputs through the soil model only (see Soil::spinup()).
+  The calculation is done in parallel for all resource units.
+
+  The resulting pools are the state of the soil in the model (i.e. they can be stored with a model snapshot), and
+  can be saved in the format of the environment file (saveState()), which allows using them as initial
+  state ('model.site.youngLabileC', ...) in later simulations.
+
+  Note that snag pools are not part of the spin-up: they depend on the individual dying trees (thresholds, single snags) and
+  reach their equilibrium typically within a few decades, i.e. within the recording period.
+  */
+
+SoilSpinup *SoilSpinup::mInstance = nullptr;
+
+SoilSpinup::SoilSpinup(const int max_cycles, const double tolerance)
+{
+    mMaxCycles = max_cycles;
+    mTolerance = tolerance;
+    mInstance = this;
+}
+
+SoilSpinup::~SoilSpinup()
+{
+    if (mInstance == this)
+        mInstance = nullptr;
+}
+
+/// worker function: spin-up of a single resource unit
+void SoilSpinup::nc_spinup(ResourceUnit *ru)
+{
+    if (!ru->soil())
+        return;
+    try {
+        mInstance->mCycles[ru->index()] = ru->soil()->spinup(mInstance->mMaxCycles, mInstance->mTolerance);
+    } catch (const IException& e) {
+        GlobalSettings::instance()->model()->threadExec().throwError(e.message());
+    }
+}
+
+int SoilSpinup::run()
+{
+    Model *model = GlobalSettings::instance()->model();
+    if (!model || !Model::settings().carbonCycleEnabled)
+        throw IException("SoilSpinup: the carbon cycle is not enabled.");
+
+    DebugTimer t("SoilSpinup:run");
+    mInstance = this;
+    mCycles.fill(0, model->ruList().count());
+    model->executePerResourceUnit(nc_spinup);
+    const_cast<ThreadRunner&>(model->threadExec()).checkErrors();
+
+    int n_equilibrium = 0, n_failed = 0, max_cycles = 0;
+    for (int i=0;i<mCycles.size();++i) {
+        if (mCycles[i] > 0)
+            ++n_equilibrium;
+        if (mCycles[i] < 0)
+            ++n_failed;
+        max_cycles = std::max(max_cycles, mCycles[i]);
+    }
+    if (n_equilibrium + n_failed == 0)
+        throw IException("SoilSpinup: no recorded soil inputs available. Enable 'model.settings.soil.recordInputs' and run the model first.");
+
+    qDebug() << "SoilSpinup: equilibrium reached for" << n_equilibrium << "resource units (max. cycles:" << max_cycles << "), no equilibrium after"
+             << mMaxCycles << "cycles for" << n_failed << "resource units.";
+    return n_equilibrium;
+}
+
+void SoilSpinup::saveState(const QString &file_name) const
+{
+    Model *model = GlobalSettings::instance()->model();
+    QStringList lines;
+    lines << "id,model.site.youngLabileC,model.site.youngLabileN,model.site.youngLabileDecompRate,"
+             "model.site.youngRefractoryC,model.site.youngRefractoryN,model.site.youngRefractoryDecompRate,"
+             "model.site.somC,model.site.somN,model.site.youngLabileAbovegroundFraction,model.site.youngRefractoryAbovegroundFraction";
+    foreach(const ResourceUnit *ru, model->ruList()) {
+        const Soil *s = ru->soil();
+        if (!s || ru->id()==-1)
+            continue;
+        // pools are stored in t/ha, the initial state is given in kg/ha
+        lines << QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10,%11").arg(ru->id())
+                 .arg(s->youngLabile().C*1000.).arg(s->youngLabile().N*1000.).arg(s->youngLabile().parameter())
+                 .arg(s->youngRefractory().C*1000.).arg(s->youngRefractory().N*1000.).arg(s->youngRefractory().parameter())
+                 .arg(s->oldOrganicMatter().C*1000.).arg(s->oldOrganicMatter().N*1000.)
+                 .arg(s->youngLabileAbovegroundFraction()).arg(s->youngRefractoryAbovegroundFraction());
+    }
+    Helper::saveToTextFile(file_name, lines.join("\n"));
+    qDebug() << "SoilSpinup: saved soil pools of" << lines.count()-1 << "resource units to" << file_name;
+}
@@ -0,0 +1,46 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#ifndef SOILSPINUP_H
+#define SOILSPINUP_H
+
+#include <QString>
+#include <QVector>
+
+class ResourceUnit; // forward
+
+/** @class SoilSpinup runs the soil model (ICBM/2N) of all resource units with recorded inputs until equilibrium.
+  */
+class SoilSpinup
+{
+public:
+    SoilSpinup(const int max_cycles=100, const double tolerance=0.0001);
+    ~SoilSpinup();
+    /// run the spin-up for all resource units (in parallel). Returns the number of resource units that reached an equilibrium.
+    int run();
+    /// save the soil pools of all resource units to 'file_name' (format of the environment file, i.e. one row per resource unit id)
+    void saveState(const QString &file_name) const;
+private:
+    static void nc_spinup(ResourceUnit *ru);
+    static SoilSpinup *mInstance; ///< used by the (static) worker function
+    int mMaxCycles; ///< maximum number of cycles through the recorded inputs
+    double mTolerance; ///< relative change of total soil carbon per cycle that is considered as equilibrium
+    QVector<int> mCycles; ///< number of cycles per resource unit (index: ru->index()), see Soil::spinup()
+};
+
+#endif // SOILSPINUP_H
@@ -127,6 +127,12 @@ void Species::setup()
     if (mFoliage_a*mFoliage_b*mRoot_a*mRoot_b*mStem_a*mStem_b*mBranch_a*mBranch_b*mWoodDensity*mFormFactor*mSpecificLeafArea*mFinerootFoliageRatio == 0.) {
         throw IException( QString("Error setting up species %1: one value is NULL in database.").arg(id()));
     }
+    mFoliageTable.setup(mFoliage_a, mFoliage_b);
+    mStemTable.setup(mStem_a, mStem_b);
+    mRootTable.setup(mRoot_a, mRoot_b);
+    mBranchTable.setup(mBranch_a, mBranch_b);
+    // d(branch)/d(stem) = (a_b*b_b*dbh^(b_b-1)) / (a_s*b_s*dbh^(b_s-1))
+    mBranchStemRatioTable.setup(mBranch_a*mBranch_b / (mStem_a*mStem_b), mBranch_b - mStem_b);
     // Aging
     mMaximumAge = doubleVar("maximumAge");
     mMaximumHeight = doubleVar("maximumHeight");
@@ -239,6 +245,9 @@ void Species::setup()
     the ratio for stem is 1 minus the ratio of twigs to total woody increment at current "dbh". */
 double Species::allometricFractionStem(const double dbh) const
 {
+    if (AllometryTable::enabled())
+        return 1. / (1. + mBranchStemRatioTable.value(dbh));
+
     double inc_branch_per_d = (mBranch_a*mBranch_b*pow(dbh, mBranch_b-1.));
     double inc_woody_per_d = (mStem_a*mStem_b*pow(dbh, mStem_b-1));
     //double fraction_stem = 1. - inc_branch_per_d / inc_woody_per_d; // old
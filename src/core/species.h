@@ -26,6 +26,7 @@
 #include "expression.h"
 #include "globalsettings.h"
 #include "speciesset.h"
+#include "allometrytable.h"
 
 class StampContainer; // forwards
 class Stamp;
@@ -99,10 +100,11 @@ public:
 
 
     // calculations: allometries for the tree compartments (stem, branches, foliage, fineroots, coarse roots)
-    inline double biomassFoliage(const double dbh) const { return mFoliage_a * pow(dbh, mFoliage_b); }
-    inline double biomassStem(const double dbh) const { return mStem_a * pow(dbh, mStem_b); }
-    inline double biomassRoot(const double dbh) const { return mRoot_a * pow(dbh, mRoot_b); }
-    inline double biomassBranch(const double dbh) const { return mBranch_a * pow(dbh, mBranch_b); }
+    // (a * dbh^b, see AllometryTable)
+    inline double biomassFoliage(const double dbh) const { return mFoliageTable.value(dbh); }
+    inline double biomassStem(const double dbh) const { return mStemTable.value(dbh); }
+    inline double biomassRoot(const double dbh) const { return mRootTable.value(dbh); }
+    inline double biomassBranch(const double dbh) const { return mBranchTable.value(dbh); }
     // inline double allometricRatio_wf() const { return mStem_b / mFoliage_b; }
     inline double allometricExponentStem() const { return mStem_b; }
     inline double allometricExponentBranch() const { return mBranch_b; }
@@ -182,6 +184,8 @@ private:
     double mStem_a, mStem_b; ///< allometry (biomass = a * dbh^b) for stem aboveground
     double mRoot_a, mRoot_b; ///< allometry (biomass = a * dbh^b) for roots (compound, fine and coarse roots as one pool)
     double mBranch_a, mBranch_b; ///< allometry (biomass = a * dbh^b) for branches
+    AllometryTable mFoliageTable, mStemTable, mRootTable, mBranchTable; ///< lookup tables for the biomass allometries
+    AllometryTable mBranchStemRatioTable; ///< ratio of the increments (per dbh) of branch and stem biomass (see allometricFractionStem())
     // cn-ratios
     double mCNFoliage, mCNFineroot, mCNWood; ///< CN-ratios for various tissue types; stem, branches and coarse roots are pooled as 'wood'
     double mBarkThicknessFactor; ///< multiplier to estimate bark thickness (cm) from dbh
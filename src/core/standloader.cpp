@@ -48,6 +48,56 @@
 static QVector<int> picusSpeciesIds = QVector<int>() << 0 << 1 << 17;
 static QStringList iLandSpeciesIds = QStringList() << "piab" << "piab" << "fasy";
 
+/// a single tree of a single tree list (parsed values, see loadSingleTreeList())
+struct InitTreeRecord {
+    QPointF pos;
+    double dbh;
+    double height;
+    int id;
+    int age;
+    bool age_ok;
+    Species *species;
+    QString species_id; ///< species code (for error messages)
+    int picus_id; ///< invalid Picus species id (or -1)
+};
+/// a block of rows of a single tree list which is parsed in one piece (in parallel)
+struct InitTreeChunk {
+    const CSVFile *file;
+    int begin, end; ///< rows [begin, end)
+    int iID, iX, iY, iBhd, iHeight, iSpecies, iAge; ///< column indices
+    const SpeciesSet *species_set;
+    QVector<InitTreeRecord> *records;
+};
+
+static void nc_parseInitTrees(InitTreeChunk &chunk)
+{
+    bool ok;
+    for (int i=chunk.begin; i<chunk.end; ++i) {
+        const QStringList values = chunk.file->rowValues(i);
+        InitTreeRecord &r = (*chunk.records)[i];
+        r.dbh = values[chunk.iBhd].toDouble();
+        r.pos = QPointF(values[chunk.iX].toDouble(), values[chunk.iY].toDouble());
+        r.id = chunk.iID>=0 ? values[chunk.iID].toInt() : -1;
+        r.height = values[chunk.iHeight].toDouble();
+        r.age = 0; r.age_ok = false;
+        if (chunk.iAge>=0)
+            r.age = values[chunk.iAge].toInt(&r.age_ok);
+        r.picus_id = -1;
+        r.species_id = values[chunk.iSpecies];
+        int picusid = r.species_id.toInt(&ok);
+        if (ok) {
+            int idx = picusSpeciesIds.indexOf(picusid);
+            if (idx==-1) {
+                r.picus_id = picusid;
+                r.species = nullptr;
+                continue;
+            }
+            r.species_id = iLandSpeciesIds[idx];
+        }
+        r.species = chunk.species_set->species(r.species_id);
+    }
+}
+
 StandLoader::~StandLoader()
 {
     if (mRandom)
@@ -385,55 +435,60 @@ int StandLoader::loadSingleTreeList(QStringList content, ResourceUnit *ru_offset
     if (iX==-1 || iY==-1 || iBhd==-1 || iSpecies==-1 || iHeight==-1)
         throw IException(QString("Initfile %1 is not valid!\nRequired columns are: x,y, bhdfrom or dbh, species, treeheight or height.").arg(fileName));
 
-    double dbh;
-    bool ok;
-    int cnt=0;
-    QString speciesid;
-    for (int i=0;i<infile.rowCount();i++) {
-        dbh = infile.value(i, iBhd).toDouble();
-
-        QPointF f;
-        f.setX( infile.value(i, iX).toDouble() );
-        f.setY( infile.value(i, iY).toDouble() );
-        f += offset; // if the input is relative to a given resource unit
-
+    // (1) parse the rows in parallel (blocks of rows)
+    QVector<InitTreeRecord> records(infile.rowCount());
+    QVector<InitTreeChunk> chunks;
+    const int chunk_size = 10000;
+    for (int i=0;i<infile.rowCount();i+=chunk_size) {
+        InitTreeChunk c = { &infile, i, qMin(i+chunk_size, infile.rowCount()), iID, iX, iY, iBhd, iHeight, iSpecies, iAge, speciesSet, &records };
+        chunks.push_back(c);
+    }
+    mModel->threadExec().run(nc_parseInitTrees, chunks);
+
+    // (2) find the resource units, and reserve memory for the trees
+    QVector<ResourceUnit*> tree_ru(records.size(), nullptr);
+    QHash<ResourceUnit*, int> ru_count;
+    for (int i=0;i<records.size();++i) {
+        QPointF f = records[i].pos + offset; // if the input is relative to a given resource unit
+        records[i].pos = f;
         // position valid?
         if (!rugrid.coordValid(f))
             continue;
-
         if (!mModel->heightGrid()->valueAt(f).isValid())
             continue;
-
         // get resource unit
-        ru = rugrid.constValueAt(f);
+        tree_ru[i] = rugrid.constValueAt(f);
+        if (tree_ru[i])
+            ru_count[tree_ru[i]]++;
+    }
+    for (QHash<ResourceUnit*, int>::const_iterator it=ru_count.constBegin(); it!=ru_count.constEnd(); ++it)
+        it.key()->trees().reserve(it.key()->trees().count() + it.value());
+
+    // (3) create the trees (in the order of the file)
+    int cnt=0;
+    for (int i=0;i<records.size();i++) {
+        ru = tree_ru[i];
         if (!ru)
             continue;
+        const InitTreeRecord &r = records[i];
 
         Tree &tree = ru->newTree();
-        tree.setPosition(f);
+        tree.setPosition(r.pos);
         if (iID>=0)
-            tree.setId(infile.value(i, iID).toInt());
+            tree.setId(r.id);
 
-        tree.setDbh(dbh);
-        tree.setHeight(infile.value(i,iHeight).toDouble()/height_conversion); // convert from Picus-cm to m if necessary
+        tree.setDbh(r.dbh);
+        tree.setHeight(r.height/height_conversion); // convert from Picus-cm to m if necessary
 
-        speciesid = infile.value(i,iSpecies).toString();
-        int picusid = speciesid.toInt(&ok);
-        if (ok) {
-            int idx = picusSpeciesIds.indexOf(picusid);
-            if (idx==-1)
-                throw IException(QString("Loading init-file: invalid Picus-species-id. Species: %1").arg(picusid));
-            speciesid = iLandSpeciesIds[idx];
-        }
-        Species *s = speciesSet->species(speciesid);
-        if (!ru || !s)
-            throw IException(QString("Loading init-file: either resource unit or species invalid. Species: %1").arg(speciesid));
-        tree.setSpecies(s);
+        if (r.picus_id>=0)
+            throw IException(QString("Loading init-file: invalid Picus-species-id. Species: %1").arg(r.picus_id));
+        if (!r.species)
+            throw IException(QString("Loading init-file: either resource unit or species invalid. Species: %1").arg(r.species_id));
+        tree.setSpecies(r.species);
 
-        ok = true;
         if (iAge>=0)
-           tree.setAge(infile.value(i, iAge).toInt(&ok), tree.height()); // this is a *real* age
-        if (iAge<0 || !ok || tree.age()==0)
+           tree.setAge(r.age, tree.height()); // this is a *real* age
+        if (iAge<0 || !r.age_ok || tree.age()==0)
            tree.setAge(0, tree.height()); // no real tree age available
 
         tree.setRU(ru);
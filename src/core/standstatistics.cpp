@@ -21,6 +21,8 @@
   @ingroup tools
   Collects information on stand level for each tree species.
   Call clear() to clear the statistics, then call add() for each tree and finally calculate().
+  Trees that are removed (harvest, disturbances) are subtracted with remove(); this works also for
+  statistics that are already calculated (e.g. during management at the start of the year).
   To aggregate on a higher level, use add() for each StandStatistics object to include, and then
   calculate() on the higher level.
   Todo-List for new items:
@@ -36,9 +38,12 @@
 #include "saplings.h"
 #include "species.h"
 
+bool StandStatistics::mValidationMode = false;
+
 void StandStatistics::clear()
 {
     // reset all values
+    mCalculated = false;
     mCount = 0;
     mSumDbh=mSumHeight = mAverageDbh=mAverageHeight =0.;
     mSumBasalArea = mSumVolume = mGWL = 0.;
@@ -80,24 +85,56 @@ void StandStatistics::addBiomass(const double biomass, const double CNRatio, dou
     *N+=biomass*biomassCFraction/CNRatio;
 }
 
+void StandStatistics::addTree(const Tree *tree, const double sign)
+{
+    // if the statistics are already calculated, the tree is scaled in the same way as in calculate()
+    double area_factor = 1.;
+    double lai_factor = 1.;
+    if (mCalculated && mRUS && mRUS->ru()->stockableArea()>0.) {
+        area_factor = cRUArea / mRUS->ru()->stockableArea();
+        lai_factor = 1. / mRUS->ru()->stockableArea();
+    }
+    const double f = sign * area_factor;
+    mCount += f;
+    mSumDbh += tree->dbh() * f;
+    mSumHeight += tree->height() * sign;
+    mSumBasalArea += tree->basalArea() * f;
+    mSumVolume += tree->volume() * f;
+    mLeafAreaIndex += tree->leafArea() * sign * lai_factor; // warning: sum of leafarea (before calculate())!
+    // carbon and nitrogen pools
+    addBiomass(tree->biomassStem() * f, tree->species()->cnWood(), &mCStem, &mNStem);
+    addBiomass(tree->biomassBranch() * f, tree->species()->cnWood(), &mCBranch, &mNBranch);
+    addBiomass(tree->biomassFoliage() * f, tree->species()->cnFoliage(), &mCFoliage, &mNFoliage);
+    addBiomass(tree->biomassFineRoot() * f, tree->species()->cnFineroot(), &mCFineRoot, &mNFineRoot);
+    addBiomass(tree->biomassCoarseRoot() * f, tree->species()->cnWood(), &mCCoarseRoot, &mNCoarseRoot);
+
+    if (mCount < 0.5 * area_factor) {
+        // the last tree is removed: reset the sums (avoid rounding errors, e.g. a tiny leaf area)
+        double removed_volume = mGWL + tree->volume() * f; // as for other trees (see below)
+        clearOnlyTrees();
+        if (mCalculated)
+            mGWL = removed_volume;
+        return;
+    }
+    if (mCalculated) {
+        mGWL += tree->volume() * f;
+        mAverageDbh = mSumDbh / mCount;
+        mAverageHeight = mSumHeight / (mCount / area_factor);
+    }
+}
+
 void StandStatistics::add(const Tree *tree, const TreeGrowthData *tgd)
 {
-    mCount++;
-    mSumDbh+=tree->dbh();
-    mSumHeight+=tree->height();
-    mSumBasalArea+=tree->basalArea();
-    mSumVolume += tree->volume();
-    mLeafAreaIndex += tree->leafArea(); // warning: sum of leafarea!
+    addTree(tree, 1.);
     if (tgd) {
         mNPP += tgd->NPP;
         mNPPabove += tgd->NPP_above;
     }
-    // carbon and nitrogen pools
-    addBiomass(tree->biomassStem(), tree->species()->cnWood(), &mCStem, &mNStem);
-    addBiomass(tree->biomassBranch(), tree->species()->cnWood(), &mCBranch, &mNBranch);
-    addBiomass(tree->biomassFoliage(), tree->species()->cnFoliage(), &mCFoliage, &mNFoliage);
-    addBiomass(tree->biomassFineRoot(), tree->species()->cnFineroot(), &mCFineRoot, &mNFineRoot);
-    addBiomass(tree->biomassCoarseRoot(), tree->species()->cnWood(), &mCCoarseRoot, &mNCoarseRoot);
+}
+
+void StandStatistics::remove(const Tree *tree)
+{
+    addTree(tree, -1.);
 }
 
 void StandStatistics::addNPP(const TreeGrowthData *tgd)
@@ -111,6 +148,7 @@ void StandStatistics::addNPP(const TreeGrowthData *tgd)
 // note: mRUS = 0 for aggregated statistics
 void StandStatistics::calculate()
 {
+    mCalculated = true;
     if (mCount>0.) {
         mAverageDbh = mSumDbh / mCount;
         mAverageHeight = mSumHeight / mCount;
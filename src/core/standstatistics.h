@@ -34,12 +34,17 @@ public:
     void addAreaWeighted(const StandStatistics &stat, const double weight); ///< add aggregates of @p stat to this aggregate and scale using the weight (e.g. stockable area)
     void add(const Tree *tree, const TreeGrowthData *tgd); ///< call for each tree within the domain
     void addNPP(const TreeGrowthData *tgd); ///< add only the NPP
+    void remove(const Tree *tree); ///< remove the contribution of a tree (e.g. harvested or killed by disturbances) from the statistics
 
     void add(const SaplingStat *sapling); ///< call for regeneration layer of a species in resource unit
     void clear(); ///< call before trees are aggregated
     void clearOnlyTrees(); ///< clear the statistics only for tree biomass (keep NPP, regen, ...)
     void calculate(); ///< call after all trees are processed (postprocessing)
     void calculateAreaWeighted(); ///< call after a series of addAreaWeighted
+    bool isCalculated() const { return mCalculated; } ///< true after calculate(), i.e. the values are scaled to per ha
+    /// if validation mode is enabled, the incrementally updated statistics are compared to statistics re-built from all trees (system.settings.standStatisticsValidation)
+    static void setValidationMode(const bool validate) { mValidationMode = validate; }
+    static bool validationMode() { return mValidationMode; }
     // getters
     double count() const { return mCount; }
     double dbh_avg() const { return mAverageDbh; } ///< average dbh (cm)
@@ -74,7 +79,10 @@ public:
 
 private:
     inline void addBiomass(const double biomass, const double CNRatio, double *C, double *N);
+    void addTree(const Tree *tree, const double sign); ///< add (sign=1) or remove (sign=-1) the state of a tree
+    static bool mValidationMode;
     const ResourceUnitSpecies *mRUS; ///< link to the resource unit species
+    bool mCalculated; ///< true if calculate() was already called (values per ha)
     double mCount;
     double mSumDbh;
     double mSumHeight;
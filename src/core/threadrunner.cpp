@@ -26,6 +26,8 @@
 
 #include "global.h"
 #include "threadrunner.h"
+#include "resourceunit.h"
+#include "logqueue.h"
 #include <QtCore>
 #include <QtConcurrent/QtConcurrent>
 bool ThreadRunner::mMultithreaded = true; // static
@@ -60,27 +62,59 @@ void ThreadRunner::setup(const QList<ResourceUnit*> &resourceUnitList)
 }
 
 /// run a given function for each ressource unit either multithreaded or not.
+/// Log messages written by 'funcptr' carry the index of the resource unit (see LogContext).
 void ThreadRunner::run(void (*funcptr)(ResourceUnit *), const bool forceSingleThreaded ) const
 {
+    auto func = [funcptr](ResourceUnit *unit) { LogContext context(unit->index()); (*funcptr)(unit); };
     if (mMultithreaded && mMap1.count() > 3 && forceSingleThreaded==false) {
         // execute using QtConcurrent for larger amounts of ressource units...
         mState = MultiThreaded;
-        QtConcurrent::blockingMap(mMap1,funcptr);
-        QtConcurrent::blockingMap(mMap2,funcptr);
+        QtConcurrent::blockingMap(mMap1,func);
+        QtConcurrent::blockingMap(mMap2,func);
     } else {
         // execute serialized in main thread
         mState = SingleThreaded;
         ResourceUnit *unit;
         foreach(unit, mMap1)
-            (*funcptr)(unit);
+            func(unit);
 
         foreach(unit, mMap2)
-            (*funcptr)(unit);
+            func(unit);
     }
     mState = Inactive;
 
 }
 
+/// run a given function for the active resource units. The split in two lists (even/odd) is
+/// preserved, i.e. also for a subset of resource units directly neighboring units are not processed concurrently.
+int ThreadRunner::run(void (*funcptr)(ResourceUnit *), const QVector<bool> &active, const bool forceSingleThreaded) const
+{
+    QList<ResourceUnit*> map1, map2;
+    foreach(ResourceUnit *unit, mMap1)
+        if (active[unit->index()])
+            map1.append(unit);
+    foreach(ResourceUnit *unit, mMap2)
+        if (active[unit->index()])
+            map2.append(unit);
+
+    auto func = [funcptr](ResourceUnit *unit) { LogContext context(unit->index()); (*funcptr)(unit); };
+    if (mMultithreaded && map1.count() > 3 && forceSingleThreaded==false) {
+        mState = MultiThreaded;
+        QtConcurrent::blockingMap(map1,func);
+        QtConcurrent::blockingMap(map2,func);
+    } else {
+        mState = SingleThreaded;
+        ResourceUnit *unit;
+        foreach(unit, map1)
+            func(unit);
+
+        foreach(unit, map2)
+            func(unit);
+    }
+    mState = Inactive;
+    return map1.count() + map2.count();
+}
+
 /// run a given function for each species
 void ThreadRunner::run(void (*funcptr)(Species *), const bool forceSingleThreaded ) const
 {
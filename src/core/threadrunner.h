@@ -38,6 +38,9 @@ public:
     void print(); ///< print useful debug messages
     // actions
     void run( void (*funcptr)(ResourceUnit*), const bool forceSingleThreaded=false ) const; ///< execute 'funcptr' for all resource units in parallel
+    /// execute 'funcptr' in parallel for the subset of resource units flagged in 'active' (index: ResourceUnit::index()).
+    /// Returns the number of processed resource units.
+    int run( void (*funcptr)(ResourceUnit*), const QVector<bool> &active, const bool forceSingleThreaded=false ) const;
     void run( void (*funcptr)(Species*), const bool forceSingleThreaded=false ) const; ///< execute 'funcptr' for set of species in parallel
     // run over elements of a vector of type T
     template<class T> void run(T* (*funcptr)(T*), const QVector<T*> &container, const bool forceSingleThreaded=false) const;
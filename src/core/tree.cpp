@@ -994,13 +994,18 @@ inline double Tree::relative_height_growth()
 }
 
 /** This function is called if a tree dies.
+  The tree is removed from the stand statistics, unless it dies during growth (@p d is not null), i.e.
+  before it is added to the statistics of the current year.
   @sa ResourceUnit::cleanTreeList(), remove() */
 void Tree::die(TreeGrowthData *d)
 {
+    const bool was_alive = !isDead();
     setFlag(Tree::TreeDead, true); // set flag that tree is dead
     mRU->treeDied();
     ResourceUnitSpecies &rus = mRU->resourceUnitSpecies(species());
-    rus.statisticsDead().add(this, d); // add tree to statistics
+    rus.statisticsDead().add(this, nullptr); // add tree to statistics
+    if (was_alive && !d)
+        rus.statistics().remove(this);
     notifyTreeRemoved(TreeDeath);
     if (ru()->snag())
         ru()->snag()->addMortality(this);
@@ -1009,11 +1014,14 @@ void Tree::die(TreeGrowthData *d)
 /// remove a tree (most likely due to harvest) from the system.
 void Tree::remove(double removeFoliage, double removeBranch, double removeStem )
 {
+    const bool was_alive = !isDead();
     setFlag(Tree::TreeDead, true); // set flag that tree is dead
     setIsHarvested();
     mRU->treeDied();
     ResourceUnitSpecies &rus = mRU->resourceUnitSpecies(species());
     rus.statisticsMgmt().add(this, nullptr);
+    if (was_alive)
+        rus.statistics().remove(this);
     if (isCutdown())
         notifyTreeRemoved(TreeCutDown);
     else
@@ -1034,10 +1042,13 @@ void Tree::removeDisturbance(const double stem_to_soil_fraction,
                              const double branch_to_snag_fraction,
                              const double foliage_to_soil_fraction)
 {
+    const bool was_alive = !isDead();
     setFlag(Tree::TreeDead, true); // set flag that tree is dead
     mRU->treeDied();
     ResourceUnitSpecies &rus = mRU->resourceUnitSpecies(species());
     rus.statisticsDead().add(this, nullptr);
+    if (was_alive)
+        rus.statistics().remove(this);
     notifyTreeRemoved(TreeDisturbance);
 
     if (saps)
@@ -1055,6 +1066,10 @@ void Tree::removeDisturbance(const double stem_to_soil_fraction,
 /// remove a part of the biomass of the tree, e.g. due to fire.
 void Tree::removeBiomassOfTree(const double removeFoliageFraction, const double removeBranchFraction, const double removeStemFraction)
 {
+    // update the stand statistics: remove the tree, and add it again with the reduced biomass
+    StandStatistics &stat = mRU->resourceUnitSpecies(species()).statistics();
+    if (!isDead())
+        stat.remove(this);
     mFoliageMass *= static_cast<float>(1. - removeFoliageFraction);
     mStemMass *= static_cast<float>(1. - removeStemFraction);
     mBranchMass *= static_cast<float>(1. - removeBranchFraction);
@@ -1065,14 +1080,21 @@ void Tree::removeBiomassOfTree(const double removeFoliageFraction, const double
         //if (removeFoliageFraction==1.)
         //    m_statAboveZ = mId; // temp
     }
+    if (!isDead())
+        stat.add(this, nullptr);
 }
 
 void Tree::removeRootBiomass(const double removeFineRootFraction, const double removeCoarseRootFraction)
 {
     float remove_fine_roots = mFineRootMass * static_cast<float>(removeFineRootFraction);
     float remove_coarse_roots = mCoarseRootMass * static_cast<float>(removeCoarseRootFraction);
+    StandStatistics &stat = mRU->resourceUnitSpecies(species()).statistics();
+    if (!isDead())
+        stat.remove(this);
     mFineRootMass -= remove_fine_roots;
     mCoarseRootMass -= remove_coarse_roots;
+    if (!isDead())
+        stat.add(this, nullptr);
     // remove also the same amount as the fine root removal from the reserve pool
     mNPPReserve = qMax(mNPPReserve - remove_fine_roots, 0.f);
     if (ru()->snag())
@@ -1091,10 +1113,11 @@ void Tree::setHeight(const float height)
 void Tree::mortality(TreeGrowthData &d)
 {
     // death if leaf area is 0 or if stem biomass is 0
+    // note: the tree is not yet part of the stand statistics (see die())
     if (mFoliageMass<0.00001f)
-        die();
+        die(&d);
     if (mStemMass == 0.f)
-        die();
+        die(&d);
 
     double p_death,  p_stress, p_intrinsic;
     p_intrinsic = species()->deathProb_intrinsic();
@@ -1103,7 +1126,7 @@ void Tree::mortality(TreeGrowthData &d)
     double p = drandom(); //0..1
     if (p<p_death) {
         // die...
-        die();
+        die(&d);
     }
 }
 
@@ -1112,7 +1135,7 @@ void Tree::altMortality(TreeGrowthData &d)
 {
     // death if leaf area is 0
     if (mFoliageMass<0.00001)
-        die();
+        die(&d);
 
     double  p_intrinsic, p_stress=0.;
     p_intrinsic = species()->deathProb_intrinsic();
@@ -1127,7 +1150,7 @@ void Tree::altMortality(TreeGrowthData &d)
     double p = drandom(); //0..1
     if (p<p_intrinsic + p_stress) {
         // die...
-        die();
+        die(&d);
     }
 }
 #endif
@@ -33,6 +33,7 @@ class Species;
 class Stamp;
 class ResourceUnit;
 struct HeightGridValue;
+class DebugList;
 struct TreeGrowthData;
 class TreeOut;
 class TreeRemovedOut;
@@ -81,7 +82,7 @@ public:
 
     // actions
     enum TreeRemovalType { TreeDeath=0, TreeHarvest=1, TreeDisturbance=2, TreeSalavaged=3, TreeKilled=4, TreeCutDown=5};
-    /// the tree dies (is killed)
+    /// the tree dies (is killed). @p d is only provided when the tree dies during growth (mortality)
     void die(TreeGrowthData *d=nullptr);
     /// remove the tree (management). removalFractions for tree compartments: if 0: all biomass stays in the system, 1: all is "removed"
     /// default values: all biomass remains in the forest (i.e.: kill()).
@@ -166,7 +167,7 @@ public:
 #endif
 
     QString dump();
-    void dumpList(QList<QVariant> &rTargetList);
+    void dumpList(DebugList &rTargetList);
     const Stamp *stamp() const { return mStamp; } ///< TODO: only for debugging purposes
 
 private:
@@ -0,0 +1,145 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#include "gridtilecache.h"
+#include "globalsettings.h"
+#include "viewport.h"
+
+#include <QPainter>
+#include <QHash>
+
+/** @class GridTileCache
+  @ingroup GUI
+  The GridTileCache is the render layer for (large) grids in the GUI. Instead of painting each cell with
+  a separate fillRect() call on every repaint, the grid is split into tiles of 'tile_size' x 'tile_size' cells.
+  Each tile is rasterized into an image with one pixel per cell, and a pyramid of down-sampled images
+  (each level halves the resolution) is stored along with it. When drawing, only visible tiles are painted,
+  using the level whose pixels are closest to (but not smaller than) a screen pixel.
+
+  Tiles are rebuilt if the 'style' (i.e. the grid, the color mapping, shading, ...) changes. Additionally,
+  once per simulation year (or after invalidate()), the cell values of each tile are hashed, and only tiles with
+  changed values are rasterized again. Panning and zooming therefore only blit the cached images.
+  */
+
+void GridTileCache::clear()
+{
+    mTiles.clear();
+    mStyle.clear();
+    mSizeX = mSizeY = 0;
+    mYear = -1;
+    mValid = false;
+}
+
+void GridTileCache::setupTiles(const QRectF &metric_rect, const int size_x, const int size_y)
+{
+    mTiles.clear();
+    mMetricRect = metric_rect;
+    mSizeX = size_x;
+    mSizeY = size_y;
+    if (size_x<=0 || size_y<=0)
+        return;
+    double cell_x = metric_rect.width() / size_x;
+    double cell_y = metric_rect.height() / size_y;
+    for (int y=0; y<size_y; y+=mTileSize) {
+        for (int x=0; x<size_x; x+=mTileSize) {
+            Tile tile;
+            tile.cells = QRect(x, y, qMin(mTileSize, size_x - x), qMin(mTileSize, size_y - y));
+            tile.metric = QRectF(metric_rect.left() + x*cell_x, metric_rect.top() + y*cell_y,
+                                 tile.cells.width()*cell_x, tile.cells.height()*cell_y);
+            mTiles.push_back(tile);
+        }
+    }
+}
+
+void GridTileCache::buildTile(Tile &tile, const QVector<double> &values, const ColorFunction &color_func) const
+{
+    const int w = tile.cells.width();
+    const int h = tile.cells.height();
+    double cell_x = tile.metric.width() / w;
+    double cell_y = tile.metric.height() / h;
+    QImage img(w, h, QImage::Format_RGB32);
+    const double *v = values.constData();
+    for (int iy=0; iy<h; ++iy) {
+        // the image is stored top-down, the grid bottom-up
+        QRgb *line = reinterpret_cast<QRgb*>(img.scanLine(h - 1 - iy));
+        double y = tile.metric.top() + (iy + 0.5)*cell_y;
+        for (int ix=0; ix<w; ++ix, ++v)
+            line[ix] = color_func(*v, QPointF(tile.metric.left() + (ix + 0.5)*cell_x, y));
+    }
+
+    // build the pyramid: halve the resolution until a single pixel is reached
+    tile.levels.clear();
+    tile.levels.push_back(img);
+    int lw=w, lh=h;
+    while (lw>1 || lh>1) {
+        lw = qMax((lw + 1) / 2, 1);
+        lh = qMax((lh + 1) / 2, 1);
+        tile.levels.push_back(tile.levels.last().scaled(lw, lh, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+    }
+}
+
+int GridTileCache::update(const QRectF &metric_rect, const int size_x, const int size_y, const QString &style,
+                          const ValueFunction &value_func, const ColorFunction &color_func)
+{
+    int year = GlobalSettings::instance()->currentYear();
+    if (style != mStyle || metric_rect != mMetricRect || size_x != mSizeX || size_y != mSizeY) {
+        // a different grid or color mapping: rebuild everything
+        setupTiles(metric_rect, size_x, size_y);
+        mStyle = style;
+        mValid = false;
+    }
+    if (mValid && year == mYear)
+        return 0;
+
+    int n_rebuilt = 0;
+    QVector<double> values;
+    for (int i=0; i<mTiles.size(); ++i) {
+        Tile &tile = mTiles[i];
+        values.resize(tile.cells.width() * tile.cells.height());
+        double *v = values.data();
+        for (int iy=tile.cells.top(); iy<=tile.cells.bottom(); ++iy)
+            for (int ix=tile.cells.left(); ix<=tile.cells.right(); ++ix, ++v)
+                *v = value_func(ix, iy);
+
+        uint hash = qHashBits(values.constData(), static_cast<size_t>(values.size()) * sizeof(double));
+        if (tile.levels.isEmpty() || hash != tile.hash) {
+            buildTile(tile, values, color_func);
+            tile.hash = hash;
+            ++n_rebuilt;
+        }
+    }
+    mYear = year;
+    mValid = true;
+    return n_rebuilt;
+}
+
+void GridTileCache::draw(QPainter &painter, Viewport &vp) const
+{
+    for (int i=0; i<mTiles.size(); ++i) {
+        const Tile &tile = mTiles[i];
+        if (tile.levels.isEmpty() || !vp.isVisible(tile.metric))
+            continue;
+        QRect target = vp.toScreen(tile.metric);
+        // select the coarsest level with (at least) one screen pixel per image pixel
+        double px_per_cell = target.width() / static_cast<double>(tile.cells.width());
+        int level = 0;
+        while (level + 1 < tile.levels.size() && px_per_cell * (1 << (level+1)) <= 1.)
+            ++level;
+        painter.drawImage(target, tile.levels[level]);
+    }
+}
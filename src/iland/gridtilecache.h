@@ -0,0 +1,74 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#ifndef GRIDTILECACHE_H
+#define GRIDTILECACHE_H
+
+#include <QImage>
+#include <QVector>
+#include <QRectF>
+#include <functional>
+
+class QPainter;
+class Viewport;
+
+/** GridTileCache rasterizes a grid into cached image tiles with a pyramid of resolutions.
+  Tiles are only rebuilt if the style or the underlying data changed, and are drawn
+  with a single drawImage() call per visible tile.
+  */
+class GridTileCache
+{
+public:
+    /// function that returns the value of the cell (ix, iy)
+    typedef std::function<double(int, int)> ValueFunction;
+    /// function that returns the color of a cell for a given value and the metric coordinates of the cell center
+    typedef std::function<QRgb(double, const QPointF&)> ColorFunction;
+
+    GridTileCache(const int tile_size=256): mTileSize(tile_size), mSizeX(0), mSizeY(0), mYear(-1), mValid(false) {}
+    /// update the tiles for a grid with 'size_x' x 'size_y' cells covering 'metric_rect'.
+    /// 'style' identifies the color mapping (and the grid): a change of the style rebuilds all tiles.
+    /// Otherwise, data of the tiles is checked only once per simulation year (or after invalidate()).
+    /// Returns the number of rebuilt tiles.
+    int update(const QRectF &metric_rect, const int size_x, const int size_y, const QString &style,
+               const ValueFunction &value_func, const ColorFunction &color_func);
+    /// draw the visible tiles using the level of detail that matches the current zoom level of 'vp'.
+    void draw(QPainter &painter, Viewport &vp) const;
+    /// check the data of all tiles during the next update()
+    void invalidate() { mValid = false; }
+    /// remove all tiles
+    void clear();
+private:
+    struct Tile {
+        Tile(): hash(0) {}
+        QRect cells; ///< cells (index) covered by the tile
+        QRectF metric; ///< metric extent of the tile
+        QVector<QImage> levels; ///< level 0: one pixel per cell, level n: one pixel per 2^n x 2^n cells
+        uint hash; ///< hash of the cell values used to build the tile
+    };
+    void setupTiles(const QRectF &metric_rect, const int size_x, const int size_y);
+    void buildTile(Tile &tile, const QVector<double> &values, const ColorFunction &color_func) const;
+    int mTileSize; ///< number of cells per tile (in x and y direction)
+    QVector<Tile> mTiles;
+    QRectF mMetricRect;
+    int mSizeX, mSizeY;
+    QString mStyle;
+    int mYear; ///< simulation year of the last data check
+    bool mValid;
+};
+
+#endif // GRIDTILECACHE_H
@@ -161,7 +161,9 @@ SOURCES += main.cpp \
     ../tools/geotiff.cpp \
     mainwindow.cpp \
     paintarea.cpp \
+    gridtilecache.cpp \
     ../core/grid.cpp \
+    ../core/allometrytable.cpp \
     ../core/tree.cpp \
     ../tools/expression.cpp \
     ../tools/helper.cpp \
@@ -189,6 +191,7 @@ SOURCES += main.cpp \
     ../core/standstatistics.cpp \
     ../output/dynamicstandout.cpp \
     ../output/customaggout.cpp \
+    ../output/fieldaggregator.cpp \
     ../core/management.cpp \
     ../core/speciesresponse.cpp \
     ../core/climate.cpp \
@@ -211,6 +214,7 @@ SOURCES += main.cpp \
     ../core/seeddispersal.cpp \
     ../core/establishment.cpp \
     ../core/soil.cpp \
+    ../core/soilspinup.cpp \
     ../core/snag.cpp \
     ../output/saplingout.cpp \
     ../tools/gisgrid.cpp \
@@ -221,12 +225,14 @@ SOURCES += main.cpp \
     ../tools/dem.cpp \
     ../3rdparty/SimpleRNG.cpp \
     ../output/snapshot.cpp \
+    ../output/checkpoint.cpp \
     ../tools/randomgenerator.cpp \
     ../tools/spatialanalysis.cpp \
     ../abe/activity.cpp \
     ../abe/forestmanagementengine.cpp \
     ../tools/statdata.cpp \
     ../tools/debugtimer.cpp \
+    ../tools/logqueue.cpp \
     ../tools/viewport.cpp \
     ../abe/fomewrapper.cpp \
     ../abe/fmstand.cpp \
@@ -297,8 +303,10 @@ HEADERS += mainwindow.h \
     ../tools/geotiff.h \
     stable.h \
     paintarea.h \
+    gridtilecache.h \
     ../core/version.h \
     ../core/grid.h \
+    ../core/allometrytable.h \
     ../core/tree.h \
     ../tools/expression.h \
     ../tools/helper.h \
@@ -328,6 +336,7 @@ HEADERS += mainwindow.h \
     ../core/standstatistics.h \
     ../output/dynamicstandout.h \
     ../output/customaggout.h \
+    ../output/fieldaggregator.h \
     ../core/management.h \
     ../core/speciesresponse.h \
     ../core/climate.h \
@@ -350,6 +359,7 @@ HEADERS += mainwindow.h \
     ../core/seeddispersal.h \
     ../core/establishment.h \
     ../core/soil.h \
+    ../core/soilspinup.h \
     ../core/snag.h \
     ../output/saplingout.h \
     ../tools/gisgrid.h \
@@ -362,6 +372,7 @@ HEADERS += mainwindow.h \
     ../core/layeredgrid.h \
     ../3rdparty/SimpleRNG.h \
     ../output/snapshot.h \
+    ../output/checkpoint.h \
     ../tools/randomgenerator.h \
     ../tools/spatialanalysis.h \
     ../abe/activity.h \
@@ -369,6 +380,7 @@ HEADERS += mainwindow.h \
     ../abe/abe_global.h \
     ../tools/statdata.h \
     ../tools/debugtimer.h \
+    ../tools/logqueue.h \
     ../tools/viewport.h \
     ../abe/fomewrapper.h \
     ../abe/fmstand.h \
@@ -594,8 +594,8 @@ QString MainWindow::dumpTreelist()
         treelist.clear();
         tree->dumpList(treelist);
         line = "";
-        foreach(QVariant value, treelist)
-            line+=value.toString() + ";";
+        foreach(const QString &value, treelist.toStringList())
+            line+=value + ";";
         result << line;
     }
     QString resStr = result.join("\n");
@@ -760,6 +760,7 @@ void MainWindow::setPaintGrid(const QString grid_name)
         throw IException(QString("The name '%1' is not a valid name for a grid (use <category> - <name>, e.g. 'wind - basalArea'!").arg(grid_name));
     PaintObject &po = mPaintList[grid_name];
     mPaintNext = po;
+    mGridTiles.invalidate();
 
 }
 
@@ -775,6 +776,7 @@ void MainWindow::paintGrid(MapGrid *map_grid, const QString &name,
         return;
     }
     mPaintNext.what=PaintObject::PaintMapGrid;
+    mGridTiles.invalidate();
     mPaintNext.min_value=min_val; mPaintNext.max_value=max_val;
     mPaintNext.map_grid = map_grid; mPaintNext.view_type = view_type;
     if (!name.isEmpty()) {
@@ -800,6 +802,7 @@ void MainWindow::paintGrid(const FloatGrid *grid, const QString &name,
         return;
     }
     mPaintNext.what=PaintObject::PaintFloatGrid;
+    mGridTiles.invalidate();
     mPaintNext.min_value=min_val;
     mPaintNext.max_value=max_val;
     mPaintNext.float_grid = grid;
@@ -826,6 +829,7 @@ void MainWindow::paintGrid(const Grid<double> *grid, const QString &name, const
         return;
     }
     mPaintNext.what=PaintObject::PaintDoubleGrid;
+    mGridTiles.invalidate();
     mPaintNext.min_value=min_val;
     mPaintNext.max_value=max_val;
     mPaintNext.dbl_grid = grid;
@@ -922,6 +926,7 @@ void MainWindow::paintFON(QPainter &painter, QRect rect)
                 mPaintNext.dbl_grid = mRemoteControl.preparePaintGrid(mPaintNext.handler, mPaintNext.expression, &names_colors);
                 if (!mPaintNext.dbl_grid)
                     return; // no painting
+                mGridTiles.invalidate(); // the content of the grid is re-created for each repaint
                 if (mPaintNext.view_type == GridViewCustom) {
                     // custom colors and names
                     mRulerColors->setFactorColors(names_colors.second);
@@ -967,7 +972,6 @@ void MainWindow::paintFON(QPainter &painter, QRect rect)
     if (ui->speciesFilterBox->currentIndex()>-1)
         species = ui->speciesFilterBox->itemData(ui->speciesFilterBox->currentIndex()).toString();
 
-    int ix,iy;
     QColor fill_color;
     float value;
 
@@ -1141,35 +1145,35 @@ void MainWindow::paintFON(QPainter &painter, QRect rect)
             // min_val = static_cast<float>( mRulerColors->minValue() );
             max_val = static_cast<float>( mRulerColors->maxValue() );
         }
-        for (iy=0;iy<domGrid->sizeY();iy++) {
-            for (ix=0;ix<domGrid->sizeX();ix++) {
-                QPoint p(ix,iy);
-                const HeightGridValue &hgv = domGrid->valueAtIndex(p);
-                if (hgv.isValid()) {
-                    value = stem_height ? domGrid->valueAtIndex(p).stemHeight() : domGrid->valueAtIndex(p).height;
-                    QRect r = vp.toScreen(domGrid->cellRect(p));
-                    fill_color = Colors::colorFromValue(value, 0., max_val); // 0..50m
-                    if (shading)
-                        fill_color = Colors::shadeColor(fill_color, domGrid->cellCenterPoint(p), mRemoteControl.model()->dem());
-
-                    painter.fillRect(r, fill_color);
-                } else if (shading) {
-                    // out of project area is not drawn unless shading is enabled
-                    fill_color = Colors::shadeColor(Qt::white, domGrid->cellCenterPoint(p), mRemoteControl.model()->dem());
-                    QRect r = vp.toScreen(domGrid->cellRect(p));
-                    painter.fillRect(r, fill_color);
-                }
-                // areas "outside" are drawn as gray.
-                if (hgv.isForestOutside()) {
-                    QRect r = vp.toScreen(domGrid->cellRect(p));
-                    if (hgv.isRadiating())
-                        painter.fillRect(r, Qt::gray);
-                    else
-                        painter.fillRect(r, QColor(240,240,240));
-
-                }
+        // the value encodes also the state of the pixel: -1: outside of the project area,
+        // -2/-3: forested area outside (radiating/not radiating)
+        auto value_func = [domGrid, stem_height](int ix, int iy) {
+            const HeightGridValue &hgv = domGrid->constValueAtIndex(ix, iy);
+            if (hgv.isForestOutside())
+                return hgv.isRadiating() ? -2. : -3.;
+            if (!hgv.isValid())
+                return -1.;
+            return static_cast<double>(stem_height ? hgv.stemHeight() : hgv.height);
+        };
+        const DEM *dem = mRemoteControl.model()->dem();
+        auto color_func = [=](double value, const QPointF &world) {
+            // areas "outside" are drawn as gray.
+            if (value == -2.)
+                return QColor(Qt::gray).rgb();
+            if (value == -3.)
+                return QColor(240,240,240).rgb();
+            if (value < 0.) {
+                // out of project area is not drawn unless shading is enabled
+                return shading ? Colors::shadeColor(Qt::white, world, dem).rgb() : QColor(Qt::white).rgb();
             }
-        }
+            QColor col = Colors::colorFromValue(value, 0., max_val); // 0..50m
+            if (shading)
+                col = Colors::shadeColor(col, world, dem);
+            return col.rgb();
+        };
+        QString style = QString("dom|%1|%2|%3").arg(stem_height).arg(max_val).arg(shading);
+        mDomTiles.update(domGrid->metricRect(), domGrid->sizeX(), domGrid->sizeY(), style, value_func, color_func);
+        mDomTiles.draw(painter, vp);
 
     } // if (show_dom)
 
@@ -1555,54 +1559,67 @@ void MainWindow::paintGrid(QPainter &painter, PaintObject &object)
 
 
 
-    int ix,iy;
-    double value=0.;
-    QRect r;
-    QColor fill_color;
-    double max_value = -1.;
-    QPointF pmetric;
-    for (iy=0;iy<sy;iy++) {
-        for (ix=0;ix<sx;ix++) {
-            QPoint p(ix,iy);
-            switch(object.what) {
-            case PaintObject::PaintMapGrid:
-                value = object.map_grid->grid().constValueAtIndex(p);
-                pmetric = object.map_grid->grid().cellRect(p).center();
-                r = vp.toScreen(object.map_grid->grid().cellRect(p));
-
-                break;
-            case PaintObject::PaintFloatGrid:
-                value = object.float_grid->constValueAtIndex(p);
-                pmetric = object.float_grid->cellRect(p).center();
-                r = vp.toScreen(object.float_grid->cellRect(p));
-                break;
-            case PaintObject::PaintLayers:
-                value = object.layered->value(ix, iy, object.layer_id);
-                pmetric = object.layered->cellRect(p).center();
-                max_value = qMax(max_value, value);
-                r = vp.toScreen(object.layered->cellRect(p));
-                break;
-            default: ;
-            }
-            if (clip_with_stand_grid && !GlobalSettings::instance()->model()->heightGrid()->valueAt(pmetric).isValid()) {
-                fill_color = Qt::white;
-            } else {
-                fill_color = Colors::colorFromValue(value, object.view_type, object.cur_min_value, object.cur_max_value);
-                if (shading)
-                    fill_color = Colors::shadeColor(fill_color, pmetric, mRemoteControl.model()->dem());
-            }
-            painter.fillRect(r, fill_color);
-        }
+    GridViewType view_type = object.view_type;
+    double min_value = object.cur_min_value;
+    double max_value = object.cur_max_value;
+    const void *grid_ptr = nullptr;
+    QRectF metric_rect;
+    GridTileCache::ValueFunction value_func;
+    switch(object.what) {
+    case PaintObject::PaintMapGrid: {
+        const Grid<int> *int_grid = &object.map_grid->grid();
+        value_func = [int_grid](int ix, int iy) { return static_cast<double>(int_grid->constValueAtIndex(ix, iy)); };
+        grid_ptr = int_grid;
+        metric_rect = int_grid->metricRect();
+        break; }
+    case PaintObject::PaintFloatGrid: {
+        const FloatGrid *float_grid = object.float_grid;
+        value_func = [float_grid](int ix, int iy) { return static_cast<double>(float_grid->constValueAtIndex(ix, iy)); };
+        grid_ptr = float_grid;
+        metric_rect = float_grid->metricRect();
+        break; }
+    case PaintObject::PaintLayers: {
+        const LayeredGridBase *layered = object.layered;
+        int layer_id = object.layer_id;
+        value_func = [layered, layer_id](int ix, int iy) { return layered->value(ix, iy, layer_id); };
+        grid_ptr = layered;
+        metric_rect = layered->metricRect();
+        break; }
+    default: ;
     }
+
+    const HeightGrid *height_grid = GlobalSettings::instance()->model()->heightGrid();
+    const DEM *dem = mRemoteControl.model() ? mRemoteControl.model()->dem() : nullptr;
+    auto color_func = [=](double value, const QPointF &pmetric) {
+        if (clip_with_stand_grid && !height_grid->valueAt(pmetric).isValid())
+            return QColor(Qt::white).rgb();
+        QColor fill_color = Colors::colorFromValue(value, view_type, min_value, max_value);
+        if (shading)
+            fill_color = Colors::shadeColor(fill_color, pmetric, dem);
+        return fill_color.rgb();
+    };
+
+    QString style = QString("%1|%2|%3|%4|%5|%6|%7").arg(reinterpret_cast<quintptr>(grid_ptr)).arg(object.layer_id)
+            .arg(view_type).arg(min_value).arg(max_value).arg(shading).arg(clip_with_stand_grid);
+    int n_rebuilt = mGridTiles.update(metric_rect, sx, sy, style, value_func, color_func);
+    mGridTiles.draw(painter, vp);
+
     painter.setPen(Qt::lightGray);
     painter.drawRect(total_rect);
 
     // update ruler
-    if (object.view_type>=10) {
-        QStringList labels;
-        for (int i=0;i<=max_value;++i)
-            labels.append(object.layered->labelvalue(i,object.layer_id));
-        mRulerColors->setFactorLabels(labels);
+    if (object.what == PaintObject::PaintLayers && object.view_type>=10) {
+        // the labels are derived from the maximum value of the layer (only re-calculated if the tiles changed)
+        if (n_rebuilt>0 || mGridLabels.isEmpty()) {
+            double max_label = -1.;
+            for (int iy=0;iy<sy;iy++)
+                for (int ix=0;ix<sx;ix++)
+                    max_label = qMax(max_label, object.layered->value(ix, iy, object.layer_id));
+            mGridLabels.clear();
+            for (int i=0;i<=max_label;++i)
+                mGridLabels.append(object.layered->labelvalue(i,object.layer_id));
+        }
+        mRulerColors->setFactorLabels(mGridLabels);
     }
     mRulerColors->setPalette(object.view_type, object.cur_min_value, object.cur_max_value); // ruler
 
@@ -1644,12 +1661,6 @@ void MainWindow::paintMapGrid(QPainter &painter,
         }
     }
 
-    // paint the lower-res-grid;
-    int ix,iy;
-    double value;
-    QRect r;
-    QColor fill_color;
-
     if (view_type<10)
         mRulerColors->setPalette(view_type,min_val, max_val); // ruler
     else
@@ -1657,35 +1668,33 @@ void MainWindow::paintMapGrid(QPainter &painter,
 
     bool reverse = view_type == GridViewRainbowReverse || view_type == GridViewGrayReverse;
     bool black_white = view_type == GridViewGray || view_type == GridViewGrayReverse;
-    QPointF world;
-    for (iy=0;iy<sy;iy++) {
-        for (ix=0;ix<sx;ix++) {
-            QPoint p(ix,iy);
-            if (int_grid){
-                value = int_grid->constValueAtIndex(p);
-                r = vp.toScreen(int_grid->cellRect(p));
-                world = int_grid->cellCenterPoint(p);
-            } else if (float_grid) {
-                value = float_grid->constValueAtIndex(p);
-                r = vp.toScreen(float_grid->cellRect(p));
-                world = float_grid->cellCenterPoint(p);
-            } else {
-                value = double_grid->constValueAtIndex(p);
-                r = vp.toScreen(double_grid->cellRect(p));
-                world = double_grid->cellCenterPoint(p);
-            }
-            if (clip_with_stand_grid && !GlobalSettings::instance()->model()->heightGrid()->valueAt(world).isValid()) {
-                fill_color = Qt::white;
-            } else {
-                fill_color = view_type<10? Colors::colorFromValue(value, min_val, max_val, reverse,black_white) : Colors::colorFromPalette(value, view_type);
-                if (shading) {
-                    fill_color = Colors::shadeColor(fill_color, world, mRemoteControl.model()->dem()).rgb();
-                }
-            }
 
-            painter.fillRect(r, fill_color);
-        }
-    }
+    // the grid is rasterized into cached tiles, which are only rebuilt if the data or the style changes
+    GridTileCache::ValueFunction value_func;
+    if (int_grid)
+        value_func = [int_grid](int ix, int iy) { return static_cast<double>(int_grid->constValueAtIndex(ix, iy)); };
+    else if (float_grid)
+        value_func = [float_grid](int ix, int iy) { return static_cast<double>(float_grid->constValueAtIndex(ix, iy)); };
+    else
+        value_func = [double_grid](int ix, int iy) { return double_grid->constValueAtIndex(ix, iy); };
+
+    const HeightGrid *height_grid = GlobalSettings::instance()->model()->heightGrid();
+    const DEM *dem = mRemoteControl.model()->dem();
+    auto color_func = [=](double value, const QPointF &world) {
+        if (clip_with_stand_grid && !height_grid->valueAt(world).isValid())
+            return QColor(Qt::white).rgb();
+        QColor fill_color = view_type<10? Colors::colorFromValue(value, min_val, max_val, reverse,black_white) : Colors::colorFromPalette(value, view_type);
+        if (shading)
+            fill_color = Colors::shadeColor(fill_color, world, dem);
+        return fill_color.rgb();
+    };
+
+    const void *grid_ptr = int_grid ? static_cast<const void*>(int_grid) : float_grid ? static_cast<const void*>(float_grid) : static_cast<const void*>(double_grid);
+    QString style = QString("%1|%2|%3|%4|%5|%6").arg(reinterpret_cast<quintptr>(grid_ptr)).arg(view_type)
+            .arg(min_val).arg(max_val).arg(shading).arg(clip_with_stand_grid);
+    QRectF metric_rect = int_grid ? int_grid->metricRect() : float_grid ? float_grid->metricRect() : double_grid->metricRect();
+    mGridTiles.update(metric_rect, sx, sy, style, value_func, color_func);
+    mGridTiles.draw(painter, vp);
 
     // draw rectangle around the grid
     painter.setPen(Qt::lightGray);
@@ -2176,6 +2185,9 @@ void MainWindow::on_actionModelDestroy_triggered()
     mPaintNext.what = PaintObject::PaintNothing;
     mRemoteControl.destroy();
     mRegenerationGrid.clear();
+    mGridTiles.clear();
+    mGridLabels.clear();
+    mDomTiles.clear();
     checkModelState();
 }
 
@@ -2220,6 +2232,9 @@ void MainWindow::on_actionReload_triggered()
     mPaintNext.what = PaintObject::PaintNothing;
     mRemoteControl.destroy();
     mRegenerationGrid.clear();
+    mGridTiles.clear();
+    mGridLabels.clear();
+    mDomTiles.clear();
     setupModel();
 }
 
@@ -2680,7 +2695,8 @@ void MainWindow::on_actionTest_triggered()
                                      "21: test FOME setup\n" \
                                      "22: test FOME step\n" \
                                      "23: test debug establishment\n" \
-                                     "24: test grid special index hack",-1);
+                                     "24: test grid special index hack\n" \
+                                     "25: test stand statistics (incremental removal)",-1);
     switch (which) {
     case 0: t.speedOfExpression();break;
     case 1: t.clearTrees(); break;
@@ -2707,6 +2723,7 @@ void MainWindow::on_actionTest_triggered()
     case 22: t.testFOMEstep(); break;
     case 23: t.testDbgEstablishment(); break;
     case 24: t.testGridIndexHack(); break;
+    case 25: t.testStandStatistics(); break;
     }
 
 }
@@ -34,6 +34,7 @@
 #include "modelcontroller.h"
 #include "paintarea.h"
 #include "viewport.h"
+#include "gridtilecache.h"
 
 #include "ui/linkxmlqt.h"
 
@@ -153,6 +154,9 @@ private:
                       double min_val=0., double max_val=1.,
                       bool shading=false); ///< paint a map grid (controller driver)
     Viewport vp;
+    GridTileCache mGridTiles; ///< cached tiles of the "other" grid (paintMapGrid(), paintGrid())
+    QStringList mGridLabels; ///< ruler labels of the layer shown in mGridTiles (factor view types, see paintGrid())
+    GridTileCache mDomTiles; ///< cached tiles of the dominant height grid
     QString dumpTreelist();
     void applyCycles(int cycle_count=1);
 
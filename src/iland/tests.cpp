@@ -42,6 +42,8 @@
 //
 #include "standloader.h"
 #include "soil.h"
+#include "resourceunitspecies.h"
+#include "standstatistics.h"
 
 #include "mapgrid.h"
 #include "management.h"
@@ -370,8 +372,8 @@ QString Tests::dumpTreeList()
         treelist.clear();
         tree->dumpList(treelist);
         line = "";
-        foreach(QVariant value, treelist)
-            line+=value.toString() + ";";
+        foreach(const QString &value, treelist.toStringList())
+            line+=value + ";";
         *(line.end()-1)=' ';
         result << line;
     }
@@ -1347,3 +1349,63 @@ void Tests::testGridIndexHack()
       qDebug() << "test average value (square brackets):" << s << "time" << el;
 
 }
+
+/// compare the incremental removal of trees from the stand statistics (see StandStatistics::remove())
+/// with statistics that are re-built from the remaining trees (until the last tree is removed).
+void Tests::testStandStatistics()
+{
+    Model *model = GlobalSettings::instance()->model();
+    if (!model || model->ruList().isEmpty()) {
+        qDebug() << "testStandStatistics: no model available.";
+        return;
+    }
+    // use the resource unit with the largest number of trees
+    ResourceUnit *ru = model->ruList().first();
+    foreach(ResourceUnit *r, model->ruList())
+        if (r->constTrees().count() > ru->constTrees().count())
+            ru = r;
+
+    int n_tested=0, n_errors=0;
+    foreach(const ResourceUnitSpecies *rus, ru->ruSpecies()) {
+        QVector<const Tree*> trees;
+        foreach(const Tree &t, ru->constTrees())
+            if (!t.isDead() && t.species() == rus->species())
+                trees.push_back(&t);
+        if (trees.isEmpty())
+            continue;
+
+        StandStatistics inc;
+        inc.setResourceUnitSpecies(rus);
+        foreach(const Tree *t, trees)
+            inc.add(t, nullptr);
+        inc.calculate();
+
+        for (int i=0;i<trees.count();++i) {
+            inc.remove(trees[i]);
+            // full re-build with the remaining trees
+            StandStatistics full;
+            full.setResourceUnitSpecies(rus);
+            for (int j=i+1;j<trees.count();++j)
+                full.add(trees[j], nullptr);
+            full.calculate();
+
+            const double values[6][2] = { {inc.count(), full.count()},
+                                          {inc.basalArea(), full.basalArea()},
+                                          {inc.leafAreaIndex(), full.leafAreaIndex()},
+                                          {inc.volume(), full.volume()},
+                                          {inc.gwl(), full.gwl()},
+                                          {inc.cStem(), full.cStem()} };
+            ++n_tested;
+            for (int v=0;v<6;++v) {
+                if (fabs(values[v][0] - values[v][1]) > 1e-6 * qMax(1., fabs(values[v][1]))) {
+                    ++n_errors;
+                    qDebug() << "testStandStatistics: species" << rus->species()->id() << "removed" << i+1 << "of" << trees.count()
+                             << "(N, BA, LAI, volume, GWL, cStem) incremental:" << inc.count() << inc.basalArea() << inc.leafAreaIndex() << inc.volume() << inc.gwl() << inc.cStem()
+                             << "full:" << full.count() << full.basalArea() << full.leafAreaIndex() << full.volume() << full.gwl() << full.cStem();
+                    break;
+                }
+            }
+        }
+    }
+    qDebug() << "testStandStatistics: RU" << ru->index() << ":" << n_tested << "removals tested," << n_errors << "differences.";
+}
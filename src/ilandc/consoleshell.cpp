@@ -26,10 +26,22 @@
 #include "global.h"
 #include "model.h"
 #include "modelcontroller.h"
+#include "modelsettings.h"
+#include "outputmanager.h"
+#include "checkpoint.h"
+#include "randomgenerator.h"
 #include "version.h"
+#include "logqueue.h"
+#include "grid.h"
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 QTextStream *ConsoleShell::mLogStream = 0;
 bool ConsoleShell::mFlushLog = false;
+LogQueue *ConsoleShell::mLogQueue = nullptr;
 
 // a try to really get keyboard strokes in console mode...
 // did not work.
@@ -57,6 +69,11 @@ ConsoleShell::ConsoleShell()
 {
 }
 
+ConsoleShell::~ConsoleShell()
+{
+    stopLogQueue();
+}
+
 /*
 */
 
@@ -64,10 +81,11 @@ void ConsoleShell::run()
 {
 
     QString xml_name = QCoreApplication::arguments().at(1);
-    // get the number of years to run...
+    // get the number of years to run (or 'service' to start the service mode)...
     bool ok;
-    int years = QCoreApplication::arguments().at(2).toInt(&ok);
-    if (years<0 || !ok) {
+    const bool service_mode = QCoreApplication::arguments().at(2) == "service";
+    int years = service_mode ? 0 : QCoreApplication::arguments().at(2).toInt(&ok);
+    if (!service_mode && (years<0 || !ok)) {
         qDebug() << QCoreApplication::arguments().at(2) << "is an invalid number of years to run!";
         QCoreApplication::quit();
         return;
@@ -98,10 +116,18 @@ void ConsoleShell::run()
             for (int i=3;i<QCoreApplication::arguments().count();++i) {
                 QString line = QCoreApplication::arguments().at(i);
                 line = line.remove(QChar('"')); // drop quotes
+                if (line == "--resume") {
+                    // continue from the last checkpoint (see Checkpoint)
+                    Checkpoint::setResumeMode(true);
+                    qWarning() << "resume from the last checkpoint.";
+                    continue;
+                }
                 mParams.append(line);
                 //qDebug() << qPrintable(line);
                 QString key = line.left(line.indexOf('='));
                 QString value = line.mid(line.indexOf('=')+1);
+                if (key.startsWith("branch.") || key.startsWith("service."))
+                    continue; // options of the branching/service mode, not part of the project file
                 const_cast<XmlHelper&>(GlobalSettings::instance()->settings()).setNodeValue(key, value);
                 qWarning() << QString("set '%1' to value '%2'. result: '%3'").arg(key).arg(value).arg(GlobalSettings::instance()->settings().value(key));
             }
@@ -130,6 +156,20 @@ void ConsoleShell::run()
             return;
         }
         runJavascript("onCreate");
+
+        if (service_mode) {
+            runService(iland_model);
+            QCoreApplication::quit();
+            return;
+        }
+
+        int branch_year = paramValue("branch.year").toInt();
+        if (branch_year > 0) {
+            runBranches(iland_model, years, branch_year);
+            QCoreApplication::quit();
+            return;
+        }
+
         qWarning() << "**************************************************";
         qWarning() << "*** running model for" << years << "years";
         qWarning() << "**************************************************";
@@ -166,49 +206,72 @@ void ConsoleShell::runYear(int year)
     printf("\r%s: simulating year %d %s          ", QDateTime::currentDateTime().toString("hh:mm:ss").toLocal8Bit().data(), year-1, GlobalSettings::instance()->controller()->timeString().toLocal8Bit().data());
 }
 
-static QMutex qdebug_mutex;
-void myMessageOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg)
- {
-    Q_UNUSED(context);
-    QMutexLocker m(&qdebug_mutex);
-
+/// write a message to the log file ('line': the formatted message) and warnings to the console
+static void writeLogMessage(const QtMsgType type, const QString &line, const QString &msg)
+{
+    *ConsoleShell::logStream() << line << Qt::endl;
+    if (ConsoleShell::flush())
+        ConsoleShell::logStream()->flush();
     switch (type) {
-    case QtDebugMsg:
-        *ConsoleShell::logStream() << QTime::currentTime().toString("hh:mm:ss:zzz") << ": "  << msg << Qt::endl;
-        if (ConsoleShell::flush())
-            ConsoleShell::logStream()->flush();
-        break;
     case QtWarningMsg:
-        *ConsoleShell::logStream() << QTime::currentTime().toString("hh:mm:ss:zzz") << ": " << msg << Qt::endl;
-        if (ConsoleShell::flush())
-            ConsoleShell::logStream()->flush();
-        printf("%s: %s\n", QDateTime::currentDateTime().toString("hh:mm:ss").toLocal8Bit().data(), msg.toLocal8Bit().data());
-        break;
-// available from qt5.5
     case QtInfoMsg:
-        *ConsoleShell::logStream() << QTime::currentTime().toString("hh:mm:ss:zzz") << ": " << msg << Qt::endl;
-        if (ConsoleShell::flush())
-            ConsoleShell::logStream()->flush();
         printf("%s: %s\n", QDateTime::currentDateTime().toString("hh:mm:ss").toLocal8Bit().data(), msg.toLocal8Bit().data());
-
         break;
     case QtCriticalMsg:
-        *ConsoleShell::logStream() << msg << Qt::endl;
-        if (ConsoleShell::flush())
-            ConsoleShell::logStream()->flush();
         printf("Critical: %s\n", msg.toLocal8Bit().data());
         break;
     case QtFatalMsg:
-        *ConsoleShell::logStream() << msg << Qt::endl;
-        if (ConsoleShell::flush())
-            ConsoleShell::logStream()->flush();
         printf("Fatal: %s\n", msg.toLocal8Bit().data());
+        break;
+    default:
+        break;
+    }
+}
+
+/// writer function of the asynchronous logging (runs in the writer thread of the LogQueue)
+static void writeQueuedLogMessage(const LogRecord &record, const QString &line)
+{
+    writeLogMessage(record.type, line, record.message);
+}
+
+static QMutex qdebug_mutex;
+void myMessageOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+ {
+    if (ConsoleShell::logQueue()) {
+        // asynchronous logging: the message is written by the writer thread
+        ConsoleShell::logQueue()->log(type, context.category, msg);
+        if (type == QtFatalMsg)
+            ConsoleShell::logQueue()->flush();
+        return;
     }
+    QMutexLocker m(&qdebug_mutex);
+    if (type == QtCriticalMsg || type == QtFatalMsg)
+        writeLogMessage(type, msg, msg);
+    else
+        writeLogMessage(type, QTime::currentTime().toString("hh:mm:ss:zzz") + ": " + msg, msg);
  }
 
 
+void ConsoleShell::stopLogQueue()
+{
+    if (mLogQueue) {
+        delete mLogQueue; // writes pending messages
+        mLogQueue = nullptr;
+    }
+}
+
+void ConsoleShell::flushLog()
+{
+    // the process may end with _exit() (forked branches): write the pending messages
+    // (the writer thread owns the log stream until it is stopped)
+    stopLogQueue();
+    if (mLogStream)
+        mLogStream->flush();
+}
+
 bool ConsoleShell::setupLogging()
 {
+    stopLogQueue();
     if (mLogStream) {
         if (mLogStream->device())
             delete mLogStream->device();
@@ -229,6 +292,13 @@ bool ConsoleShell::setupLogging()
     } else {
         qDebug() << "Log output is redirected to logfile" << fname;
         mLogStream = new QTextStream(file);
+        // asynchronous logging (see LogQueue)
+        const XmlHelper &xml = GlobalSettings::instance()->settings();
+        if (xml.valueBool("system.logging.async", false)) {
+            mLogQueue = new LogQueue(writeQueuedLogMessage, xml.value("system.logging.queueSize", "65536").toInt());
+            mLogQueue->setRateLimits(xml.value("system.logging.rateLimit"));
+            mLogQueue->setJsonFormat(xml.value("system.logging.format", "text") == "json");
+        }
         qInstallMessageHandler(myMessageOutput);
         return true;
     }
@@ -253,3 +323,381 @@ void ConsoleShell::runJavascript(const QString key)
 
 }
 
+QString ConsoleShell::paramValue(const QString &key) const
+{
+    for (int i=0;i<mParams.count(); ++i) {
+        const QString &line=mParams[i];
+        if (line.left(line.indexOf('=')) == key)
+            return line.mid(line.indexOf('=')+1);
+    }
+    return QString();
+}
+
+#ifdef Q_OS_UNIX
+/// wait for any of the running branch processes to terminate. Returns false if the branch failed.
+/// The name of the terminated branch is stored in 'rName' (if provided).
+static bool waitForBranch(QHash<pid_t, QString> &running, QString *rName=nullptr)
+{
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid <= 0) {
+        qWarning() << "waitpid() failed, lost track of" << running.size() << "branch processes.";
+        running.clear();
+        return false;
+    }
+    QString name = running.take(pid);
+    if (rName)
+        *rName = name;
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status)==0;
+    if (ok)
+        qWarning() << "*** branch" << name << "finished.";
+    else
+        qWarning() << "!!! branch" << name << "failed (exit status" << status << "). Check the log file of the branch.";
+    return ok;
+}
+#endif
+
+// settings that are (re-)read when a branch or a service run starts (see runBranch()):
+// model settings (ModelSettings::loadModelSettings()), the random seed, logging and outputs (Model::reopenOutputs()).
+// Prefixes end with a '.'; 'user.' are user defined values read by scripts.
+static const QStringList run_settings = {
+    "model.settings.growthEnabled", "model.settings.mortalityEnabled", "model.settings.lightExtinctionCoefficient",
+    "model.settings.lightExtinctionCoefficientOpacity", "model.settings.temperatureTau", "model.settings.epsilon",
+    "model.settings.airDensity", "model.settings.laiThresholdForClosedStands", "model.settings.boundaryLayerConductance",
+    "model.settings.usePARFractionBelowGroundAllocation", "model.settings.soil.useDynamicAvailableNitrogen",
+    "model.world.latitude", "system.settings.randomSeed", "system.database.out",
+    "system.logging.", "output.", "user." };
+
+/// returns the keys of 'scenario' (name key=value ...) that are only read during the setup of the model, i.e.
+/// keys that would not change a branch or a service run. Keys without a '.' are parameters (e.g. 'onBranch').
+static QStringList unsupportedRunSettings(const QStringList &scenario)
+{
+    QStringList result;
+    for (int i=1;i<scenario.size();++i) {
+        QString key = scenario[i].left(scenario[i].indexOf('='));
+        if (!key.contains('.'))
+            continue;
+        bool ok = false;
+        foreach(const QString &s, run_settings)
+            if (s.endsWith('.') ? key.startsWith(s) : key == s) {
+                ok = true;
+                break;
+            }
+        if (!ok)
+            result.push_back(key);
+    }
+    return result;
+}
+
+/** Branching mode: the model runs until 'branch_year' (the "spin-up"), and then a child process
+  is forked for every scenario listed in the file given by 'branch.file'. The children share the
+  memory of the spun-up model (copy-on-write) and continue the simulation up to 'years'.
+  The branch file contains one scenario per line: the name of the branch followed by
+  key=value pairs (same as on the command line, quotes are allowed), e.g.:
+  @code
+  # name      overrides
+  thinning    "onBranch=setupThinning(0.3)" user.thinning=0.3
+  lowlue      model.settings.epsilon=1.6 system.settings.randomSeed=42
+  @endcode
+  Every branch writes to its own sub folder (named as the branch) of the output and the log directory.
+  With a fixed system.settings.randomSeed, the seed of a branch is derived from the seed and the name of the branch
+  (unless the scenario sets system.settings.randomSeed), i.e. a branch gives the same results regardless of its position.
+  The option 'branch.processes' limits the number of concurrently running branches (default: number of cores).
+  Overrides can only change settings that are (re-)read after the branch year: the model settings read by
+  ModelSettings::loadModelSettings() (e.g. model.settings.epsilon, model.world.latitude), system.settings.randomSeed,
+  system.logging.*, system.database.out, output.* and user.*, and javascript triggers (e.g. onBranch).
+  Branching is refused if a scenario contains other settings (e.g. species parameters, model.site.*, the initial state). */
+void ConsoleShell::runBranches(ModelController &iland_model, int years, int branch_year)
+{
+#ifdef Q_OS_UNIX
+    if (branch_year >= years) {
+        qWarning() << "branch.year (" << branch_year << ") must be smaller than the number of years to run (" << years << ")!";
+        return;
+    }
+    QString file_name = GlobalSettings::instance()->path(paramValue("branch.file"), "home");
+    QFile file(file_name);
+    if (paramValue("branch.file").isEmpty() || !file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "branching: cannot open the branch file (branch.file):" << file_name;
+        return;
+    }
+    QList<QStringList> scenarios;
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        scenarios.append(QProcess::splitCommand(line));
+    }
+    if (scenarios.isEmpty()) {
+        qWarning() << "branching: no scenarios found in" << file_name;
+        return;
+    }
+    bool valid = true;
+    foreach(const QStringList &scenario, scenarios) {
+        QStringList unsupported = unsupportedRunSettings(scenario);
+        if (!unsupported.isEmpty()) {
+            qWarning() << "branching: scenario" << scenario.first() << "changes settings that are only read during the setup:" << unsupported.join(", ");
+            valid = false;
+        }
+    }
+    if (!valid) {
+        qWarning() << "branching: supported settings are:" << run_settings.join(", ");
+        return;
+    }
+    int max_processes = paramValue("branch.processes").toInt();
+    if (max_processes <= 0)
+        max_processes = QThread::idealThreadCount();
+
+    qWarning() << "**************************************************";
+    qWarning() << "*** running model for" << branch_year << "years (until the branch year)";
+    qWarning() << "**************************************************";
+    iland_model.run(branch_year + 1);
+    if (iland_model.hasError()) {
+        qWarning() << "!!!! ERROR !!!!";
+        qWarning() << iland_model.lastError();
+        qWarning() << "!!!! ERROR !!!!";
+        return;
+    }
+
+    prepareFork();
+
+    qWarning() << "*** branching into" << scenarios.size() << "scenarios (max." << max_processes << "concurrent processes)";
+    QHash<pid_t, QString> running;
+    int n_failed = 0;
+    for (int i=0;i<scenarios.size();++i) {
+        while (running.size() >= max_processes)
+            if (!waitForBranch(running))
+                ++n_failed;
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            qWarning() << "!!! fork() failed for branch" << scenarios[i].first();
+            ++n_failed;
+            continue;
+        }
+        if (pid == 0) {
+            // child process: run the scenario and terminate without running the cleanup of the parent
+            int result = runBranch(iland_model, years, scenarios[i]);
+            fflush(stdout);
+            _exit(result);
+        }
+        running.insert(pid, scenarios[i].first());
+        qWarning() << "*** started branch" << scenarios[i].first() << "(pid" << pid << ")";
+    }
+    while (!running.isEmpty())
+        if (!waitForBranch(running))
+            ++n_failed;
+
+    qWarning() << "**************************************************";
+    qWarning() << "*** all branches finished:" << scenarios.size()-n_failed << "successful," << n_failed << "failed.";
+    qWarning() << "**************************************************";
+#else
+    Q_UNUSED(iland_model); Q_UNUSED(years); Q_UNUSED(branch_year);
+    qWarning() << "branching (branch.year) is only available on Unix-like systems.";
+#endif
+}
+
+void ConsoleShell::prepareFork()
+{
+    // file backed grids are shared mappings: forked processes would write into the grids of each other
+    if (GridStorage::isFileBacked())
+        throw IException("Branching and the service mode are not available with file backed grids (system.settings.gridStorage.spillPath).");
+    // prepare the fork: database connections must not be shared (the children re-open them), worker threads
+    // (including the log writer) are not available in the child, and buffered output would be written twice.
+    stopLogQueue(); // the log continues synchronously
+    GlobalSettings::instance()->outputManager()->close();
+    GlobalSettings::instance()->dbout().close();
+    GlobalSettings::instance()->model()->closeInputs();
+    QThreadPool::globalInstance()->waitForDone();
+    if (mLogStream)
+        mLogStream->flush();
+    fflush(stdout);
+}
+
+#ifdef Q_OS_UNIX
+/// write a reply of the service mode to stdout (lines are prefixed with "iland-service:")
+static void serviceReply(const QString &message)
+{
+    printf("iland-service: %s\n", message.toLocal8Bit().data());
+    fflush(stdout);
+}
+
+/// wait for one of the running requests of the service mode and report the result
+static void waitForServiceRun(QHash<pid_t, QString> &running)
+{
+    QString name;
+    bool ok = waitForBranch(running, &name);
+    serviceReply(QString("finished %1 %2").arg(name, ok ? "ok" : "failed"));
+}
+#endif
+
+/** Service mode ('ilandc project.xml service'): the project is set up once (landscape, stamps, species, climate,
+  initial trees), and the process then reads run requests from stdin, one per line:
+  @code
+  run <name> <years> key=value key=value ...
+  wait
+  quit
+  @endcode
+  Each 'run' forks a child process from the (unchanged) initial state of the model, applies the key=value
+  overrides and simulates 'years' years; i.e. every run starts from the same clean state without reading the
+  inputs again. A run is executed like a branch (see runBranches()): outputs and logs are written to a
+  sub folder 'name', and the javascript trigger 'onBranch' is executed before the run. Only the settings that are
+  (re-)read when a run starts can be changed (see runBranches()); requests with other settings are rejected.
+  Replies are written to stdout ("iland-service: started <name>", "iland-service: finished <name> ok|failed").
+  The option 'service.processes' sets the number of concurrent runs (default: 1, i.e. each request is finished
+  before the next line is read); 'wait' waits until all runs are finished, 'quit' (or the end of input) stops the service. */
+void ConsoleShell::runService(ModelController &iland_model)
+{
+#ifdef Q_OS_UNIX
+    int max_processes = paramValue("service.processes").toInt();
+    if (max_processes <= 0)
+        max_processes = 1;
+
+    prepareFork();
+
+    qWarning() << "*** service mode: waiting for run requests on stdin (max." << max_processes << "concurrent runs)";
+    serviceReply("ready");
+    QTextStream in(stdin);
+    QHash<pid_t, QString> running;
+    int n_runs = 0;
+    while (true) {
+        QString line = in.readLine();
+        if (line.isNull())
+            break; // end of input
+        line = line.trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        QStringList request = QProcess::splitCommand(line);
+        QString command = request.takeFirst();
+        if (command == "quit")
+            break;
+        if (command == "wait") {
+            while (!running.isEmpty())
+                waitForServiceRun(running);
+            serviceReply("idle");
+            continue;
+        }
+        bool ok = false;
+        int years = request.size()>=2 ? request[1].toInt(&ok) : 0;
+        if (command != "run" || !ok || years <= 0) {
+            serviceReply(QString("error invalid request '%1' (expected: run <name> <years> key=value ...)").arg(line));
+            continue;
+        }
+        QString name = request.first();
+        QStringList unsupported = unsupportedRunSettings(request); // note: 'years' is not a key
+        if (!unsupported.isEmpty()) {
+            serviceReply(QString("error the settings '%1' are only read during the setup (supported: %2)").arg(unsupported.join(", "), run_settings.join(", ")));
+            continue;
+        }
+        if (running.values().contains(name)) {
+            serviceReply(QString("error a run with the name '%1' is still running").arg(name));
+            continue;
+        }
+        request.removeAt(1); // the scenario: name key=value ...
+
+        while (running.size() >= max_processes)
+            waitForServiceRun(running);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            serviceReply(QString("finished %1 failed").arg(name));
+            qWarning() << "!!! fork() failed for run" << name;
+            continue;
+        }
+        if (pid == 0) {
+            // child process: run the request and terminate without running the cleanup of the parent
+            int result = runBranch(iland_model, years, request);
+            fflush(stdout);
+            _exit(result);
+        }
+        running.insert(pid, name);
+        ++n_runs;
+        serviceReply(QString("started %1").arg(name));
+        if (max_processes == 1)
+            waitForServiceRun(running); // answer the request before reading the next one
+    }
+    while (!running.isEmpty())
+        waitForServiceRun(running);
+    qWarning() << "*** service mode: stopped after" << n_runs << "runs.";
+    serviceReply("stopped");
+#else
+    Q_UNUSED(iland_model);
+    qWarning() << "the service mode is only available on Unix-like systems.";
+#endif
+}
+
+int ConsoleShell::runBranch(ModelController &iland_model, int years, QStringList scenario)
+{
+#ifdef Q_OS_UNIX
+    try {
+        GlobalSettings *g = GlobalSettings::instance();
+        QString name = scenario.takeFirst();
+        // separate output and log folders for each branch
+        QString out_path = g->path(name, "output");
+        QString log_path = g->path(name, "log");
+        QDir().mkpath(out_path);
+        QDir().mkpath(log_path);
+        g->setPath("output", out_path);
+        g->setPath("log", log_path);
+
+        bool has_seed = false;
+        XmlHelper &xml = const_cast<XmlHelper&>(g->settings());
+        foreach(QString line, scenario) {
+            mParams.append(line);
+            QString key = line.left(line.indexOf('='));
+            QString value = line.mid(line.indexOf('=')+1);
+            if (key == "system.settings.randomSeed")
+                has_seed = true;
+            xml.setNodeValue(key, value);
+        }
+        if (!setupLogging())
+            return 1;
+        qWarning() << "*** branch" << name << "started in year" << g->currentYear() << "with settings:" << scenario.join(" ");
+
+        Model *model = iland_model.model();
+        // the worker threads of the parent do not exist in the forked process:
+        // a branch runs single threaded (parallelism comes from running several branches).
+        const_cast<ThreadRunner&>(model->threadExec()).setMultithreading(false);
+        Model::changeSettings().loadModelSettings();
+        model->reopenInputs();
+
+        // each branch gets its own sequence of random numbers (reproducible if a fixed seed is used):
+        // the seed is derived from the name of the branch, i.e. it does not depend on the order of branches/requests
+        uint seed = xml.value("system.settings.randomSeed", "0").toUInt();
+        if (seed > 0 && !has_seed) {
+            seed += static_cast<uint>(qHash(name));
+            if (seed == 0)
+                seed = 1;
+        }
+        if (seed == 0)
+            seed = static_cast<uint>(QDateTime::currentMSecsSinceEpoch()) ^ (static_cast<uint>(getpid()) << 16);
+        RandomGenerator::setup(RandomGenerator::ergMersenneTwister, seed);
+
+        model->reopenOutputs();
+        runJavascript("onBranch");
+
+        iland_model.run(years + 1);
+        if (iland_model.hasError()) {
+            qWarning() << "!!!! ERROR in branch" << name << "!!!!";
+            qWarning() << iland_model.lastError();
+            flushLog();
+            return 1;
+        }
+        runJavascript("onFinish");
+        qWarning() << "*** branch" << name << "finished.";
+        flushLog();
+        return 0;
+
+    } catch (const IException &e) {
+        qWarning() << "*** An exception occured in branch ***";
+        qWarning() << e.message();
+    } catch (const std::exception &e) {
+        qWarning() << "*** An (std)exception occured in branch ***";
+        qWarning() << e.what();
+    }
+    flushLog();
+#else
+    Q_UNUSED(iland_model); Q_UNUSED(years); Q_UNUSED(scenario);
+#endif
+    return 1;
+}
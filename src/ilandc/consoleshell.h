@@ -26,13 +26,17 @@
 */
 
 class QTextStream;
+class ModelController;
+class LogQueue;
 class ConsoleShell: public QObject
 {
     Q_OBJECT
 public:
     ConsoleShell();
+    ~ConsoleShell();
     static QTextStream* logStream() {return mLogStream; }
     static bool flush() { return mFlushLog; }
+    static LogQueue *logQueue() { return mLogQueue; } ///< the asynchronous log writer (or null if logging is synchronous)
 public slots:
     void run(); // execute the iLand model
     void runYear(int year); // slot called every year
@@ -40,8 +44,18 @@ private:
     QStringList mParams;
     static bool mFlushLog; // immediately flush output to the logfile
     bool setupLogging();
+    static void stopLogQueue(); ///< write pending messages and stop the asynchronous log writer
+    static void flushLog(); ///< stop the asynchronous log writer and flush the log file
     void runJavascript(const QString key);
+    QString paramValue(const QString &key) const; ///< value of a command line parameter 'key=value' (or empty string)
+    // branching: run to a branch year and fork a child process per scenario
+    void runBranches(ModelController &iland_model, int years, int branch_year);
+    int runBranch(ModelController &iland_model, int years, QStringList scenario); ///< executed in the child process, returns the exit code
+    void prepareFork(); ///< close the output databases and wait for worker threads before forking child processes
+    // service mode: keep the model after the setup and fork a child process for each run request (read from stdin)
+    void runService(ModelController &iland_model);
     static QTextStream *mLogStream;
+    static LogQueue *mLogQueue;
 };
 
 #endif // CONSOLESHELL_H
@@ -149,6 +149,7 @@ SOURCES += main.cpp \
     ../core/model.cpp \
     ../core/modelcontroller.cpp \
     ../core/grid.cpp \
+    ../core/allometrytable.cpp \
     ../core/tree.cpp \
     ../tools/expression.cpp \
     ../tools/helper.cpp \
@@ -175,6 +176,7 @@ SOURCES += main.cpp \
     ../core/standstatistics.cpp \
     ../output/dynamicstandout.cpp \
     ../output/customaggout.cpp \
+    ../output/fieldaggregator.cpp \
     ../core/management.cpp \
     ../core/speciesresponse.cpp \
     ../core/climate.cpp \
@@ -195,6 +197,7 @@ SOURCES += main.cpp \
     ../core/seeddispersal.cpp \
     ../core/establishment.cpp \
     ../core/soil.cpp \
+    ../core/soilspinup.cpp \
     ../core/snag.cpp \
     ../core/saplings.cpp \
     ../output/saplingout.cpp \
@@ -207,9 +210,11 @@ SOURCES += main.cpp \
     ../tools/dem.cpp \
     ../3rdparty/SimpleRNG.cpp \
     ../output/snapshot.cpp \
+    ../output/checkpoint.cpp \
     ../tools/spatialanalysis.cpp \
     ../tools/statdata.cpp \
     ../tools/debugtimer.cpp \
+    ../tools/logqueue.cpp \
     ../abe/fomewrapper.cpp \
     ../abe/fmstand.cpp \
     ../abe/agent.cpp \
@@ -275,6 +280,7 @@ HEADERS += \
     ../core/model.h \
     ../core/modelcontroller.h \
     ../core/grid.h \
+    ../core/allometrytable.h \
     ../core/tree.h \
     ../tools/expression.h \
     ../tools/helper.h \
@@ -306,6 +312,7 @@ HEADERS += \
     ../core/standstatistics.h \
     ../output/dynamicstandout.h \
     ../output/customaggout.h \
+    ../output/fieldaggregator.h \
     ../core/management.h \
     ../core/speciesresponse.h \
     ../core/climate.h \
@@ -328,6 +335,7 @@ HEADERS += \
     ../core/seeddispersal.h \
     ../core/establishment.h \
     ../core/soil.h \
+    ../core/soilspinup.h \
     ../core/snag.h \
     ../core/saplings.h \
     ../output/saplingout.h \
@@ -341,9 +349,11 @@ HEADERS += \
     ../core/layeredgrid.h \
     ../3rdparty/SimpleRNG.h \
     ../output/snapshot.h \
+    ../output/checkpoint.h \
     ../tools/spatialanalysis.h \
     ../tools/statdata.h \
     ../tools/debugtimer.h \
+    ../tools/logqueue.h \
     ../abe/activity.h \
     ../abe/forestmanagementengine.h \
     ../abe/abe_global.h \
@@ -44,6 +44,14 @@ int main(int argc, char *argv[])
         printf("Options:\n");
         printf("you specify a number key=value pairs, and *after* loading of the project\n");
         printf("the 'key' settings are set to 'value'. E.g.: ilandc project.xml 100 output.stand.enabled=false output.stand.landscape=false\n");
+        printf("Branching: run to year 'branch.year' and fork a process for each scenario (one per line: name key=value ...) in 'branch.file'.\n");
+        printf("E.g.: ilandc project.xml 300 branch.year=200 branch.file=scenarios.txt branch.processes=8 (Linux/macOS only).\n");
+        printf("Checkpoints: with system.settings.checkpoint.enabled=true the model state is saved periodically;\n");
+        printf("use the option --resume to continue an interrupted simulation from the last checkpoint.\n");
+        printf("Service mode: ilandc project.xml service [service.processes=4] sets up the project once and reads requests\n");
+        printf("from stdin ('run <name> <years> key=value ...', 'wait', 'quit'); each run starts from the initial state (Linux/macOS only).\n");
+        printf("Branches and service runs can change only settings that are read when a run starts: the main model.settings\n");
+        printf("(e.g. epsilon), system.settings.randomSeed, system.logging.*, system.database.out, output.* and user.* (and triggers, e.g. onBranch).\n");
         printf("See also https://iland-model.org/iLand+console\n.");
         return 0;
     }
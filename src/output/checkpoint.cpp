@@ -0,0 +1,305 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#include "global.h"
+#include "checkpoint.h"
+#include "globalsettings.h"
+#include "model.h"
+#include "resourceunit.h"
+#include "climate.h"
+#include "snapshot.h"
+#include "outputmanager.h"
+#include "randomgenerator.h"
+#include "debugtimer.h"
+#include "forestmanagementengine.h"
+
+#include <QtSql>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QtConcurrent/QtConcurrent>
+
+/** @class Checkpoint
+  @ingroup output
+  A checkpoint is a binary image of the full model state that is written periodically (every 'interval' years) to a
+  SQLite database. If a simulation is interrupted, it can be resumed from the last checkpoint (e.g., 'ilandc project.xml 500 --resume').
+
+  The checkpoint database contains the tables:
+  - ru_state: one row per resource unit with the serialized state (trees, saplings, soil, snags; see Snapshot::saveResourceUnit())
+  - checkpoint_info: key/value pairs for the global state (year, random number generator, climate, ABE, ...)
+
+  Checkpoints are incremental: only resource units with a changed state are written. The state is collected in
+  parallel (for all resource units), while writing the database happens in a background thread, i.e. the
+  simulation continues during writing. Both tables are updated in a single transaction, so the database always
+  contains a consistent checkpoint, even if the process is killed during writing.
+
+  When resuming, the model is set up as usual; the state of the checkpoint replaces then the initial state. The output
+  database is not re-created; rows of years after the checkpoint are deleted from the output tables (see Output::setResumeYear()).
+  Limitations: the landscape (resource units) must not change between the runs; scheduled events (time events) and
+  the JavaScript state are not part of the checkpoint; pending ABE activities are re-evaluated after resuming.
+  */
+
+bool Checkpoint::mResumeMode = false;
+Checkpoint *Checkpoint::mInstance = nullptr;
+
+Checkpoint::Checkpoint()
+{
+    mEnabled = false;
+    mInterval = 10;
+    mInstance = this;
+}
+
+Checkpoint::~Checkpoint()
+{
+    waitForFinished();
+    if (mInstance == this)
+        mInstance = nullptr;
+}
+
+void Checkpoint::setup()
+{
+    const XmlHelper &xml = GlobalSettings::instance()->settings();
+    mEnabled = xml.valueBool("system.settings.checkpoint.enabled", false);
+    mInterval = qMax(xml.value("system.settings.checkpoint.interval", "10").toInt(), 1);
+    mFileName = GlobalSettings::instance()->path(xml.value("system.settings.checkpoint.file", "checkpoint.sqlite"), "output");
+    mRUData.clear();
+    mRUHash.clear();
+    if (!mEnabled)
+        return;
+    // a new simulation starts with an empty checkpoint database
+    if (!mResumeMode && QFile::exists(mFileName)) {
+        if (!QFile::remove(mFileName))
+            throw IException(QString("Checkpoint: cannot remove the existing checkpoint database '%1'.").arg(mFileName));
+    }
+    qDebug() << "checkpoints enabled: interval" << mInterval << "years, file:" << mFileName;
+}
+
+void Checkpoint::waitForFinished()
+{
+    if (mWriter.isRunning()) {
+        DebugTimer t("Checkpoint: wait for writer");
+        mWriter.waitForFinished();
+    }
+}
+
+/// worker function: serialize a single resource unit
+void Checkpoint::nc_saveResourceUnit(ResourceUnit *ru)
+{
+    try {
+        mInstance->mRUData[ru->index()] = Snapshot::saveResourceUnit(ru);
+    } catch (const IException& e) {
+        GlobalSettings::instance()->model()->threadExec().throwError(e.message());
+    }
+}
+
+void Checkpoint::save()
+{
+    if (!mEnabled)
+        return;
+    // save() is called after the end of a year (the clock is already advanced)
+    int year = GlobalSettings::instance()->currentYear() - 1;
+    if (year < 1 || year % mInterval != 0)
+        return;
+
+    DebugTimer t("Checkpoint:save");
+    waitForFinished(); // the previous checkpoint must be completely written
+
+    // commit the outputs, so that outputs and checkpoint are in sync
+    GlobalSettings::instance()->outputManager()->save();
+
+    Model *model = GlobalSettings::instance()->model();
+    int n_ru = model->ruList().count();
+    mRUData.resize(n_ru);
+    if (mRUHash.size() != n_ru)
+        mRUHash.fill(QByteArray(), n_ru);
+
+    // serialize the resource units (in parallel)
+    model->executePerResourceUnit(nc_saveResourceUnit);
+    const_cast<ThreadRunner&>(model->threadExec()).checkErrors();
+
+    // only resource units with a changed state are written to the database
+    // (a cryptographic digest, i.e. changed states are not missed because of hash collisions)
+    QVector<QPair<int, QByteArray> > ru_data;
+    for (int i=0;i<n_ru;++i) {
+        QByteArray hash = QCryptographicHash::hash(mRUData[i], QCryptographicHash::Sha1);
+        if (hash != mRUHash[i]) {
+            ru_data.push_back(QPair<int, QByteArray>(i, mRUData[i]));
+            mRUHash[i] = hash;
+        }
+        mRUData[i].clear(); // release the memory
+    }
+
+    // global state
+    InfoList info;
+    info << QPair<QString, QByteArray>("year", QByteArray::number(year));
+    info << QPair<QString, QByteArray>("ruCount", QByteArray::number(n_ru));
+    info << QPair<QString, QByteArray>("nextTreeId", QByteArray::number(Snapshot::nextTreeId()));
+
+    QByteArray buffer;
+    {
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        unsigned int rng_state[5];
+        RandomGenerator::state(rng_state);
+        for (int i=0;i<5;++i)
+            out << rng_state[i];
+    }
+    info << QPair<QString, QByteArray>("rng", buffer);
+
+    buffer.clear();
+    {
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        out << static_cast<qint32>(model->climates().count());
+        foreach(const Climate *c, model->climates())
+            c->saveState(out);
+    }
+    info << QPair<QString, QByteArray>("climate", buffer);
+
+    if (model->ABEngine())
+        info << QPair<QString, QByteArray>("abe", model->ABEngine()->saveState());
+
+    qDebug() << "Checkpoint: year" << year << ":" << ru_data.count() << "of" << n_ru << "resource units changed.";
+    mWriter = QtConcurrent::run(&Checkpoint::writeDatabase, mFileName, year, ru_data, info);
+}
+
+void Checkpoint::writeDatabase(const QString file_name, const int year, const QVector<QPair<int, QByteArray> > ru_data, const InfoList info)
+{
+    // the connection is created (and used) exclusively in the writer thread
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "checkpoint");
+        db.setDatabaseName(file_name);
+        if (!db.open()) {
+            qWarning() << "Checkpoint: cannot open the database" << file_name << ":" << db.lastError().text();
+        } else {
+            QSqlQuery q(db);
+            q.exec("create table if not exists ru_state (RUindex integer primary key, year integer, data blob)");
+            q.exec("create table if not exists checkpoint_info (key text primary key, value blob)");
+            db.transaction();
+            q.prepare("insert or replace into ru_state (RUindex, year, data) values (?, ?, ?)");
+            for (int i=0;i<ru_data.count();++i) {
+                q.addBindValue(ru_data[i].first);
+                q.addBindValue(year);
+                q.addBindValue(ru_data[i].second);
+                if (!q.exec())
+                    qWarning() << "Checkpoint: error writing resource unit" << ru_data[i].first << ":" << q.lastError().text();
+            }
+            q.prepare("insert or replace into checkpoint_info (key, value) values (?, ?)");
+            for (int i=0;i<info.count();++i) {
+                q.addBindValue(info[i].first);
+                q.addBindValue(info[i].second);
+                if (!q.exec())
+                    qWarning() << "Checkpoint: error writing" << info[i].first << ":" << q.lastError().text();
+            }
+            if (!db.commit())
+                qWarning() << "Checkpoint: commit failed:" << db.lastError().text();
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase("checkpoint");
+}
+
+int Checkpoint::checkpointYear(const QString &file_name)
+{
+    int year = -1;
+    if (!QFile::exists(file_name))
+        return year;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "checkpoint");
+        db.setDatabaseName(file_name);
+        if (db.open()) {
+            QSqlQuery q(db);
+            if (q.exec("select value from checkpoint_info where key='year'") && q.next())
+                year = q.value(0).toByteArray().toInt();
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase("checkpoint");
+    return year;
+}
+
+int Checkpoint::restore()
+{
+    DebugTimer t("Checkpoint:restore");
+    waitForFinished();
+    Model *model = GlobalSettings::instance()->model();
+    QHash<QString, QByteArray> info;
+    QVector<QByteArray> ru_data;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "checkpoint");
+        db.setDatabaseName(mFileName);
+        if (!QFile::exists(mFileName) || !db.open())
+            throw IException(QString("Checkpoint: cannot open the checkpoint database '%1'.").arg(mFileName));
+        QSqlQuery q(db);
+        q.exec("select key, value from checkpoint_info");
+        while (q.next())
+            info[q.value(0).toString()] = q.value(1).toByteArray();
+
+        if (!info.contains("year") || info["ruCount"].toInt() != model->ruList().count()) {
+            db.close();
+            throw IException(QString("Checkpoint: the checkpoint database '%1' is empty or does not match the landscape (%2 resource units in the checkpoint, %3 in the model).")
+                             .arg(mFileName).arg(info["ruCount"].toInt()).arg(model->ruList().count()));
+        }
+        ru_data.resize(model->ruList().count());
+        q.exec("select RUindex, data from ru_state");
+        while (q.next()) {
+            int index = q.value(0).toInt();
+            if (index>=0 && index<ru_data.size())
+                ru_data[index] = q.value(1).toByteArray();
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("checkpoint");
+
+    int year = info["year"].toInt();
+    qDebug() << "Checkpoint: resume from year" << year << "(" << mFileName << ")";
+
+    // the state of the resource units
+    mRUHash.fill(QByteArray(), ru_data.size());
+    foreach(ResourceUnit *ru, model->ruList()) {
+        const QByteArray &data = ru_data[ru->index()];
+        if (data.isEmpty())
+            throw IException(QString("Checkpoint: no data for resource unit with index %1.").arg(ru->index()));
+        Snapshot::loadResourceUnit(ru, data);
+        mRUHash[ru->index()] = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+    }
+    Snapshot::setNextTreeId(info["nextTreeId"].toInt());
+
+    // climate
+    QDataStream cin(info["climate"]);
+    qint32 n_climates;
+    cin >> n_climates;
+    if (n_climates != model->climates().count())
+        throw IException("Checkpoint: the number of climates differs from the checkpoint.");
+    foreach(Climate *c, model->climates())
+        c->restoreState(cin);
+
+    // random numbers
+    QDataStream rin(info["rng"]);
+    unsigned int rng_state[5];
+    for (int i=0;i<5;++i)
+        rin >> rng_state[i];
+    RandomGenerator::setState(rng_state);
+
+    // light pattern and statistics of the restored trees
+    model->onlyApplyLightPattern();
+    model->createStandStatistics();
+
+    // the state of the management (requires the stand statistics)
+    if (model->ABEngine() && info.contains("abe"))
+        model->ABEngine()->restoreState(info["abe"]);
+
+    return year;
+}
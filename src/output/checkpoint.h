@@ -0,0 +1,69 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QList>
+#include <QPair>
+#include <QFuture>
+
+class ResourceUnit; // forward
+
+/** @class Checkpoint saves the state of a running simulation periodically to a database, and allows
+  to resume a simulation from the last checkpoint (e.g. after a crash of a long running simulation).
+  */
+class Checkpoint
+{
+public:
+    Checkpoint();
+    ~Checkpoint();
+    void setup(); ///< read settings (system.settings.checkpoint)
+    bool isEnabled() const { return mEnabled; }
+    const QString &fileName() const { return mFileName; } ///< full path of the checkpoint database
+    /// called at the end of each simulated year: write a checkpoint if due.
+    void save();
+    /// restore the model state from the checkpoint database. Returns the year of the checkpoint.
+    int restore();
+    /// wait until a pending write operation is finished
+    void waitForFinished();
+
+    /// resume mode: if true, the model state is loaded from the checkpoint during the model setup
+    static void setResumeMode(const bool resume) { mResumeMode = resume; }
+    static bool resumeMode() { return mResumeMode; }
+    /// the year of the last checkpoint stored in the checkpoint database (-1 if not available)
+    static int checkpointYear(const QString &file_name);
+private:
+    typedef QList<QPair<QString, QByteArray> > InfoList;
+    static void nc_saveResourceUnit(ResourceUnit *ru);
+    /// write to the database (runs in a separate thread)
+    static void writeDatabase(const QString file_name, const int year, const QVector<QPair<int, QByteArray> > ru_data, const InfoList info);
+    static bool mResumeMode;
+    static Checkpoint *mInstance; ///< used by the (static) worker function
+    bool mEnabled;
+    int mInterval; ///< write a checkpoint every 'mInterval' years
+    QString mFileName; ///< full path to the checkpoint database
+    QVector<QByteArray> mRUData; ///< serialized state per resource unit (index: ru->index())
+    QVector<QByteArray> mRUHash; ///< SHA-1 digest of the last saved state of each resource unit (empty: not saved)
+    QFuture<void> mWriter; ///< the pending write operation
+};
+
+#endif // CHECKPOINT_H
@@ -19,10 +19,12 @@
 #include "customaggout.h"
 
 #include "debugtimer.h"
-#include "statdata.h"
 #include "model.h"
 #include "resourceunit.h"
 #include "species.h"
+#include "speciesset.h"
+#include "saplings.h"
+#include "snag.h"
 #include "expressionwrapper.h"
 #include "mapgrid.h"
 
@@ -30,7 +32,9 @@ CustomAggOut::CustomAggOut()
 {
     setName("custom aggregation of saplings, trees, RUs on user defined intervals", "customagg");
 
-    setDescription("See https://iland-model.org/dynamic+outputs for details. ");
+    setDescription("See https://iland-model.org/dynamic+outputs for details. " \
+                   "All fields are aggregated in a single pass over the entities. If the 'percentiles' setting of an output is 'sketch', " \
+                   "percentiles are approximated with a relative accuracy of 0.5% (exact for up to 128 values); the default ('exact') uses all values.");
     columns() << OutputColumn::year() << OutputColumn::ru()  << OutputColumn::id() << OutputColumn::species();
     // other colums are added during setup...
 }
@@ -78,10 +82,6 @@ void CustomAggOut::setStandGrid(MapGrid *mapgrid)
         dynamic_cast<CustomAggOutLevel*>(l)->setStandGrid(mapgrid);
 }
 
-const QStringList aggList = { "mean", "sum", "min", "max",
-                             "p25", "p50", "p75", "p5", "p10", "p90", "p95",
-                             "sd", "p80","p85"};
-
 void CustomAggOutLevel::setup()
 {
     QString tab_name = settings().value(".tablename");
@@ -97,6 +97,7 @@ void CustomAggOutLevel::setup()
     QString level_filter = settings().value(".levelfilter","");
     QString fieldList = settings().value(".columns", "");
     QString condition = settings().value(".filter", "");
+    FieldAggregator::PercentileMode percentile_mode = FieldAggregator::percentileMode(settings().value(".percentiles", "exact"));
 
     QString aggtype = settings().value(".entity", "tree").toLower();
     mEntity = CustomAggOut::Invalid;
@@ -125,7 +126,7 @@ void CustomAggOutLevel::setup()
 
     // clear columns
     columns().clear();
-    //qDeleteAll(mFieldList);
+    qDeleteAll(mFieldList);
     mFieldList.clear();
 
 
@@ -144,6 +145,7 @@ void CustomAggOutLevel::setup()
     }
 
     // setup fields
+    QVector<int> aggregations;
     if (!fieldList.isEmpty()) {
         QRegularExpression re("([^\\.]+).(\\w+)[,\\s]*"); // two parts: before dot and after dot, and , + whitespace at the end
 
@@ -178,25 +180,54 @@ void CustomAggOutLevel::setup()
                 // complex expression
                 dfield->var_index=-1;
                 dfield->expression.setExpression(field);
+                // parse now, as the expressions are evaluated in parallel later
+                switch (mEntity) {
+                case CustomAggOut::Trees: dfield->expression.parse(&tw); break;
+                case CustomAggOut::Saplings: dfield->expression.parse(&sw); break;
+                case CustomAggOut::RU: dfield->expression.parse(&rw); break;
+                case CustomAggOut::Snags: dfield->expression.parse(&dw); break;
+                default: break;
+                }
                 //mFieldList.back().expression = QScopedPointer<Expression>(new Expression(field));
             }
 
-            dfield->agg_index = aggList.indexOf(aggregation);
+            dfield->agg_index = FieldAggregator::aggregationIndex(aggregation);
             if (dfield->agg_index==-1)
                 throw IException(QString("Invalid aggregate expression for dynamic output: %1\nallowed:%2")
-                                 .arg(aggregation).arg(aggList.join(" ")));
+                                 .arg(aggregation).arg(FieldAggregator::aggregationNames().join(" ")));
+            aggregations.push_back(dfield->agg_index);
 
             QString stripped_field=QString("%1_%2").arg(field, aggregation);
             stripped_field.replace(QRegularExpression("[\\[\\]\\,\\(\\)<>=!\\-\\+/\\*\\s]"), "_");
             stripped_field.replace("__", "_");
             columns() << OutputColumn(stripped_field, field, OutDouble);
         }
+        if (!mEntityFilter.isEmpty()) {
+            switch (mEntity) {
+            case CustomAggOut::Trees: mEntityFilter.parse(&tw); break;
+            case CustomAggOut::Saplings: mEntityFilter.parse(&sw); break;
+            case CustomAggOut::Snags: mEntityFilter.parse(&dw); break;
+            default: break;
+            }
+        }
     }
+    mAggregator.setup(aggregations, percentile_mode);
+
+    // incsum() depends on the order of the entities, i.e. such expressions are not evaluated in parallel
+    mSequential = mEntityFilter.usesIncSum();
+    foreach(const SDynamicField *field, mFieldList)
+        if (field->var_index<0 && field->expression.usesIncSum())
+            mSequential = true;
 
     // enable (and open output table/file)
     setEnabled(enabled);
 }
 
+CustomAggOutLevel::~CustomAggOutLevel()
+{
+    qDeleteAll(mFieldList);
+}
+
 void CustomAggOutLevel::exec()
 {
     if (mFieldList.count()==0)
@@ -209,64 +240,36 @@ void CustomAggOutLevel::exec()
     DebugTimer t("customagg output");
 
     switch (mEntity) {
-    case CustomAggOut::Trees: runTrees(); break;
-    case CustomAggOut::Saplings: runSaplings(); break;
-    case CustomAggOut::Snags: runSnags(); break;
+    case CustomAggOut::Trees:
+    case CustomAggOut::Saplings:
+        run(); break;
+    case CustomAggOut::Snags:
+        if (!Globals->model()->settings().carbonCycleEnabled)
+            throw IException("CustomAgg: should process Snags, but carbon cycle is not enabled in the model!");
+        run(); break;
     default: throw IException("Invalid aggregation level in custom agg output!");
     }
 
 }
 
-
-
-
-
-// process tree based aggregations
-void CustomAggOutLevel::runTrees()
+// all entities are visited once (in parallel for resource units / stands), all fields are aggregated at the same time.
+void CustomAggOutLevel::run()
 {
-
-    // data to (temporarily) store values: per species vector (dim=fields) of vectors (dim=trees)
-    QMap<QString, QVector<QVector<double> > > data;
-    TreeWrapper tw;
-    bool do_filter = !mEntityFilter.isEmpty();
+    Model *model = GlobalSettings::instance()->model();
+    QVector<SWorkItem> items;
 
     switch (mLevel) {
-    case CustomAggOut::sLandscape: {
-        // loop over all trees in the landsacpe
-        AllTreeIterator ati(GlobalSettings::instance()->model());
-        while (Tree *t = ati.next()) {
-            if (do_filter) {
-                tw.setTree(t);
-                if (!mEntityFilter.calculateBool(tw))
-                    continue; // skip
-            }
-            processTree(t, data);
-        }
-        writeResults(data, nullptr, 0);
-
-    }
+    case CustomAggOut::sLandscape:
     case CustomAggOut::sRU: {
-        const QList<ResourceUnit*> &ru_list = GlobalSettings::instance()->model()->ruList();
+        const QList<ResourceUnit*> &ru_list = model->ruList();
+        items.reserve(ru_list.size());
         for (int i=0;i<ru_list.size();++i) {
-            data.clear();
-            if (!mLevelFilter.isEmpty()) {
+            if (mLevel == CustomAggOut::sRU && !mLevelFilter.isEmpty()) {
                 if (!mLevelFilter.calculateBool(ru_list[i]->id()))
                     continue;
             }
-
-            // loop over all trees
-            QVector<Tree> &trees = ru_list[i]->trees();
-            for (int j=0; j<trees.size();++j) {
-                if (do_filter) {
-                    tw.setTree(&trees[j]);
-                    if (!mEntityFilter.calculateBool(tw))
-                        continue; // skip
-                }
-                processTree(&trees[j], data);
-            }
-
-            writeResults(data, ru_list[i], 0);
-
+            items.push_back(SWorkItem());
+            items.back().ru = ru_list[i];
         }
         break;
     }
@@ -275,332 +278,190 @@ void CustomAggOutLevel::runTrees()
             throw IException("CustomAggOut: aggregation per stand, but no valid standgrid available / set!");
 
         QList<int> ids = mStandGrid->mapIds();
+        items.reserve(ids.size());
         for (int i=0;i<ids.size();++i) {
             if (!mLevelFilter.isEmpty()) {
                 if (!mLevelFilter.calculateBool(ids[i]))
                     continue;
             }
-
-            data.clear();
             // skip stands with Ids < 1 (empty, out of project area)
             if (ids[i] <= 0)
                 continue;
-
-            // loop over all trees of each stand
-            QVector<Tree*> trees = mStandGrid->trees(ids[i]);
-            for (int j=0; j<trees.size();++j) {
-                if (do_filter) {
-                    tw.setTree(trees[j]);
-                    if (!mEntityFilter.calculateBool(tw))
-                        continue; // skip
-                }
-                processTree(trees[j], data);
-            }
-
-            writeResults(data, nullptr, ids[i]);
-
+            items.push_back(SWorkItem());
+            items.back().stand_id = ids[i];
         }
         break;
-
     }
     default: return;
-
     }
 
-}
-
-
-
-// process tree based aggregations
-void CustomAggOutLevel::runSnags()
-{
-    if (!Globals->model()->settings().carbonCycleEnabled)
-        throw IException("CustomAgg: should process Snags, but carbon cycle is not enabled in the model!");
-
-    // data to (temporarily) store values: per species vector (dim=fields) of vectors (dim=trees)
-    QMap<QString, QVector<QVector<double> > > data;
-    DeadTreeWrapper tw;
-    bool do_filter = !mEntityFilter.isEmpty();
-
-    switch (mLevel) {
-    case CustomAggOut::sLandscape: {
-        // loop over all trees in the landsacpe
-        for (const auto &ru : Globals->model()->ruList()) {
-            for (const auto &dt : ru->snag()->deadTrees()) {
-                if (do_filter) {
-                    tw.setDeadTree(&dt);
-                    if (!mEntityFilter.calculateBool(tw))
-                        continue;
-                }
-                processSnag(&dt, data);
-            }
-        }
-
-        writeResults(data, nullptr, 0);
-
+    for (int i=0;i<items.size();++i) {
+        items[i].output = this;
+        items[i].block.setAggregator(&mAggregator);
     }
-    case CustomAggOut::sRU: {
-
-        for (const auto &ru : Globals->model()->ruList()) {
-
-            data.clear();
-            if (!mLevelFilter.isEmpty()) {
-                if (!mLevelFilter.calculateBool(ru->id()))
-                    continue;
-            }
-
-            // loop over all snags
-            for (const auto &dt : ru->snag()->deadTrees()) {
-                if (do_filter) {
-                    tw.setDeadTree(&dt);
-                    if (!mEntityFilter.calculateBool(tw))
-                        continue; // skip
-                }
-                processSnag(&dt, data);
-            }
-
-            writeResults(data, ru, 0);
-
-        }
-        break;
-    }
-    case CustomAggOut::sStand: {
-        if (!mStandGrid || !mStandGrid->isValid())
-            throw IException("CustomAggOut: aggregation per stand, but no valid standgrid available / set!");
-
-        QList<int> ids = mStandGrid->mapIds();
-        QVector<DeadTree*> dead_trees;
-        for (int i=0;i<ids.size();++i) {
-            if (!mLevelFilter.isEmpty()) {
-                if (!mLevelFilter.calculateBool(ids[i]))
-                    continue;
-            }
-
-            data.clear();
-            // skip stands with Ids < 1 (empty, out of project area)
-            if (ids[i] <= 0)
-                continue;
-
-            // loop over all trees of each stand
-            mStandGrid->loadDeadTrees(ids[i], dead_trees);
-            for (const auto &dt : dead_trees) {
-                if (do_filter) {
-                    tw.setDeadTree(dt);
-                    if (!mEntityFilter.calculateBool(tw))
-                        continue; // skip
-                }
-                processSnag(dt, data);
-            }
-
-            writeResults(data, nullptr, ids[i]);
-
-        }
-        break;
-
-    }
-    default: return;
-
+    model->threadExec().run(nc_process, items, mSequential);
+    const_cast<ThreadRunner&>(model->threadExec()).checkErrors();
+
+    // write the results
+    if (mLevel == CustomAggOut::sLandscape) {
+        FieldAggregator::Block landscape(&mAggregator);
+        for (int i=0;i<items.size();++i)
+            landscape.merge(items[i].block);
+        writeResults(landscape, nullptr, 0);
+        return;
     }
-
+    for (int i=0;i<items.size();++i)
+        writeResults(items[i].block, items[i].ru, items[i].stand_id);
 }
 
-// process sapling based aggregation
-void CustomAggOutLevel::runSaplings()
+void CustomAggOutLevel::nc_process(SWorkItem &item)
 {
-
-    // data to (temporarily) store values: per species vector (dim=fields) of vectors (dim=trees)
-    QMap<QString, QVector<QVector<double> > > data;
-
-    switch (mLevel) {
-    case CustomAggOut::sLandscape: {
-        // loop over all trees in the landsacpe
-        foreach (ResourceUnit *ru, GlobalSettings::instance()->model()->ruList()) {
-            SaplingCell *s = ru->saplingCellArray();
-            for (int px=0;px<cPxPerHectare;++px, ++s) {
-                int n_on_px = s->n_occupied();
-                if (n_on_px>0) {
-                    processSaplingCell(s, ru, data);
-                }
-            }
+    try {
+        switch (item.output->mEntity) {
+        case CustomAggOut::Trees: item.output->processTrees(item); break;
+        case CustomAggOut::Saplings: item.output->processSaplings(item); break;
+        case CustomAggOut::Snags: item.output->processSnags(item); break;
+        default: break;
         }
-        writeResults(data, nullptr, 0);
-        break;
-
+    } catch (const IException &e) {
+        GlobalSettings::instance()->model()->threadExec().throwError(e.message());
     }
+}
 
-    case CustomAggOut::sRU: {
-        // loop over all trees in the landsacpe
-        foreach (ResourceUnit *ru, GlobalSettings::instance()->model()->ruList()) {
-            if (!mLevelFilter.isEmpty()) {
-                if (!mLevelFilter.calculateBool(ru->id()))
-                    continue;
-            }
-            data.clear(); // reset data for each resource unit
+CustomAggOutLevel::SExpressions::SExpressions(const CustomAggOutLevel *output, ExpressionWrapper *wrapper)
+{
+    filter = output->mEntityFilter.isEmpty() ? nullptr : &output->mEntityFilter;
+    fields.fill(nullptr, output->mFieldList.size());
+    for (int i=0;i<output->mFieldList.size();++i)
+        if (output->mFieldList[i]->var_index<0)
+            fields[i] = &output->mFieldList[i]->expression;
+    if (output->mSequential)
+        return;
 
-            SaplingCell *s = ru->saplingCellArray();
-            for (int px=0;px<cPxPerHectare;++px, ++s) {
-                int n_on_px = s->n_occupied();
-                if (n_on_px>0) {
-                    processSaplingCell(s, ru, data);
-                }
-            }
-            writeResults(data, ru, 0);
-        }
-        break;
+    // parse copies of the expressions
+    if (filter) {
+        local.push_back(new Expression(filter->expression()));
+        local.back()->parse(wrapper);
+        filter = local.back();
     }
-
-    case CustomAggOut::sStand: {
-        if (!mStandGrid || !mStandGrid->isValid())
-            throw IException("CustomAggOut: aggregation per stand, but no valid standgrid available / set!");
-
-        QList<int> ids = mStandGrid->mapIds();
-        for (int i=0;i<ids.size();++i) {
-            if (!mLevelFilter.isEmpty()) {
-                if (!mLevelFilter.calculateBool(ids[i]))
-                    continue;
-            }
-
-            data.clear();
-            // skip stands with Ids < 1 (empty, out of project area)
-            if (ids[i] <= 0)
-                continue;
-
-            SaplingCellRunner scr(ids[i], mStandGrid);
-            SaplingWrapper sw;
-
-            while (SaplingCell *sc = scr.next()) {
-                processSaplingCell(sc, scr.ru(), data);
-            }
-            writeResults(data, nullptr, ids[i]);
+    for (int i=0;i<fields.size();++i) {
+        if (fields[i]) {
+            local.push_back(new Expression(fields[i]->expression()));
+            local.back()->parse(wrapper);
+            fields[i] = local.back();
         }
-        break;
-
-    }
-    default: return;
     }
-
 }
 
-
-
-void CustomAggOutLevel::processTree(const Tree *t, QMap<QString, QVector< QVector<double> > > &data)
+template <class W>
+void CustomAggOutLevel::addValues(W &wrapper, const int species_index, SWorkItem &item, const SExpressions &expr, QVector<double> &values) const
 {
-    TreeWrapper tw;
-    tw.setTree(t);
-
-    if (!data.contains(t->species()->id()))
-        data[t->species()->id()] = QVector<QVector<double> >(mFieldList.size(), QVector<double>(0));
-
-    QVector< QVector<double> >  &dat = data[t->species()->id()];
-
-    // retrieve values for all fields for the tree
+    // retrieve values for all fields for the entity
     for (int i=0;i<mFieldList.size();++i) {
-        SDynamicField *field = mFieldList[i];
-        if (field->var_index>-1) {
-            dat[i].push_back(tw.value(field->var_index));
-        } else {
-            dat[i].push_back( field->expression.calculate(tw) );
-        }
+        const SDynamicField *field = mFieldList[i];
+        if (field->var_index>-1)
+            values[i] = wrapper.value(field->var_index);
+        else
+            values[i] = expr.fields[i]->calculate(wrapper);
     }
+    item.block.add(species_index, values.constData());
 }
 
-void CustomAggOutLevel::processSaplingCell(const SaplingCell *sc, const ResourceUnit *ru, QMap<QString, QVector<QVector<double> > > &data)
+// process tree based aggregations
+void CustomAggOutLevel::processTrees(SWorkItem &item) const
 {
-    bool do_filter = !mEntityFilter.isEmpty();
-
-    SaplingWrapper sw;
-    for (int i=0;i<NSAPCELLS;++i) {
-        if (sc->saplings[i].is_occupied()) {
-
-            if (do_filter) {
-                sw.setSaplingTree(&sc->saplings[i], ru);
-                if (!mEntityFilter.calculateBool(sw))
-                    continue; //
-            }
-            processSapling(&sc->saplings[i],
-                           ru,
-                           sc->saplings[i].resourceUnitSpecies(ru)->species()->id(), //
-                           data);
-
+    TreeWrapper tw;
+    SExpressions expr(this, &tw);
+    QVector<double> values(mFieldList.size());
+    if (item.ru) {
+        // loop over all trees of the resource unit
+        const QVector<Tree> &trees = item.ru->trees();
+        for (int j=0; j<trees.size();++j) {
+            tw.setTree(&trees[j]);
+            if (expr.filter && !expr.filter->calculateBool(tw))
+                continue; // skip
+            addValues(tw, trees[j].species()->index(), item, expr, values);
+        }
+    } else {
+        // loop over all trees of the stand
+        QList<Tree*> trees = mStandGrid->trees(item.stand_id);
+        for (int j=0; j<trees.size();++j) {
+            tw.setTree(trees[j]);
+            if (expr.filter && !expr.filter->calculateBool(tw))
+                continue; // skip
+            addValues(tw, trees[j]->species()->index(), item, expr, values);
         }
     }
 }
 
-void CustomAggOutLevel::processSapling(const SaplingTree *t, const ResourceUnit *ru, const QString &speciesId, QMap<QString, QVector<QVector<double> > > &data)
+// process snag based aggregations
+void CustomAggOutLevel::processSnags(SWorkItem &item) const
 {
-    SaplingWrapper sw;
-    sw.setSaplingTree(t, ru);
-
-    if (!data.contains(speciesId))
-        data[speciesId] = QVector<QVector<double> >(mFieldList.size(), QVector<double>(0));
-
-    QVector< QVector<double> >  &dat = data[speciesId]; // get a reference to the underlying data
-
-    // retrieve values for all fields for the tree
-    for (int i=0;i<mFieldList.size();++i) {
-        SDynamicField *field = mFieldList[i];
-        if (field->var_index>-1) {
-            dat[i].push_back(sw.value(field->var_index));
-        } else {
-            dat[i].push_back( field->expression.calculate(sw) );
+    DeadTreeWrapper tw;
+    SExpressions expr(this, &tw);
+    QVector<double> values(mFieldList.size());
+    if (item.ru) {
+        // loop over all snags of the resource unit
+        for (const auto &dt : item.ru->snag()->deadTrees()) {
+            tw.setDeadTree(&dt);
+            if (expr.filter && !expr.filter->calculateBool(tw))
+                continue; // skip
+            addValues(tw, dt.species()->index(), item, expr, values);
+        }
+    } else {
+        // loop over all snags of the stand
+        QVector<DeadTree*> dead_trees;
+        mStandGrid->loadDeadTrees(item.stand_id, dead_trees);
+        for (const auto &dt : dead_trees) {
+            tw.setDeadTree(dt);
+            if (expr.filter && !expr.filter->calculateBool(tw))
+                continue; // skip
+            addValues(tw, dt->species()->index(), item, expr, values);
         }
     }
 }
 
-void CustomAggOutLevel::processRU(const ResourceUnit *ru)
+// process sapling based aggregation
+void CustomAggOutLevel::processSaplings(SWorkItem &item) const
 {
-    RUWrapper rw;
-    rw.setResourceUnit(ru);
-
-    // retrieve values for all fields for the tree
-    for (int i=0;i<mFieldList.size();++i) {
-        SDynamicField *field = mFieldList[i];
-        if (field->var_index>-1) {
-            //field.data.push_back(rw.value(field.var_index));
-            // TODO
-        } else {
-            //field.data.push_back( field.expression->calculate(rw) );
-            // TODO
+    QVector<double> values(mFieldList.size());
+    if (item.ru) {
+        // loop over all sapling cells of the resource unit
+        SaplingCell *s = item.ru->saplingCellArray();
+        for (int px=0;px<cPxPerHectare;++px, ++s) {
+            if (s->n_occupied()>0)
+                processSaplingCell(s, item.ru, item, expr, values);
         }
+    } else {
+        SaplingCellRunner scr(item.stand_id, mStandGrid);
+        while (SaplingCell *sc = scr.next())
+            processSaplingCell(sc, scr.ru(), item, expr, values);
     }
 }
 
-void CustomAggOutLevel::processSnag(const DeadTree *dt, QMap<QString, QVector<QVector<double> > > &data)
+void CustomAggOutLevel::processSaplingCell(const SaplingCell *sc, const ResourceUnit *ru, SWorkItem &item, const SExpressions &expr, QVector<double> &values) const
 {
-    DeadTreeWrapper tw;
-    tw.setDeadTree(dt);
-
-    if (!data.contains(dt->species()->id()))
-        data[dt->species()->id()] = QVector<QVector<double> >(mFieldList.size(), QVector<double>(0));
-
-    QVector< QVector<double> >  &dat = data[dt->species()->id()];
-
-    // retrieve values for all fields for the tree
-    for (int i=0;i<mFieldList.size();++i) {
-        SDynamicField *field = mFieldList[i];
-        if (field->var_index>-1) {
-            dat[i].push_back(tw.value(field->var_index));
-        } else {
-            dat[i].push_back( field->expression.calculate(tw) );
+    SaplingWrapper sw;
+    for (int i=0;i<NSAPCELLS;++i) {
+        if (sc->saplings[i].is_occupied()) {
+            sw.setSaplingTree(&sc->saplings[i], ru);
+            if (expr.filter && !expr.filter->calculateBool(sw))
+                continue;
+            addValues(sw, sc->saplings[i].resourceUnitSpecies(ru)->species()->index(), item, expr, values);
         }
     }
 }
 
-void CustomAggOutLevel::writeResults(QMap<QString, QVector<QVector<double> > > &data, ResourceUnit *ru, int stand_id)
+void CustomAggOutLevel::writeResults(const FieldAggregator::Block &block, ResourceUnit *ru, int stand_id)
 {
-
-    foreach( QString species, data.keys()) {
-
-        // data: field - trees
-        QVector<QVector<double> > &dat = data[species];
-
-        writeFirstCols(species, ru, stand_id);
+    SpeciesSet *species_set = GlobalSettings::instance()->model()->speciesSet();
+    const QList<int> groups = block.groups();
+    for (int species_index : groups) {
+        writeFirstCols(species_set->species(species_index)->id(), ru, stand_id);
 
         for (int i=0;i<mFieldList.size();++i) {
             // summarize according to the definition
-            double value = aggregate(*mFieldList[i], dat[i] );
-            // add to output stream
-            *this << value;
+            *this << block.value(species_index, i);
         }
 
         writeRow();
@@ -610,7 +471,7 @@ void CustomAggOutLevel::writeResults(QMap<QString, QVector<QVector<double> > > &
 
 
 
-void CustomAggOutLevel::writeFirstCols(QString &species_id, ResourceUnit *ru, int stand_id)
+void CustomAggOutLevel::writeFirstCols(const QString &species_id, ResourceUnit *ru, int stand_id)
 {
     *this << currentYear(); // year in all outputs
 
@@ -628,58 +489,3 @@ void CustomAggOutLevel::writeFirstCols(QString &species_id, ResourceUnit *ru, in
     }
 
 }
-
-
-double CustomAggOutLevel::aggregate(const SDynamicField &field, QVector<double> &data)
-{
-    StatData stat(data);
-    // aggregate
-    double value;
-    switch (field.agg_index) {
-    case 0: value = stat.mean(); break;
-    case 1: value = stat.sum(); break;
-    case 2: value = stat.min(); break;
-    case 3: value = stat.max(); break;
-    case 4: value = stat.percentile25(); break;
-    case 5: value = stat.median(); break;
-    case 6: value = stat.percentile75(); break;
-    case 7: value = stat.percentile(5); break;
-    case 8: value = stat.percentile(10); break;
-    case 9: value = stat.percentile(90); break;
-    case 10: value = stat.percentile(95); break;
-    case 11: value = stat.standardDev(); break;
-    case 12: value = stat.percentile(80); break;
-    case 13: value = stat.percentile(85); break;
-    default: value = 0.; break;
-    }
-    return value;
-}
-
-void CustomAggOutLevel::populateSaplingData(QMap<QString, QVector<QPair<SaplingTree *, ResourceUnit *> > > &data, Expression &filter, SaplingCell *sapcell, bool by_species)
-{
-
-    if (sapcell){
-        SaplingWrapper sw;
-        for (int i=0;i<NSAPCELLS;++i) {
-            if (sapcell->saplings[i].is_occupied()) {
-
-                if (!filter.isEmpty()) {
-                    sw.setSaplingTree(&sapcell->saplings[i], sapcell->ru);
-                    if (!filter.execute())
-                        continue; //
-                }
-                // store a pointer to the sapling tree in the data structure
-                if (by_species) {
-
-                    data[ sapcell->saplings[i].resourceUnitSpecies(sapcell->ru)->species()->id() ].push_back( QPair<SaplingTree*, ResourceUnit*> (&sapcell->saplings[i], sapcell->ru) );
-                } else {
-                    data[ "" ].push_back( QPair<SaplingTree*, ResourceUnit*> (&sapcell->saplings[i], sapcell->ru) );
-                }
-
-            }
-        }
-    }
-
-
-}
-
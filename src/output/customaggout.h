@@ -22,6 +22,7 @@
 
 #include "output.h"
 #include "expression.h"
+#include "fieldaggregator.h"
 
 struct SaplingTree; // forward
 struct SaplingCell; // forward
@@ -29,6 +30,7 @@ class ResourceUnit; // forward
 class Tree; // forward
 class MapGrid; // forward
 class DeadTree; // forward
+class ExpressionWrapper; // forward
 
 class CustomAggOut : public Output
 {
@@ -52,6 +54,7 @@ private:
 
 class CustomAggOutLevel : public Output {
 public:
+    ~CustomAggOutLevel();
     virtual void exec();
     virtual void setup();
     void setStandGrid(MapGrid* m) { mStandGrid = m; }
@@ -75,28 +78,38 @@ private:
 
     QVector<SDynamicField*> mFieldList;
     const MapGrid *mStandGrid;
-
-    // helper function to aggregate values of a vector(means, medians, percentiles)
-    double aggregate(const SDynamicField &field, QVector<double> &data);
-    void populateSaplingData(QMap<QString, QVector<QPair<SaplingTree*, ResourceUnit*> > > &data, Expression &filter, SaplingCell *sapcell, bool by_species);
-
-    void extractByResourceUnit(const bool by_species);
-
-    void runSaplings(); ///< process saplings
-    void runTrees(); ///< process on tree level
-    void runSnags(); ///< process on snag level
-
-    // functions that process a single element (tree, sapling, ru)
-    // and populate the data in fieldlist
-    void processTree(const Tree *t, QMap<QString, QVector<QVector<double> > > &data);
-    void processSapling(const SaplingTree *t, const ResourceUnit *ru, const QString &speciesId, QMap<QString, QVector<QVector<double> > > &data);
-    void processSaplingCell(const SaplingCell *sc, const ResourceUnit *ru, QMap<QString, QVector<QVector<double> > > &data);
-    void processRU(const ResourceUnit *ru);
-    void processSnag(const DeadTree *dt, QMap<QString, QVector<QVector<double> > > &data);
-
-    // aggregation & write outputs functions
-    void writeResults(QMap<QString, QVector<QVector<double> > >  &data, ResourceUnit *ru, int stand_id);
-    void writeFirstCols(QString &species_id, ResourceUnit *ru, int stand_id);
+    FieldAggregator mAggregator; ///< aggregation of all fields in a single pass over the entities
+    bool mSequential; ///< true if a field or the entity filter uses incsum(): the work items are processed sequentially
+
+    // a unit of work: a resource unit (RU and landscape level) or a stand (stand level). The work items are processed in parallel.
+    struct SWorkItem {
+        SWorkItem(): output(nullptr), ru(nullptr), stand_id(0) {}
+        const CustomAggOutLevel *output;
+        ResourceUnit *ru;
+        int stand_id;
+        FieldAggregator::Block block; ///< aggregated data per species (index)
+    };
+    // the expressions (entity filter, fields) used by a work item: each work item parses its own copies (calculate() is not
+    // thread safe). If processed sequentially (incsum()), the shared expressions are used.
+    struct SExpressions {
+        SExpressions(const CustomAggOutLevel *output, ExpressionWrapper *wrapper);
+        ~SExpressions() { qDeleteAll(local); }
+        const Expression *filter; ///< the entity filter (nullptr if empty)
+        QVector<const Expression*> fields; ///< expression per field (nullptr for simple variables)
+        QList<Expression*> local; ///< the copies owned by the work item
+    };
+    void run(); ///< process trees, saplings, or snags on the given level
+    static void nc_process(SWorkItem &item);
+    void processTrees(SWorkItem &item) const;
+    void processSaplings(SWorkItem &item) const;
+    void processSnags(SWorkItem &item) const;
+    void processSaplingCell(const SaplingCell *sc, const ResourceUnit *ru, SWorkItem &item, const SExpressions &expr, QVector<double> &values) const;
+    /// evaluate all fields for the entity of 'wrapper' and add to the block of 'item'
+    template <class W> void addValues(W &wrapper, const int species_index, SWorkItem &item, const SExpressions &expr, QVector<double> &values) const;
+
+    // write outputs functions
+    void writeResults(const FieldAggregator::Block &block, ResourceUnit *ru, int stand_id);
+    void writeFirstCols(const QString &species_id, ResourceUnit *ru, int stand_id);
 };
 
 // declare as relocatable: this tells the QVector container
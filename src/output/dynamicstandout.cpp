@@ -19,18 +19,22 @@
 #include "dynamicstandout.h"
 
 #include "debugtimer.h"
-#include "statdata.h"
 #include "model.h"
 #include "resourceunit.h"
 #include "species.h"
+#include "speciesset.h"
+#include "tree.h"
 #include "expressionwrapper.h"
 
+#include <QScopedPointer>
+
 DynamicStandOut::DynamicStandOut()
 {
+    mSequential = false;
     setName("dynamic stand output by species/RU", "dynamicstand");
     setDescription("Userdefined outputs for tree aggregates for each stand or species.\n"\
-                   "Technically, each field is calculated 'live', i.e. it is looped over all trees, and eventually the statistics (percentiles) "\
-                   "are calculated. The aggregated values are not scaled to any area unit.\n" \
+                   "Technically, all fields are calculated 'live' in a single pass over all trees (in parallel for resource units). "\
+                   "The aggregated values are not scaled to any area unit.\n" \
                    "!!!Specifying the aggregation\n" \
                    "The ''by_species'' and ''by_ru'' option allow to define the aggregation level. When ''by_species'' is set to ''true'', " \
                    "a row for each species will be created, otherwise all trees of all species are aggregated to one row. " \
@@ -45,13 +49,17 @@ DynamicStandOut::DynamicStandOut()
                    "Each field is defined as: ''field.aggregation'' (separated by a dot). A ''field'' is a valid [Expression]. ''Aggregation'' is one of the following:  " \
                    "mean, sum, min, max, p25, p50, p75, p5, 10, p80, p85, p90, p95 (pXX=XXth percentile), sd (std.dev.).\n" \
                    "Complex expression are allowed, e.g: if(dbh>50,1,0).sum (-> counts trees with dbh>50)\n" \
+                   "Percentiles are calculated from all values; set ''percentiles'' to 'sketch' for approximated percentiles with a relative accuracy of 0.5% (exact for up to 128 trees per row; faster, less memory).\n" \
                    "Note that the column names in the output table may be slightly different, as dots (and other special characsters) are not allowed in column names und substituted.\n" \
                    "Note also, that `customagg` is another highly customizable output (https://iland-model.org/dynamic+outputs).");
     columns() << OutputColumn::year() << OutputColumn::ru()  << OutputColumn::id() << OutputColumn::species();
     // other colums are added during setup...
 }
 
-const QStringList aggList = QStringList() << "mean" << "sum" << "min" << "max" << "p25" << "p50" << "p75" << "p5"<< "p10" << "p90" << "p95" << "sd" << "p80" << "p85";
+DynamicStandOut::~DynamicStandOut()
+{
+    qDeleteAll(mFieldList);
+}
 
 void DynamicStandOut::setup()
 {
@@ -60,6 +68,7 @@ void DynamicStandOut::setup()
     QString fieldList = settings().value(".columns", "");
     QString condition = settings().value(".condition", "");
     QString conditionRU = settings().value(".conditionRU", "");
+    FieldAggregator::PercentileMode percentile_mode = FieldAggregator::percentileMode(settings().value(".percentiles", "exact"));
 
     if (fieldList.isEmpty())
         return;
@@ -69,9 +78,11 @@ void DynamicStandOut::setup()
     mConditionRU.setExpression(conditionRU);
     // clear columns
     columns().erase(columns().begin()+4, columns().end());
+    qDeleteAll(mFieldList);
     mFieldList.clear();
 
     // setup fields
+    QVector<int> aggregations;
     if (!fieldList.isEmpty()) {
         QRegularExpression re("([^\\.]+).(\\w+)[,\\s]*"); // two parts: before dot and after dot, and , + whitespace at the end
 
@@ -83,21 +94,24 @@ void DynamicStandOut::setup()
             field = match.captured(1);
             aggregation = match.captured(2);
 
-            mFieldList.append(SDynamicField());
+            SDynamicField *dfield = new SDynamicField;
+            mFieldList.append(dfield);
             // parse field
             if (field.size()>0 && !field.contains('(')) {
                 // simple expression
-                mFieldList.back().var_index = tw.variableIndex(field);
+                dfield->var_index = tw.variableIndex(field);
             } else {
-                // complex expression
-                mFieldList.back().var_index=-1;
-                mFieldList.back().expression = field;
+                // complex expression: parse now (the expressions are evaluated in parallel later)
+                dfield->var_index=-1;
+                dfield->expression.setExpression(field);
+                dfield->expression.parse(&tw);
             }
 
-            mFieldList.back().agg_index = aggList.indexOf(aggregation);
-            if (mFieldList.back().agg_index==-1)
+            dfield->agg_index = FieldAggregator::aggregationIndex(aggregation);
+            if (dfield->agg_index==-1)
                 throw IException(QString("Invalid aggregate expression for dynamic output: %1\nallowed:%2")
-                                 .arg(aggregation).arg(aggList.join(" ")));
+                                 .arg(aggregation).arg(FieldAggregator::aggregationNames().join(" ")));
+            aggregations.push_back(dfield->agg_index);
 
             QString stripped_field=QString("%1_%2").arg(field, aggregation);
             stripped_field.replace(QRegularExpression("[\\[\\]\\,\\(\\)<>=!\\-\\+/\\*\\s]"), "_");
@@ -105,6 +119,20 @@ void DynamicStandOut::setup()
             columns() << OutputColumn(stripped_field, field, OutDouble);
         }
     }
+    mAggregator.setup(aggregations, percentile_mode);
+    // the filters are evaluated in parallel, too
+    TreeWrapper tw;
+    RUWrapper ruwrapper;
+    if (!mTreeFilter.isEmpty())
+        mTreeFilter.parse(&tw);
+    if (!mRUFilter.isEmpty())
+        mRUFilter.parse(&ruwrapper);
+
+    // incsum() depends on the order of the trees, i.e. such expressions are not evaluated in parallel
+    mSequential = mTreeFilter.usesIncSum() || mRUFilter.usesIncSum();
+    foreach(const SDynamicField *field, mFieldList)
+        if (field->var_index<0 && field->expression.usesIncSum())
+            mSequential = true;
 }
 
 void DynamicStandOut::exec()
@@ -117,211 +145,123 @@ void DynamicStandOut::exec()
 
     DebugTimer t("dynamic stand output");
 
-    bool per_species = GlobalSettings::instance()->settings().valueBool("output.dynamicstand.by_species", true);
+    mPerSpecies = GlobalSettings::instance()->settings().valueBool("output.dynamicstand.by_species", true);
     bool per_ru = GlobalSettings::instance()->settings().valueBool("output.dynamicstand.by_ru", true);
     bool per_ru_cond=false;
 
     if (!mConditionRU.isEmpty() && mConditionRU.calculate(GlobalSettings::instance()->currentYear()))
         per_ru_cond = true;
 
+    // RU level outputs: if 'by_ru' is true, or *in addition* to the landscape level if 'conditionRU' is true.
+    // All trees are visited only once (in parallel for all resource units); all fields are aggregated at the same time.
+    Model *m = GlobalSettings::instance()->model();
+    QVector<SRUData> ru_data(m->ruList().size());
+    for (int i=0;i<ru_data.size();++i) {
+        SRUData &d = ru_data[i];
+        d.output = this;
+        d.ru = m->ruList()[i];
+        d.ru_level = per_ru || per_ru_cond;
+        d.landscape = !per_ru;
+        d.ru_block.setAggregator(&mAggregator);
+        d.all_block.setAggregator(&mAggregator);
+    }
+    m->threadExec().run(nc_aggregate, ru_data, mSequential);
+    const_cast<ThreadRunner&>(m->threadExec()).checkErrors();
 
-    if (per_ru) {
-        // when looping over resource units, do it differently (old way)
-        extractByResourceUnit(per_species);
-        return;
+    if (per_ru || per_ru_cond) {
+        for (int i=0;i<ru_data.size();++i)
+            writeRows(ru_data[i].ru_block, ru_data[i].ru);
     }
-    if (per_ru_cond) {
-        // in this case the RU level outputs are *in addition* to the landscape means
-        extractByResourceUnit(per_species);
+    if (!per_ru) {
+        // landscape level: merge the data of all resource units
+        FieldAggregator::Block landscape(&mAggregator);
+        for (int i=0;i<ru_data.size();++i)
+            landscape.merge(ru_data[i].all_block);
+        writeRows(landscape, nullptr);
     }
+}
 
-    Model *m = GlobalSettings::instance()->model();
-    QVector<double> data; //statistics data
-    TreeWrapper tw;
-    Expression custom_expr;
-
-    StatData stat; // statistcs helper class
-    // grouping
-    QVector<const Tree*> trees;
-    for (QList<Species*>::const_iterator species = m->speciesSet()->activeSpecies().constBegin();species!=m->speciesSet()->activeSpecies().constEnd();++species) {
-        trees.clear();
-        AllTreeIterator all_trees(m);
-        while (const Tree *t = all_trees.nextLiving()) {
-            if (per_species && t->species() != *species)
-                continue;
-            trees.push_back(t);
+void DynamicStandOut::nc_aggregate(SRUData &data)
+{
+    try {
+        const DynamicStandOut *out = data.output;
+        ResourceUnit *ru = data.ru;
+        bool ru_level = data.ru_level && ru->id()!=-1; // do not include if out of project area
+        // test filter
+        RUWrapper ruwrapper(ru);
+        if (ru_level && !out->mRUFilter.isEmpty()) {
+            Expression local_ru_filter;
+            if (!localExpression(out, out->mRUFilter, local_ru_filter, &ruwrapper).calculateBool(ruwrapper))
+                ru_level = false;
         }
-        if (trees.size()==0)
-            continue;
-        // dynamic calculations
-        foreach (const SDynamicField &field, mFieldList) {
-
-            if (!field.expression.isEmpty()) {
-                // setup dynamic dynamic expression if present
-                custom_expr.setExpression(field.expression);
-                custom_expr.setModelObject(&tw);
-            }
-
-            // fetch data values from the trees
-            data.clear();
-            foreach(const Tree *t, trees) {
-                tw.setTree(t);
-                if (field.var_index>=0)
-                    data.push_back(tw.value(field.var_index));
-                else
-                    data.push_back(custom_expr.execute());
-            }
-            // constant values (if not already present)
-            if (isRowEmpty()) {
-                *this << currentYear() << -1 << -1;
-                if (per_species)
-                    *this << (*species)->id();
-                else
-                    *this << "";
-            }
+        if (!ru_level && !data.landscape)
+            return;
 
-            // calculate statistics
-            stat.setData(data);
-            // aggregate
-            double value;
-            switch (field.agg_index) {
-            case 0: value = stat.mean(); break;
-            case 1: value = stat.sum(); break;
-            case 2: value = stat.min(); break;
-            case 3: value = stat.max(); break;
-            case 4: value = stat.percentile25(); break;
-            case 5: value = stat.median(); break;
-            case 6: value = stat.percentile75(); break;
-            case 7: value = stat.percentile(5); break;
-            case 8: value = stat.percentile(10); break;
-            case 9: value = stat.percentile(90); break;
-            case 10: value = stat.percentile(95); break;
-            case 11: value = stat.standardDev(); break;
-            case 12: value = stat.percentile(80); break;
-            case 13: value = stat.percentile(85); break;
+        // the expressions of the fields and the tree filter (a copy for each resource unit, see localExpression())
+        TreeWrapper tw;
+        Expression local_tree_filter;
+        const Expression &tree_filter = localExpression(out, out->mTreeFilter, local_tree_filter, &tw);
+        QScopedArrayPointer<Expression> local_fields(new Expression[out->mFieldList.size()]);
+        QVector<const Expression*> expressions(out->mFieldList.size(), nullptr);
+        for (int i=0;i<out->mFieldList.size();++i)
+            if (out->mFieldList[i]->var_index<0)
+                expressions[i] = &localExpression(out, out->mFieldList[i]->expression, local_fields[i], &tw);
+
+        QVector<double> values(out->mFieldList.size());
+        foreach(const Tree &tree, ru->trees()) {
+            if (tree.isDead())
+                continue;
+            tw.setTree(&tree);
+            // apply treefilter (on the RU level)
+            bool use_ru = ru_level;
+            if (use_ru && !tree_filter.isEmpty())
+                use_ru = tree_filter.calculateBool(tw);
+            if (!use_ru && !data.landscape)
+                continue;
 
-            default: value = 0.; break;
+            // fetch all values of the tree
+            for (int i=0;i<out->mFieldList.size();++i) {
+                const SDynamicField *field = out->mFieldList[i];
+                values[i] = field->var_index>=0 ? tw.value(field->var_index) : expressions[i]->calculate(tw);
             }
-            // add current value to output
-            *this << value;
+            int group = out->mPerSpecies ? tree.species()->index() : -1;
+            if (use_ru)
+                data.ru_block.add(group, values.constData());
+            if (data.landscape)
+                data.all_block.add(group, values.constData());
         }
-        if (!isRowEmpty())
-            writeRow();
-
-        if (!per_species)
-            break;
+    } catch (const IException &e) {
+        GlobalSettings::instance()->model()->threadExec().throwError(e.message());
     }
-
 }
 
-
-void DynamicStandOut::extractByResourceUnit(const bool by_species)
+const Expression &DynamicStandOut::localExpression(const DynamicStandOut *out, const Expression &shared, Expression &local, ExpressionWrapper *wrapper)
 {
+    // calculate() is not thread safe: each resource unit parses its own copy of the expression.
+    // When processed sequentially (incsum()), the shared expression is used (the sum is over all resource units).
+    if (out->mSequential || shared.isEmpty())
+        return shared;
+    local.setExpression(shared.expression());
+    local.parse(wrapper);
+    return local;
+}
 
-    if (mFieldList.count()==0)
-        return;
-
-    Model *m = GlobalSettings::instance()->model();
-    QVector<double> data; //statistics data
-    StatData stat; // statistcs helper class
-    TreeWrapper tw;
-    RUWrapper ruwrapper;
-    mRUFilter.setModelObject(&ruwrapper);
-
-    Expression custom_expr;
-
-
-    foreach(ResourceUnit *ru, m->ruList()) {
-        if (ru->id()==-1)
-            continue; // do not include if out of project area
-
-        // test filter
-        if (!mRUFilter.isEmpty()) {
-            ruwrapper.setResourceUnit(ru);
-            if (!mRUFilter.execute())
-                continue;
-        }
-        foreach(const ResourceUnitSpecies *rus, ru->ruSpecies()) {
-            if (by_species && rus->constStatistics().count()==0)
-                continue;
-
-
-            // dynamic calculations
-            foreach (const SDynamicField &field, mFieldList) {
-
-                if (!field.expression.isEmpty()) {
-                    // setup dynamic dynamic expression if present
-                    custom_expr.setExpression(field.expression);
-                    custom_expr.setModelObject(&tw);
-                }
-                data.clear();
-                bool has_trees = false;
-                foreach(const Tree &tree, ru->trees()) {
-                    if (by_species && tree.species()->index()!=rus->species()->index())
-                        continue;
-                    if (tree.isDead())
-                        continue;
-                    tw.setTree(&tree);
-
-                    // apply treefilter
-                    if (!mTreeFilter.isEmpty()) {
-                        mTreeFilter.setModelObject(&tw);
-                        if (!mTreeFilter.execute())
-                            continue;
-                    }
-                    has_trees = true;
-
-                    if (field.var_index>=0)
-                        data.push_back(tw.value(field.var_index));
-                    else
-                        data.push_back(custom_expr.execute());
-                }
-
-                // do nothing if no trees are avaiable
-                if (!has_trees)
-                    continue;
-
-
-                if (isRowEmpty()) {
-                    *this << currentYear()  << ru->index() << ru->id();
-                    if (by_species)
-                        *this << rus->species()->id();
-                    else
-                        *this << "";
-                 }
-
-                // calculate statistics
-                stat.setData(data);
-                // aggregate
-                double value;
-                switch (field.agg_index) {
-                case 0: value = stat.mean(); break;
-                case 1: value = stat.sum(); break;
-                case 2: value = stat.min(); break;
-                case 3: value = stat.max(); break;
-                case 4: value = stat.percentile25(); break;
-                case 5: value = stat.median(); break;
-                case 6: value = stat.percentile75(); break;
-                case 7: value = stat.percentile(5); break;
-                case 8: value = stat.percentile(10); break;
-                case 9: value = stat.percentile(90); break;
-                case 10: value = stat.percentile(95); break;
-                case 11: value = stat.standardDev(); break;
-                case 12: value = stat.percentile(80); break;
-                case 13: value = stat.percentile(85); break;
-
-
-                default: value = 0.; break;
-                }
-                // add current value to output
-                *this << value;
-
-            } // foreach (field)
-            if (!isRowEmpty())
-                writeRow();
-            if (!by_species)
-                break;
-        } //foreach species
-    } // foreach ressource unit
-
+void DynamicStandOut::writeRows(const FieldAggregator::Block &block, const ResourceUnit *ru)
+{
+    const QList<int> groups = block.groups();
+    SpeciesSet *species_set = GlobalSettings::instance()->model()->speciesSet();
+    for (int group : groups) {
+        if (ru)
+            *this << currentYear()  << ru->index() << ru->id();
+        else
+            *this << currentYear() << -1 << -1;
+        if (group>=0)
+            *this << species_set->species(group)->id();
+        else
+            *this << "";
+
+        for (int i=0;i<mFieldList.size();++i)
+            *this << block.value(group, i);
+        writeRow();
+    }
 }
@@ -22,25 +22,46 @@
 
 #include "output.h"
 #include "expression.h"
+#include "fieldaggregator.h"
+
+class ResourceUnit; // forward
+class ExpressionWrapper; // forward
 
 class DynamicStandOut : public Output
 {
 public:
     DynamicStandOut();
+    ~DynamicStandOut();
     virtual void exec();
     virtual void setup();
 private:
-    void extractByResourceUnit(const bool by_species);
     Expression mRUFilter;
     Expression mTreeFilter;
     Expression mCondition;
     Expression mConditionRU;
     struct SDynamicField {
+        SDynamicField(): agg_index(-1), var_index(-1) {}
         int agg_index;
         int var_index;
-        QString expression;
+        Expression expression;
+    };
+    QVector<SDynamicField*> mFieldList;
+    FieldAggregator mAggregator; ///< aggregation of all fields in a single pass
+    bool mPerSpecies; ///< group by species (for the current year)
+    bool mSequential; ///< true if a field or filter uses incsum(): resource units are processed sequentially
+    // data per resource unit (processed in parallel)
+    struct SRUData {
+        SRUData(): output(nullptr), ru(nullptr), ru_level(false), landscape(false) {}
+        const DynamicStandOut *output;
+        ResourceUnit *ru;
+        bool ru_level; ///< collect data on the resource unit level
+        bool landscape; ///< collect data for the landscape
+        FieldAggregator::Block ru_block; ///< data of the resource unit (rufilter/treefilter applied)
+        FieldAggregator::Block all_block; ///< data of all trees (for the landscape)
     };
-    QList<SDynamicField> mFieldList;
+    static void nc_aggregate(SRUData &data);
+    static const Expression &localExpression(const DynamicStandOut *out, const Expression &shared, Expression &local, ExpressionWrapper *wrapper);
+    void writeRows(const FieldAggregator::Block &block, const ResourceUnit *ru);
 };
 
 #endif // DYNAMICSTANDOUT_H
@@ -0,0 +1,281 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#include "global.h"
+#include "fieldaggregator.h"
+#include "statdata.h"
+
+#include <cmath>
+
+// relative accuracy of the quantile sketch
+static const double cSketchAlpha = 0.005;
+static const double cSketchGamma = (1. + cSketchAlpha) / (1. - cSketchAlpha);
+static const double cSketchLogGamma = log(cSketchGamma);
+static const double cSketchMinValue = 1e-9; // smaller absolute values count as 0
+// groups with up to this number of values keep exact values (also in 'sketch' mode)
+static const int cSketchBufferSize = 128;
+
+const QStringList &FieldAggregator::aggregationNames()
+{
+    static const QStringList names = { "mean", "sum", "min", "max",
+                                       "p25", "p50", "p75", "p5", "p10", "p90", "p95",
+                                       "sd", "p80","p85"};
+    return names;
+}
+
+FieldAggregator::PercentileMode FieldAggregator::percentileMode(const QString &mode)
+{
+    if (mode.isEmpty() || mode == "exact")
+        return Exact;
+    if (mode == "sketch")
+        return Sketch;
+    throw IException(QString("Invalid value for 'percentiles': '%1'. Allowed are 'exact' and 'sketch'.").arg(mode));
+}
+
+void FieldAggregator::setup(const QVector<int> &aggregations, const PercentileMode mode)
+{
+    // percentiles corresponding to the aggregation indices
+    static const int percentiles[] = { 0, 0, 0, 0, 25, 50, 75, 5, 10, 90, 95, 0, 80, 85 };
+    mAggregations = aggregations;
+    mMode = mode;
+    mPercentiles.resize(mAggregations.size());
+    for (int i=0;i<mAggregations.size();++i) {
+        if (mAggregations[i]<0 || mAggregations[i]>=aggregationNames().size())
+            throw IException(QString("FieldAggregator: invalid aggregation index %1.").arg(mAggregations[i]));
+        mPercentiles[i] = percentiles[mAggregations[i]];
+    }
+}
+
+/***************************************************************************/
+/*************************  QuantileSketch *********************************/
+/***************************************************************************/
+
+void QuantileSketch::increment(QVector<qint64> &bins, int &offset, const int key, const qint64 n)
+{
+    if (bins.isEmpty()) {
+        offset = key;
+        bins.push_back(0);
+    }
+    if (key < offset) {
+        bins.insert(0, offset - key, 0);
+        offset = key;
+    }
+    if (key >= offset + bins.size())
+        bins.resize(key - offset + 1);
+    bins[key - offset] += n;
+}
+
+void QuantileSketch::add(const double value, const qint64 n)
+{
+    mCount += n;
+    double v = fabs(value);
+    if (v < cSketchMinValue) {
+        mZeros += n;
+        return;
+    }
+    int key = int(ceil(log(v) / cSketchLogGamma));
+    if (value > 0.)
+        increment(mPos, mPosOffset, key, n);
+    else
+        increment(mNeg, mNegOffset, key, n);
+}
+
+void QuantileSketch::merge(const QuantileSketch &other)
+{
+    for (int i=0;i<other.mPos.size();++i)
+        if (other.mPos[i]>0)
+            increment(mPos, mPosOffset, other.mPosOffset + i, other.mPos[i]);
+    for (int i=0;i<other.mNeg.size();++i)
+        if (other.mNeg[i]>0)
+            increment(mNeg, mNegOffset, other.mNegOffset + i, other.mNeg[i]);
+    mZeros += other.mZeros;
+    mCount += other.mCount;
+}
+
+double QuantileSketch::valueAtRank(const qint64 rank) const
+{
+    // the representative value of a bin has the minimum relative error for all values of the bin
+    auto bin_value = [](const int key) { return 2. * pow(cSketchGamma, key) / (cSketchGamma + 1.); };
+    qint64 n = 0;
+    // negative values: the largest absolute values first
+    for (int i=mNeg.size()-1; i>=0; --i) {
+        n += mNeg[i];
+        if (n > rank)
+            return -bin_value(mNegOffset + i);
+    }
+    n += mZeros;
+    if (n > rank)
+        return 0.;
+    for (int i=0; i<mPos.size(); ++i) {
+        n += mPos[i];
+        if (n > rank)
+            return bin_value(mPosOffset + i);
+    }
+    return mPos.isEmpty() ? 0. : bin_value(mPosOffset + mPos.size() - 1);
+}
+
+/***************************************************************************/
+/*************************  Block  *****************************************/
+/***************************************************************************/
+
+// the rank of the value of a percentile (same definition as in StatData::percentile())
+static qint64 percentileRank(const int percent, const qint64 n)
+{
+    int perc = limit(percent, 1, 99);
+    if (perc != 50) {
+        int d = 100 / ( (perc>50?(100-perc):perc) );
+        qint64 k = n / d;
+        if (perc>50)
+            k = n - k - 1;
+        return k;
+    }
+    return (n & 1) ? n / 2 : n / 2 - 1;
+}
+
+void FieldAggregator::Block::addValue(Accumulator &acc, const int field, const double value) const
+{
+    acc.n++;
+    acc.sum += value;
+    double delta = value - acc.mean;
+    acc.mean += delta / double(acc.n);
+    acc.m2 += delta * (value - acc.mean);
+    acc.min = qMin(acc.min, value);
+    acc.max = qMax(acc.max, value);
+    if (mAggregator->mPercentiles[field]==0)
+        return;
+    if (acc.use_sketch) {
+        acc.sketch.add(value);
+        return;
+    }
+    acc.values.push_back(value);
+    if (mAggregator->mMode==Sketch && acc.values.size() > cSketchBufferSize) {
+        // switch to the sketch
+        for (double v : acc.values)
+            acc.sketch.add(v);
+        acc.values.clear();
+        acc.values.squeeze();
+        acc.use_sketch = true;
+    }
+}
+
+void FieldAggregator::Block::mergeAccumulator(Accumulator &acc, const int field, const Accumulator &other) const
+{
+    if (other.n==0)
+        return;
+    if (acc.n==0) {
+        acc = other;
+        return;
+    }
+    // combine mean and variance (Chan et al.)
+    qint64 n = acc.n + other.n;
+    double delta = other.mean - acc.mean;
+    acc.mean += delta * double(other.n) / double(n);
+    acc.m2 += other.m2 + delta*delta * double(acc.n) * double(other.n) / double(n);
+    acc.n = n;
+    acc.sum += other.sum;
+    acc.min = qMin(acc.min, other.min);
+    acc.max = qMax(acc.max, other.max);
+    if (mAggregator->mPercentiles[field]==0)
+        return;
+    if (other.use_sketch && !acc.use_sketch) {
+        for (double v : acc.values)
+            acc.sketch.add(v);
+        acc.values.clear();
+        acc.use_sketch = true;
+    }
+    if (acc.use_sketch) {
+        for (double v : other.values)
+            acc.sketch.add(v);
+        acc.sketch.merge(other.sketch);
+    } else {
+        acc.values.append(other.values);
+        if (mAggregator->mMode==Sketch && acc.values.size() > cSketchBufferSize) {
+            for (double v : acc.values)
+                acc.sketch.add(v);
+            acc.values.clear();
+            acc.use_sketch = true;
+        }
+    }
+}
+
+void FieldAggregator::Block::add(const int group, const double *values)
+{
+    Q_ASSERT(mAggregator && group>=-1);
+    if (group+1 >= mGroups.size())
+        mGroups.resize(group+2);
+    QVector<Accumulator> &accs = mGroups[group+1];
+    if (accs.isEmpty())
+        accs.resize(mAggregator->fieldCount());
+    for (int i=0;i<accs.size();++i)
+        addValue(accs[i], i, values[i]);
+}
+
+void FieldAggregator::Block::merge(const Block &other)
+{
+    if (!mAggregator)
+        mAggregator = other.mAggregator;
+    if (other.mGroups.size() > mGroups.size())
+        mGroups.resize(other.mGroups.size());
+    for (int g=0;g<other.mGroups.size();++g) {
+        const QVector<Accumulator> &src = other.mGroups[g];
+        if (src.isEmpty())
+            continue;
+        QVector<Accumulator> &accs = mGroups[g];
+        if (accs.isEmpty()) {
+            accs = src;
+            continue;
+        }
+        for (int i=0;i<accs.size();++i)
+            mergeAccumulator(accs[i], i, src[i]);
+    }
+}
+
+QList<int> FieldAggregator::Block::groups() const
+{
+    QList<int> result;
+    for (int g=0;g<mGroups.size();++g)
+        if (!mGroups[g].isEmpty() && mGroups[g].first().n>0)
+            result.push_back(g-1);
+    return result;
+}
+
+double FieldAggregator::Block::value(const int group, const int field) const
+{
+    if (group+1 >= mGroups.size() || mGroups[group+1].isEmpty())
+        return 0.;
+    const Accumulator &acc = mGroups[group+1][field];
+    if (acc.n==0)
+        return 0.;
+    switch (mAggregator->mAggregations[field]) {
+    case 0: return acc.sum / double(acc.n); // mean
+    case 1: return acc.sum;
+    case 2: return acc.min;
+    case 3: return acc.max;
+    case 11: return sqrt(qMax(acc.m2, 0.) / double(acc.n)); // standard deviation of the population
+    default: break;
+    }
+    // percentiles
+    int percent = mAggregator->mPercentiles[field];
+    if (!acc.use_sketch) {
+        QVector<double> data = acc.values;
+        StatData stat(data);
+        return stat.percentile(percent);
+    }
+    double value = acc.sketch.valueAtRank(percentileRank(percent, acc.sketch.count()));
+    return limit(value, acc.min, acc.max);
+}
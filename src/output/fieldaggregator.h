@@ -0,0 +1,117 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#ifndef FIELDAGGREGATOR_H
+#define FIELDAGGREGATOR_H
+
+#include <QVector>
+#include <QList>
+#include <QStringList>
+#include <limits>
+
+/** @class FieldAggregator
+  @ingroup output
+  FieldAggregator calculates statistics (mean, sum, min, max, sd, percentiles) for a number of fields (e.g. the
+  columns of the dynamic stand output) and groups (e.g. species) in a single pass over the data. Data is collected
+  in a FieldAggregator::Block (e.g. one block per resource unit, which allows to fill blocks in parallel); blocks can be
+  merged (e.g. to aggregate from resource units to the landscape).
+
+  Mean, sum, min, max and standard deviation are calculated on the fly. For percentiles two modes are available:
+  - Exact (default): all values are stored, percentiles are calculated as in StatData.
+  - Sketch (opt-in): values are stored in logarithmic bins with a relative accuracy of 0.5% (the memory does not depend on
+    the number of values). Small groups (up to 128 values) remain exact.
+  */
+class FieldAggregator
+{
+public:
+    enum PercentileMode { Exact, Sketch };
+    FieldAggregator(): mMode(Exact) {}
+    /// list of valid aggregations ("mean", "sum", ...). The index in the list is the aggregation index.
+    static const QStringList &aggregationNames();
+    static int aggregationIndex(const QString &name) { return aggregationNames().indexOf(name); }
+    /// parse the percentile mode ('exact' (default) or 'sketch'); throws an exception if invalid.
+    static PercentileMode percentileMode(const QString &mode);
+
+    /// setup with the aggregation index (see aggregationNames()) of each field
+    void setup(const QVector<int> &aggregations, const PercentileMode mode);
+    int fieldCount() const { return mAggregations.size(); }
+    PercentileMode mode() const { return mMode; }
+
+    class Block;
+private:
+    QVector<int> mAggregations;
+    QVector<int> mPercentiles; ///< the percentile of a field (0: no percentile)
+    PercentileMode mMode;
+    friend class Block;
+};
+
+/// a bounded-memory approximation of the distribution of values (logarithmic bins)
+class QuantileSketch
+{
+public:
+    QuantileSketch(): mZeros(0), mPosOffset(0), mNegOffset(0), mCount(0) {}
+    void add(const double value, const qint64 n=1);
+    void merge(const QuantileSketch &other);
+    /// approximate value with the rank 'rank' (0: smallest value)
+    double valueAtRank(const qint64 rank) const;
+    qint64 count() const { return mCount; }
+private:
+    static void increment(QVector<qint64> &bins, int &offset, const int key, const qint64 n);
+    QVector<qint64> mPos; ///< bins for positive values
+    QVector<qint64> mNeg; ///< bins for negative values (absolute value)
+    qint64 mZeros; ///< number of values close to zero
+    int mPosOffset, mNegOffset; ///< key of the first bin
+    qint64 mCount;
+};
+
+/** A Block contains the accumulators of all fields for a number of groups (e.g. species).
+    Groups are integers >= -1 (e.g. the index of a species, or -1 for "all species"). */
+class FieldAggregator::Block
+{
+public:
+    Block(): mAggregator(nullptr) {}
+    explicit Block(const FieldAggregator *aggregator): mAggregator(aggregator) {}
+    void setAggregator(const FieldAggregator *aggregator) { mAggregator = aggregator; mGroups.clear(); }
+    /// add a data item to 'group'; 'values' contains one value per field
+    void add(const int group, const double *values);
+    /// merge the data of the block 'other' into this block
+    void merge(const Block &other);
+    /// sorted list of groups that contain data
+    QList<int> groups() const;
+    bool isEmpty() const { return groups().isEmpty(); }
+    /// the aggregated value of 'field' for 'group' (0 for empty groups)
+    double value(const int group, const int field) const;
+    void clear() { mGroups.clear(); }
+private:
+    struct Accumulator {
+        Accumulator(): n(0), sum(0.), mean(0.), m2(0.), min(std::numeric_limits<double>::max()), max(-std::numeric_limits<double>::max()), use_sketch(false) {}
+        qint64 n;
+        double sum;
+        double mean, m2; ///< running mean and sum of squared deviations (Welford)
+        double min, max;
+        QVector<double> values; ///< values for percentiles (exact mode, or before switching to the sketch)
+        QuantileSketch sketch;
+        bool use_sketch;
+    };
+    void addValue(Accumulator &acc, const int field, const double value) const;
+    void mergeAccumulator(Accumulator &acc, const int field, const Accumulator &other) const;
+    const FieldAggregator *mAggregator;
+    QVector< QVector<Accumulator> > mGroups; ///< index: group+1, field
+};
+
+#endif // FIELDAGGREGATOR_H
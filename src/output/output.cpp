@@ -35,6 +35,8 @@
    - overwrite exec()
      add data using the stream operators or add() function of Output. Call writeRow() after each row. Each invokation
      of exec() is a database transaction.
+     Rows are inserted in blocks with a single (multi-row) insert statement; remaining rows are written by flush(), which
+     is called by the OutputManager after exec() and before the transaction is committed.
    - Add the output to the constructor of @c OutputManager
 
    @par Example
@@ -78,6 +80,7 @@
 
 */
 const GlobalSettings *Output::gl = GlobalSettings::instance();
+int Output::mResumeYear = -1;
 
 
 void Output::exec()
@@ -94,6 +97,8 @@ Output::~Output()
     //mInserter.clear();
     if (mInserter)
         delete mInserter;
+    if (mBulkInserter)
+        delete mBulkInserter;
 }
 
 Output::Output()
@@ -103,6 +108,9 @@ Output::Output()
     mOpen = false;
     mEnabled = false;
     mInserter = nullptr;
+    mBulkInserter = nullptr;
+    mBulkRows = 1;
+    mBufferedRows = 0;
     newRow();
 }
 
@@ -134,9 +142,17 @@ void Output::openDatabase()
     if (mInserter->isValid())
         mInserter->clear();
     QSqlQuery creator(db);
-    QString drop=QString("drop table if exists %1").arg(tableName());
-    creator.exec(drop); // drop table (if exists)
-    creator.exec(sql); // (re-)create table
+    if (mResumeYear>=0) {
+        // resume from a checkpoint: keep the table, but remove rows written after the checkpoint
+        sql.replace(0, 12, "create table if not exists");
+        creator.exec(sql);
+        if (!creator.lastError().isValid() && columns().count()>0 && columns().first().name()=="year")
+            creator.exec(QString("delete from %1 where year>%2").arg(tableName()).arg(mResumeYear));
+    } else {
+        QString drop=QString("drop table if exists %1").arg(tableName());
+        creator.exec(drop); // drop table (if exists)
+        creator.exec(sql); // (re-)create table
+    }
     //creator.exec("delete from " + tableName()); // clear table??? necessary?
 
     if (creator.lastError().isValid()){
@@ -154,6 +170,29 @@ void Output::openDatabase()
     for (int i=0;i<columns().count();i++)
         mInserter->bindValue(i,mRow[i]);
 
+    // rows are inserted in blocks with a single multi-row "insert" statement (the number of
+    // bound values per statement is limited to 999, the default limit of older SQLite versions)
+    const int max_variables = 999;
+    const int max_rows = 100;
+    mBulkRows = columns().count()>0 ? qBound(1, max_variables / columns().count(), max_rows) : 1;
+    mBufferedRows = 0;
+    if (mBulkRows > 1) {
+        QString row_values = "(" + QString("?,").repeated(columns().count());
+        row_values[row_values.length()-1]=')';
+        QString bulk_insert = insert.left(insert.indexOf(" values (")) + " values " + row_values;
+        for (int i=1;i<mBulkRows;++i)
+            bulk_insert += "," + row_values;
+        mBulkInserter = new QSqlQuery(db);
+        if (!mBulkInserter->prepare(bulk_insert)) {
+            qDebug() << "Output" << name() << ": bulk insert not available:" << mBulkInserter->lastError().text();
+            delete mBulkInserter;
+            mBulkInserter = nullptr;
+            mBulkRows = 1;
+        } else {
+            mBulkBuffer.resize(mBulkRows * columns().count());
+        }
+    }
+
     mOpen = true;
 }
 
@@ -161,11 +200,15 @@ void Output::openFile()
 {
     QString path = GlobalSettings::instance()->path(mTableName + ".csv", "output");
     mOutputFile.setFileName(path);
-    if (!mOutputFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    // when resuming, append to an existing file (note: rows after the checkpoint are not removed from files)
+    bool append = mResumeYear>=0 && mOutputFile.exists();
+    if (!mOutputFile.open((append ? QIODevice::Append : QIODevice::WriteOnly) | QIODevice::Text))
           throw IException(QString("The file '%1' for output '%2' cannot be opened!").arg(path, name()) );
 
-    // create header
     mFileStream.setDevice(&mOutputFile);
+    if (append)
+        return;
+    // create header
     QString line; bool first=true;
     foreach(const OutputColumn &col, columns()) {
         if (first) {
@@ -227,6 +270,7 @@ bool Output::clearColumnsAfter(QString find_name)
 
 void Output::truncateTable()
 {
+    flush();
     QSqlDatabase db = GlobalSettings::instance()->dbout();
     QSqlQuery query(db);
     QString stmt=QString("delete from %1").arg(tableName());
@@ -261,12 +305,18 @@ void Output::close()
     mOpen = false;
     switch (mMode) {
         case OutDatabase:
+            flush();
             // calling finish() ensures, that the query and all locks are freed.
             // having (old) locks on database connections, degrades insert performance.
             if (mInserter->isValid())
                 mInserter->finish();
             delete mInserter;
             mInserter = nullptr;
+            if (mBulkInserter) {
+                mBulkInserter->finish();
+                delete mBulkInserter;
+                mBulkInserter = nullptr;
+            }
          break;
     case OutFile:
         mOutputFile.close();
@@ -278,21 +328,55 @@ void Output::close()
 }
 
 
+static void checkInsertError(const QSqlQuery *query)
+{
+    if (query->lastError().isValid()){
+        throw IException(QString("Error during saving of output tables: '%1'' (native code: '%2', driver: '%3')")
+                         .arg( query->lastError().text())
+                         .arg(query->lastError().nativeErrorCode())
+                         .arg(query->lastError().driverText()) );
+    }
+}
+
 void Output::saveDatabase()
 {
+    if (mBulkRows > 1) {
+        // collect the row, and insert when a block of rows is complete
+        QVariant *p = mBulkBuffer.data() + mBufferedRows * mCount;
+        for (int i=0;i<mCount;i++)
+            p[i] = mRow[i];
+        if (++mBufferedRows == mBulkRows) {
+            for (int i=0;i<mBulkBuffer.size();++i)
+                mBulkInserter->bindValue(i, mBulkBuffer[i]);
+            mBulkInserter->exec();
+            checkInsertError(mBulkInserter);
+            mBufferedRows = 0;
+        }
+        newRow();
+        return;
+    }
    for (int i=0;i<mCount;i++)
         mInserter->bindValue(i,mRow[i]);
     mInserter->exec();
-    if (mInserter->lastError().isValid()){
-        throw IException(QString("Error during saving of output tables: '%1'' (native code: '%2', driver: '%3')")
-                         .arg( mInserter->lastError().text())
-                         .arg(mInserter->lastError().nativeErrorCode())
-                         .arg(mInserter->lastError().driverText()) );
-    }
+    checkInsertError(mInserter);
 
     newRow();
 }
 
+void Output::flush()
+{
+    if (mBufferedRows == 0 || !mInserter)
+        return;
+    // the remaining rows (less than a full block) are inserted one by one
+    for (int r=0;r<mBufferedRows;++r) {
+        for (int i=0;i<mCount;i++)
+            mInserter->bindValue(i, mBulkBuffer[r * mCount + i]);
+        mInserter->exec();
+        checkInsertError(mInserter);
+    }
+    mBufferedRows = 0;
+}
+
 void Output::saveFile()
 {
     for (int i=0;i<mCount;++i) {
@@ -65,9 +65,14 @@ public:
     bool isEnabled() const { return mEnabled; } ///< returns true if output is enabled, i.e. is "turned on"
     void setEnabled(const bool enabled) { mEnabled=enabled; if(enabled) open(); }
     bool isRowEmpty() const { return mIndex==0; } ///< returns true if the buffer of the current row is empty
+    void flush(); ///< write rows that are buffered for a bulk insert to the database
 
     virtual void exec(); ///< main function that executes the output
 
+    /// resume mode (see Checkpoint): existing tables are kept and rows of years > 'year' removed; -1: off (default)
+    static void setResumeYear(const int year) { mResumeYear = year; }
+    static int resumeYear() { return mResumeYear; }
+
     // properties
     const QList<OutputColumn> getColumns() const { return mColumns; }
 
@@ -107,6 +112,7 @@ protected:
 
 private:
     static const GlobalSettings *gl; ///< pointer to globalsettings object
+    static int mResumeYear; ///< year of the checkpoint when resuming a simulation (-1: no resume)
     void newRow(); ///< starts a new row (resets the internal counter)
     void openDatabase(); ///< database open, create output table and prepare insert statement
     void openFile(); ///< open output file
@@ -121,6 +127,10 @@ private:
     QList<OutputColumn> mColumns; ///< list of columns of output
     QVector<QVariant> mRow; ///< current row
     QSqlQuery *mInserter;
+    QSqlQuery *mBulkInserter; ///< insert statement for 'mBulkRows' rows at once
+    int mBulkRows; ///< number of rows per bulk insert (1: no bulk inserts)
+    QVector<QVariant> mBulkBuffer; ///< values of the rows for the next bulk insert
+    int mBufferedRows; ///< number of rows in mBulkBuffer
     QFile mOutputFile;
     QTextStream mFileStream; ///< for file based output
     int mCount;
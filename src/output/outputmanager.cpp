@@ -135,6 +135,8 @@ Output *OutputManager::find(const QString& tableName)
 
 void OutputManager::save()
 {
+    foreach(Output *p, mOutputs)
+        p->flush();
     endTransaction();
 }
 
@@ -185,6 +187,7 @@ bool OutputManager::execute(const QString& tableName)
 
         startTransaction(); // just assure a transaction is open.... nothing happens if already inside a transaction
         p->exec();
+        p->flush(); // all rows of the output are in the database after execute()
 
         return true;
     }
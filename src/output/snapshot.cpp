@@ -483,6 +483,7 @@ bool Snapshot::loadStandSnapshot(const int stand_id, const MapGrid *stand_grid,
     q.exec(QString("select trees "
                    "from trees_stand where standID=%1").arg(stand_id));
     QRectF extent = GlobalSettings::instance()->model()->extent();
+    QSet<ResourceUnit*> loaded_rus; // resource units with loaded trees
     int n=0, sap_n=0, n_sap_removed=0;
     if (q.next()) {
         QByteArray data = q.value(0).toByteArray();
@@ -504,6 +505,7 @@ bool Snapshot::loadStandSnapshot(const int stand_id, const MapGrid *stand_grid,
                continue;
            Tree &t = ru->newTree();
            t.setRU(ru);
+           loaded_rus.insert(ru);
            t.mId = item.id;
            t.setPosition(coord);
            Species *s = GlobalSettings::instance()->model()->speciesSet()->species(item.species);
@@ -622,6 +624,9 @@ bool Snapshot::loadStandSnapshot(const int stand_id, const MapGrid *stand_grid,
 
     // clean up
     GlobalSettings::instance()->model()->cleanTreeLists(true);
+    // removed trees are already subtracted from the statistics, but loaded trees need to be added
+    foreach(ResourceUnit *ru, loaded_rus)
+        ru->recreateStandStatistics(true);
 
     qDebug() << "load stand snapshot for stand "<< stand_id << ": trees (removed/loaded): " <<n_removed<<"/" << n
              << ", saplings (removed/loaded):" << n_sap_removed << "/" << sap_n
@@ -664,6 +669,194 @@ bool Snapshot::loadStandCarbon()
 
 }
 
+int Snapshot::nextTreeId()
+{
+    return Tree::m_nextId;
+}
+
+void Snapshot::setNextTreeId(const int next_id)
+{
+    Tree::m_nextId = next_id;
+}
+
+/// version of the binary format of saveResourceUnit()
+static const qint32 cRUStateVersion = 1;
+
+QByteArray Snapshot::saveResourceUnit(const ResourceUnit *ru)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << cRUStateVersion << ru->index();
+    // trees: all state variables (light related variables are re-calculated after loading)
+    out << static_cast<qint32>(ru->constTrees().size());
+    for (const Tree &t : ru->constTrees()) {
+        out << t.mId << t.mAge << t.mDbh << t.mHeight << t.mPositionIndex << t.species()->index();
+        out << t.mLeafArea << t.mOpacity << t.mFoliageMass << t.mStemMass << t.mBranchMass << t.mFineRootMass << t.mCoarseRootMass;
+        out << t.mNPPReserve << t.mLRI << t.mLightResponse << t.mDbhDelta << t.mStressIndex << t.mFlags;
+    }
+    // saplings (all cells of the resource unit)
+    SaplingCell *sc = ru->saplingCellArray();
+    out << (sc != nullptr);
+    if (sc) {
+        for (int i=0;i<cPxPerHectare;++i, ++sc) {
+            out << static_cast<qint8>(sc->state);
+            for (int j=0;j<NSAPCELLS;++j) {
+                const SaplingTree &st = sc->saplings[j];
+                out << st.age << st.species_index << st.stress_years << st.flags << st.height;
+            }
+        }
+    }
+    // soil and water
+    const Soil *s = ru->soil();
+    out << (s != nullptr);
+    if (s) {
+        out << s->mKyl << s->mKyr;
+        out << s->mInputLab.C << s->mInputLab.N << s->mInputLab.parameter();
+        out << s->mInputRef.C << s->mInputRef.N << s->mInputRef.parameter();
+        out << s->mYL.C << s->mYL.N << s->mYL.parameter() << s->mYLaboveground_frac;
+        out << s->mYR.C << s->mYR.N << s->mYR.parameter() << s->mYRaboveground_frac;
+        out << s->mSOM.C << s->mSOM.N;
+    }
+    out << ru->waterCycle()->currentContent() << ru->waterCycle()->currentSnowPack();
+    const Water::Permafrost *pf = ru->waterCycle()->permafrost();
+    out << (pf != nullptr);
+    if (pf)
+        out << pf->mossBiomass() << pf->groundBaseTemperature() << pf->depthFrozen() << pf->waterFrozen();
+    // snags and dead trees
+    Snag *sn = const_cast<ResourceUnit*>(ru)->snag();
+    out << (sn != nullptr);
+    if (sn) {
+        out << sn->mClimateFactor;
+        for (int i=0;i<3;++i) {
+            out << sn->mSWD[i].C << sn->mSWD[i].N << sn->mSWD[i].parameter();
+            out << sn->mNumberOfSnags[i] << sn->mAvgDbh[i] << sn->mAvgHeight[i] << sn->mAvgVolume[i];
+            out << sn->mTimeSinceDeath[i] << sn->mKSW[i] << sn->mHalfLife[i];
+        }
+        out << sn->mTotalSWD.C << sn->mTotalSWD.N;
+        for (int i=0;i<5;++i)
+            out << sn->mOtherWood[i].C << sn->mOtherWood[i].N << sn->mOtherWood[i].parameter();
+        out << sn->mBranchCounter << sn->mOtherWoodAbovegroundFrac;
+        out << static_cast<qint32>(sn->deadTrees().size());
+        for (const DeadTree &dt : sn->deadTrees()) {
+            out << dt.mX << dt.mY << dt.mSpecies->index() << dt.mIsStanding << dt.mDeathReason;
+            out << dt.mYearsStandingDead << dt.mYearsDowned << dt.mVolume << dt.mInititalBiomass << dt.mBiomass << dt.mCrownRadius;
+        }
+    }
+    return data;
+}
+
+void Snapshot::loadResourceUnit(ResourceUnit *ru, const QByteArray &data)
+{
+    QDataStream in(data);
+    qint32 version, n;
+    int ru_index;
+    bool has_item;
+    in >> version >> ru_index;
+    if (version != cRUStateVersion || ru_index != ru->index())
+        throw IException(QString("Snapshot::loadResourceUnit: invalid data for resource unit %1 (version %2, index %3).").arg(ru->index()).arg(version).arg(ru_index));
+
+    QHash<int, Species*> species;
+    for (Species *sp : ru->speciesSet()->activeSpecies())
+        species[sp->index()] = sp;
+
+    // trees
+    in >> n;
+    ru->trees().clear();
+    ru->trees().reserve(n);
+    for (int i=0;i<n;++i) {
+        Tree &t = ru->newTree();
+        int species_index;
+        t.setRU(ru);
+        in >> t.mId >> t.mAge >> t.mDbh >> t.mHeight >> t.mPositionIndex >> species_index;
+        in >> t.mLeafArea >> t.mOpacity >> t.mFoliageMass >> t.mStemMass >> t.mBranchMass >> t.mFineRootMass >> t.mCoarseRootMass;
+        in >> t.mNPPReserve >> t.mLRI >> t.mLightResponse >> t.mDbhDelta >> t.mStressIndex >> t.mFlags;
+        Species *s = species.value(species_index, nullptr);
+        if (!s)
+            throw IException(QString("Snapshot::loadResourceUnit: invalid species index %1").arg(species_index));
+        t.setSpecies(s);
+        t.mStamp = s->stamp(t.mDbh, t.mHeight);
+    }
+    // saplings
+    in >> has_item;
+    if (has_item) {
+        SaplingCell *sc = ru->saplingCellArray();
+        for (int i=0;i<cPxPerHectare;++i) {
+            qint8 state;
+            SaplingCell dummy;
+            SaplingCell &cell = sc ? sc[i] : dummy;
+            in >> state;
+            cell.state = static_cast<SaplingCell::ECellState>(state);
+            for (int j=0;j<NSAPCELLS;++j) {
+                SaplingTree &st = cell.saplings[j];
+                in >> st.age >> st.species_index >> st.stress_years >> st.flags >> st.height;
+            }
+        }
+    }
+    // soil and water
+    in >> has_item;
+    if (has_item) {
+        Soil *s = ru->soil();
+        if (!s)
+            throw IException("Snapshot::loadResourceUnit: soil data available, but the carbon cycle is disabled.");
+        double param;
+        in >> s->mKyl >> s->mKyr;
+        in >> s->mInputLab.C >> s->mInputLab.N >> param; s->mInputLab.setParameter(param);
+        in >> s->mInputRef.C >> s->mInputRef.N >> param; s->mInputRef.setParameter(param);
+        in >> s->mYL.C >> s->mYL.N >> param >> s->mYLaboveground_frac; s->mYL.setParameter(param);
+        in >> s->mYR.C >> s->mYR.N >> param >> s->mYRaboveground_frac; s->mYR.setParameter(param);
+        in >> s->mSOM.C >> s->mSOM.N;
+    }
+    double content, snow;
+    in >> content >> snow;
+    const_cast<WaterCycle*>(ru->waterCycle())->setContent(content, snow);
+    in >> has_item;
+    if (has_item) {
+        double moss, temp, depth, water;
+        in >> moss >> temp >> depth >> water;
+        if (ru->waterCycle()->permafrost())
+            const_cast<Water::Permafrost*>(ru->waterCycle()->permafrost())->setFromSnapshot(moss, temp, depth, water);
+    }
+    // snags and dead trees
+    in >> has_item;
+    if (has_item) {
+        Snag *sn = ru->snag();
+        if (!sn)
+            throw IException("Snapshot::loadResourceUnit: snag data available, but the carbon cycle is disabled.");
+        double param;
+        in >> sn->mClimateFactor;
+        for (int i=0;i<3;++i) {
+            in >> sn->mSWD[i].C >> sn->mSWD[i].N >> param; sn->mSWD[i].setParameter(param);
+            in >> sn->mNumberOfSnags[i] >> sn->mAvgDbh[i] >> sn->mAvgHeight[i] >> sn->mAvgVolume[i];
+            in >> sn->mTimeSinceDeath[i] >> sn->mKSW[i] >> sn->mHalfLife[i];
+        }
+        in >> sn->mTotalSWD.C >> sn->mTotalSWD.N;
+        for (int i=0;i<5;++i) {
+            in >> sn->mOtherWood[i].C >> sn->mOtherWood[i].N >> param;
+            sn->mOtherWood[i].setParameter(param);
+        }
+        in >> sn->mBranchCounter >> sn->mOtherWoodAbovegroundFrac;
+        // these values are not stored but derived
+        sn->mTotalOther = sn->mOtherWood[0] + sn->mOtherWood[1] + sn->mOtherWood[2] + sn->mOtherWood[3] + sn->mOtherWood[4];
+        sn->mTotalSnagCarbon = sn->mSWD[0].C + sn->mSWD[1].C + sn->mSWD[2].C + sn->mTotalOther.C;
+
+        in >> n;
+        auto &dt_list = sn->deadTrees();
+        dt_list.clear();
+        for (int i=0;i<n;++i) {
+            DeadTree &dt = dt_list.emplace_back();
+            int species_index;
+            in >> dt.mX >> dt.mY >> species_index >> dt.mIsStanding >> dt.mDeathReason;
+            in >> dt.mYearsStandingDead >> dt.mYearsDowned >> dt.mVolume >> dt.mInititalBiomass >> dt.mBiomass >> dt.mCrownRadius;
+            dt.mSpecies = species.value(species_index, nullptr);
+            if (!dt.mSpecies)
+                throw IException(QString("Snapshot::loadResourceUnit: invalid species index %1 (dead trees)").arg(species_index));
+            dt.updateDecayClass();
+        }
+    }
+    if (in.status() != QDataStream::Ok)
+        throw IException(QString("Snapshot::loadResourceUnit: corrupt data for resource unit %1.").arg(ru->index()));
+}
+
 void Snapshot::saveTrees()
 {
     QSqlDatabase db=QSqlDatabase::database("snapshot");
@@ -21,6 +21,7 @@
 
 #include <QString>
 #include <QHash>
+#include <QByteArray>
 #include <QSqlQuery>
 /** @class Snapshot provides a way to save/load the current state of the model to a database.
  *  A snapshot contains trees, saplings, snags and soil (carbon/nitrogen pools), i.e. a
@@ -46,6 +47,13 @@ public:
     bool saveStandCarbon(const int stand_id, QList<int> ru_ids, bool rid_mode);
     /// load the carbon/snags pools from the current (stand) snapshot
     bool loadStandCarbon();
+    // binary state of single resource units (used by checkpoints)
+    /// serialize the full state (trees, saplings, soil, snags, dead trees) of the resource unit 'ru'
+    static QByteArray saveResourceUnit(const ResourceUnit *ru);
+    /// replace the state of 'ru' with the state stored by saveResourceUnit()
+    static void loadResourceUnit(ResourceUnit *ru, const QByteArray &data);
+    static int nextTreeId(); ///< the Id that is assigned to the next newly created tree
+    static void setNextTreeId(const int next_id);
 private:
     bool openDatabase(const QString &file_name, const bool read);
     // analyze which columns are in the snapshot db
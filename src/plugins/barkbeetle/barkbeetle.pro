@@ -2,6 +2,7 @@
 QT += xml
 QT += qml
 QT += sql
+QT += concurrent
 
 
 TEMPLATE      = lib
@@ -610,20 +610,118 @@ void BarkBeetleModule::prepareInteractions(bool update_interaction)
 }
 
 
+/// Random numbers for the spread of beetle packages from a single source cell. The generator (splitmix64)
+/// is seeded per source cell, i.e. the results do not depend on the order in which (or thread by which) cells are processed.
+class BBRandomStream
+{
+public:
+    BBRandomStream(const quint64 seed): mState(seed) {}
+    /// random number in [0,1)
+    double rand() { return (next() >> 11) * (1.0/9007199254740992.0); }
+    /// random integer in [0, max_value)
+    int randInt(const int max_value) { return int(rand() * max_value); }
+private:
+    quint64 next() {
+        quint64 z = (mState += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    quint64 mState;
+};
+
+/// spread the packages of a single source cell. The function only reads the state of the grid (the
+/// landing sites are stored in 'source.targets'), and can be run in parallel for all sources.
+void BarkBeetleModule::nc_spreadPackets(SBBSource &source)
+{
+    BarkBeetleModule *bb = source.module;
+    source.targets.clear();
+    BBRandomStream rnd(source.seed);
+    GridRunner<BarkBeetleCell> targeter(bb->mGrid, bb->mGrid.rectangle());
+    const QPoint start_index = bb->mGrid.indexOf(source.index);
+    BarkBeetleCell *nb8[8];
+    try {
+        for (int i=0;i<source.n_packets;++i) {
+            // estimate distance and direction of spread
+            double u_slot = rnd.rand(), u_value = rnd.rand();
+            double rho = bb->mKernelPDF.get(u_slot, u_value); // distance (m)
+            double phi = rnd.rand() * 2*M_PI; // direction (degree)
+            // calculate the pixel
+
+            QPoint pos = start_index + QPoint(qRound( rho * sin(phi) / cHeightSize ),  qRound( rho * cos(phi) / cHeightSize ) );
+            // don't spread to the initial start pixel
+            if (start_index == pos)
+                continue;
+            targeter.setPosition(pos);
+            if (!targeter.isValid())
+                continue;
+
+
+            // effect of windthrown trees or "fangbaume"
+            if (targeter.current()->isNeutralized())
+                if (rnd.rand() < bb->params.deadTreeSelectivity)
+                    continue;
+
+            BarkBeetleCell *target=nullptr;
+            if (targeter.current()->isPotentialHost()) {
+                // found a potential host at the immediate target pixel
+                target = targeter.current();
+            } else {
+                // get elements of the moore-neighborhood
+                // and look for a potential host
+                targeter.neighbors8(nb8);
+                int idx = rnd.randInt(8);
+                for (int j=0;j<8;j++) {
+                    BarkBeetleCell *nb = nb8[ (idx+j) % 8 ];
+                    if (nb && nb->isPotentialHost()) {
+                        target = nb;
+                        break;
+                    }
+                }
+            }
+
+            // attack the target pixel if a target could be identified
+            if (target)
+                source.targets.push_back(int(target - bb->mGrid.begin()));
+        }
+    } catch (const IException &e) {
+        GlobalSettings::instance()->model()->threadExec().throwError(e.message());
+    }
+}
+
+/** The spread is calculated for the list of infested cells (sources) only: the first generation starts with all currently
+  infested cells, and cells that are infested during a generation are the sources of the next generation.
+  The spread of packages from the source cells runs in parallel (see nc_spreadPackets()); the landing
+  packages are added to the target cells afterwards (in the order of the sources), i.e. results are deterministic.
+  */
 void BarkBeetleModule::barkbeetleSpread()
 {
     DebugTimer t("BBSpread");
 
     double ant_years = qMax(nrandom(params.outbreakDurationMin, params.outbreakDurationMax), 1.);
+
+    // the source cells of the first generation
+    QVector<int> source_cells;
+    for (BarkBeetleCell *b=mGrid.begin(); b!=mGrid.end(); ++b)
+        if (b->infested)
+            source_cells.push_back(int(b - mGrid.begin()));
+
+    QVector<SBBSource> sources;
+    QVector<int> landed_cells;
     for (int generation=1;generation<=stats.maxGenerations;++generation) {
+        if (source_cells.isEmpty())
+            break;
 
-        GridRunner<BarkBeetleCell> runner(mGrid, mGrid.rectangle());
-        GridRunner<BarkBeetleCell> targeter(mGrid, mGrid.rectangle());
-        while (BarkBeetleCell *b=runner.next()) {
+        // seed for the random streams of this generation
+        const quint64 generation_seed = (quint64(RandomGenerator::randInt()) << 32) | quint64(RandomGenerator::randInt());
+
+        sources.clear();
+        foreach(int index, source_cells) {
+            BarkBeetleCell *b = &mGrid[index];
             if (!b->infested)
                 continue;
-            QPoint start_index = runner.currentIndex();
-            BarkBeetleRUCell &bbru=mRUGrid.valueAt(runner.currentCoord());
+            QPointF coord = mGrid.cellCenterPoint(mGrid.indexOf(index));
+            BarkBeetleRUCell &bbru=mRUGrid.valueAt(coord);
             if (generation>bbru.generations)
                 continue;
 
@@ -650,81 +748,60 @@ void BarkBeetleModule::barkbeetleSpread()
             bbru.host_pixels--;
 
             // check for sanitation treatment
-            if (sanitationTreatment(runner.currentCoord())) {
+            if (sanitationTreatment(coord)) {
                 // no beetles should spread from this cell
                 continue;
             }
 
-            BarkBeetleCell *nb8[8];
-            for (int i=0;i<n_packets;++i) {
-                // estimate distance and direction of spread
-                double rho = mKernelPDF.get(); // distance (m)
-                double phi = nrandom(0, 2*M_PI); // direction (degree)
-                // calculate the pixel
-
-                QPoint pos = start_index + QPoint(qRound( rho * sin(phi) / cHeightSize ),  qRound( rho * cos(phi) / cHeightSize ) );
-                // don't spread to the initial start pixel
-                if (start_index == pos)
-                    continue;
-                targeter.setPosition(pos);
-                if (!targeter.isValid())
-                    continue;
-
-
-                // effect of windthrown trees or "fangbaume"
-                if (targeter.current()->isNeutralized())
-                    if (drandom() < params.deadTreeSelectivity)
-                        continue;
-
-                BarkBeetleCell *target=nullptr;
-                if (targeter.current()->isPotentialHost()) {
-                    // found a potential host at the immediate target pixel
-                    target = targeter.current();
-                } else {
-                    // get elements of the moore-neighborhood
-                    // and look for a potential host
-                    targeter.neighbors8(nb8);
-                    int idx = irandom(0,8);
-                    for (int j=0;j<8;j++) {
-                        BarkBeetleCell *nb = nb8[ (idx+j) % 8 ];
-                        if (nb && nb->isPotentialHost()) {
-                            target = nb;
-                            break;
-                        }
-                    }
-                }
+            SBBSource src;
+            src.index = index;
+            src.n_packets = n_packets;
+            src.outbreakYear = b->outbreakYear;
+            src.seed = generation_seed ^ (quint64(index) * 0xD1B54A32D192ED03ULL);
+            src.module = this;
+            sources.push_back(src);
+        }
 
-                // attack the target pixel if a target could be identified
-                if (target) {
-                    target->n++;
-                    target->n_total++;
-                    target->packageOutbreakYear += b->outbreakYear;
-                }
+        // spread of the beetle packages (in parallel)
+        GlobalSettings::instance()->model()->threadExec().run(nc_spreadPackets, sources);
+        const_cast<ThreadRunner&>(GlobalSettings::instance()->model()->threadExec()).checkErrors();
+
+        // the packages land on the target cells
+        landed_cells.clear();
+        foreach(const SBBSource &src, sources) {
+            foreach(int index, src.targets) {
+                BarkBeetleCell &target = mGrid[index];
+                if (target.n == 0)
+                    landed_cells.push_back(index);
+                target.n++;
+                target.n_total++;
+                target.packageOutbreakYear += src.outbreakYear;
             }
-        }  // while
+        }
+        // process cells in the order of the grid
+        std::sort(landed_cells.begin(), landed_cells.end());
 
         // now evaluate whether the landed beetles are able to infest the target trees
-        runner.reset();
-        while (BarkBeetleCell *b=runner.next()) {
-            if (b->n > 0) {
-                stats.NCohortsLanded+=b->n;
-                stats.NPixelsLanded++;
-                // the cell is attacked by n packages. Calculate the probability that the beetles win.
-                // the probability is derived from an expression with the parameter "tree_stress"
-                double p_col = limit(mColonizeProbability.calculate(b->tree_stress), 0., 1.);
-                // the attack happens 'n' times, therefore the probability is higher
-                double p_ncol = 1. - pow(1.-p_col, b->n);
-                b->p_colonize = std::max(b->p_colonize, float(p_ncol));
-                if (drandom() < p_ncol) {
-                    // attack successful - the pixel gets infested
-                    b->outbreakYear = b->n>0 ? b->packageOutbreakYear / float(b->n) : mYear; // b->n always >0, but just to silence compiler warning ;)
-                    b->setInfested(true);
-                    stats.NInfested++;
-                } else {
-                    b->n = 0; // reset the counter
-                    b->packageOutbreakYear = 0.f;
-                }
-
+        source_cells.clear();
+        foreach(int index, landed_cells) {
+            BarkBeetleCell *b = &mGrid[index];
+            stats.NCohortsLanded+=b->n;
+            stats.NPixelsLanded++;
+            // the cell is attacked by n packages. Calculate the probability that the beetles win.
+            // the probability is derived from an expression with the parameter "tree_stress"
+            double p_col = limit(mColonizeProbability.calculate(b->tree_stress), 0., 1.);
+            // the attack happens 'n' times, therefore the probability is higher
+            double p_ncol = 1. - pow(1.-p_col, b->n);
+            b->p_colonize = std::max(b->p_colonize, float(p_ncol));
+            if (drandom() < p_ncol) {
+                // attack successful - the pixel gets infested
+                b->outbreakYear = b->n>0 ? b->packageOutbreakYear / float(b->n) : mYear; // b->n always >0, but just to silence compiler warning ;)
+                b->setInfested(true);
+                stats.NInfested++;
+                source_cells.push_back(index); // the cell is a source in the next generation
+            } else {
+                b->n = 0; // reset the counter
+                b->packageOutbreakYear = 0.f;
             }
         }
 
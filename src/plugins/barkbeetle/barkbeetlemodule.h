@@ -172,6 +172,16 @@ private:
     void barkbeetleKill(); ///< kill the trees on pixels marked as killed
     void scanResourceUnitTrees(const QPointF &position); ///< load tree data of the resource unit 'position' (metric) lies inside
     bool sanitationTreatment(QPointF coord) const; ///< returns true if no beetles should spread from a cell due to sanitation treatments
+    /// a cell from which beetles spread in the current generation (see barkbeetleSpread())
+    struct SBBSource {
+        int index; ///< index of the cell on mGrid
+        int n_packets; ///< number of beetle packages that leave the cell
+        float outbreakYear; ///< outbreak year of the source cell (passed on to the target cells)
+        quint64 seed; ///< seed for the random numbers of the cell
+        QVector<int> targets; ///< indices (mGrid) of the cells on which the packages landed
+        BarkBeetleModule *module;
+    };
+    static void nc_spreadPackets(SBBSource &source); ///< spread the packages of a single source cell (thread safe)
     //void calculateMeanDamage(); ///< calculate the mean damage percentage (fraction of killed pixels to host pixels)
     int mIteration;
     QString mAfterExecEvent;
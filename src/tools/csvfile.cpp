@@ -176,6 +176,48 @@ QVariantList CSVFile::values(const int row) const
     return list;
 }
 
+QStringList CSVFile::rowValues(const int row) const
+{
+    QStringList result;
+    if (mStreamingMode || row<0 || row>=mRowCount)
+        return result;
+    if (mFixedWidth || mSeparator.length()!=1) {
+        for (int col=0;col<mColCount;++col)
+            result.push_back(value(row, col).toString());
+        return result;
+    }
+    // one character separators: find all separators, and extract the columns with the same rules as value()
+    const QString &s = mRows[row];
+    const QChar sep = mSeparator.at(0);
+    QVarLengthArray<int, 64> seps;
+    for (int i=0;i<s.size();++i)
+        if (s.at(i) == sep)
+            seps.append(i);
+    int n_sep = seps.size();
+    for (int col=0;col<mColCount;++col) {
+        QString item;
+        if (col==mColCount-1) {
+            // last element: only if all separators are present
+            if (n_sep==mColCount-1) {
+                item = s.mid(n_sep>0 ? seps[n_sep-1]+1 : 0);
+                if (item.startsWith('\"') && item.endsWith('\"'))
+                    item = item.mid(1, item.length()-2);
+            }
+        } else if (col < n_sep) {
+            int lastsep = col>0 ? seps[col-1]+1 : 0;
+            int i = seps[col];
+            if (s.at(lastsep)=='\"' && s.at(i-1)=='\"')
+                item = s.mid(lastsep+1,i-lastsep-2); // ignore "
+            else
+                item = s.mid(lastsep,i-lastsep).trimmed(); // remove whitespace
+        } else if (col == n_sep) {
+            item = s.mid(n_sep>0 ? seps[n_sep-1]+1 : 0);
+        }
+        result.push_back(item);
+    }
+    return result;
+}
+
 QVariant CSVFile::value(const int row, const int col) const
 {
     if (mStreamingMode)
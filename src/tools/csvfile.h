@@ -47,6 +47,7 @@ public:
     QStringList captions() const { return mCaptions; } ///< retrieve (a copy) of column headers
     QStringList column(const int col) const; ///< retrieve a string list of a given column
     QVariantList values(const int row) const; ///< get a list of the values in row "row"
+    QStringList rowValues(const int row) const; ///< all values of row "row" (same as value() for each column, but scans the row only once)
     // setters
     void setHasCaptions(const bool hasCaps) { mHasCaptions = hasCaps; }
     void setFixedWidth(const bool hasFixedWidth) { mFixedWidth = hasFixedWidth; }
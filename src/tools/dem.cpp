@@ -25,6 +25,18 @@
 
 #include "gisgrid.h"
 
+#include <QtConcurrent/QtConcurrent>
+
+// run 'func(row)' for all rows (0..n-1) in parallel
+template<typename F>
+static void forAllRows(const int n, F func)
+{
+    QVector<int> rows(n);
+    for (int i=0;i<n;++i)
+        rows[i]=i;
+    QtConcurrent::blockingMap(rows, func);
+}
+
 // from here: http://www.scratchapixel.com/lessons/3d-advanced-lessons/interpolation/bilinear-interpolation/
 template<typename T>
 T bilinear(
@@ -47,6 +59,11 @@ T bilinear(
 #endif
 }
 
+DEM::~DEM()
+{
+    qDeleteAll(mTPIGrids);
+}
+
 /// loads a DEM from a ESRI style text file.
 /// internally, the DEM has always a resolution of 10m
 bool DEM::loadFromFile(const QString &fileName)
@@ -58,17 +75,26 @@ bool DEM::loadFromFile(const QString &fileName)
     if (!h_grid || h_grid->isEmpty())
         throw IException("GisGrid::create10mGrid: no valid height grid to copy grid size.");
 
-    GisGrid gis_grid;
-    if (!gis_grid.loadFromFile(fileName))
-        throw IException(QString("Unable to load DEM file %1").arg(fileName));
     // create a grid with the same size as the height grid
     // (height-grid: 10m size, covering the full extent)
     clear();
     aspect_grid.clear();
     slope_grid.clear();
     view_grid.clear();
+    qDeleteAll(mTPIGrids);
+    mTPIGrids.clear();
+    mFileName = fileName;
 
     setup(h_grid->metricRect(),h_grid->cellsize());
+    if (loadCache("dem", *this)) {
+        qDebug() << "Loaded DEM from cache for" << fileName;
+        createSlopeGrid();
+        return true;
+    }
+
+    GisGrid gis_grid;
+    if (!gis_grid.loadFromFile(fileName))
+        throw IException(QString("Unable to load DEM file %1").arg(fileName));
 
     //const QRectF &world = GlobalSettings::instance()->model()->extent(); // without buffer
     const QRectF &world = h_grid->metricRect(); // including buffer
@@ -114,9 +140,46 @@ bool DEM::loadFromFile(const QString &fileName)
             }
     }
     qDebug() << "Loaded DEM from " << fileName;
+    saveCache("dem", *this);
+    // terrain derivatives
+    createSlopeGrid();
     return true;
 }
 
+/// the DEM is resampled from world coordinates: the cached grids are valid only for the same transformation (model.world.location)
+static QByteArray transformationKey()
+{
+    const SCoordTrans &t = GISTransformation();
+    return QByteArray::number(t.offsetX, 'g', 17) + ";" + QByteArray::number(t.offsetY, 'g', 17) + ";" + QByteArray::number(t.RotationAngle, 'g', 17);
+}
+
+bool DEM::loadCache(const QString &type, FloatGrid &grid) const
+{
+    if (!GridFile::cacheEnabled() || mFileName.isEmpty())
+        return false;
+    QFile file;
+    QRectF rect;
+    double cell_size;
+    int size_x, size_y;
+    const QByteArray cell_type = type.toLatin1();
+    if (!GridFile::openCache(mFileName, cell_type.constData(), rect, cell_size, size_x, size_y, file, transformationKey()))
+        return false;
+    // the DEM (and the derived grids) depend also on the extent of the landscape
+    if (rect != metricRect() || cell_size != cellsize() || size_x != sizeX() || size_y != sizeY())
+        return false;
+    const qint64 bytes = qint64(grid.count()) * qint64(sizeof(float));
+    return file.read(reinterpret_cast<char*>(grid.begin()), bytes) == bytes;
+}
+
+void DEM::saveCache(const QString &type, const FloatGrid &grid) const
+{
+    if (!GridFile::cacheEnabled() || mFileName.isEmpty())
+        return;
+    const QByteArray cell_type = type.toLatin1();
+    GridFile::saveCache(mFileName, cell_type.constData(), metricRect(), cellsize(), sizeX(), sizeY(),
+                        reinterpret_cast<const char*>(grid.begin()), qint64(grid.count()) * qint64(sizeof(float)), transformationKey());
+}
+
 /// calculate slope and aspect at a given point.
 /// results are params per reference.
 /// returns the height at point (x/y)
@@ -160,24 +223,67 @@ float DEM::orientation(const QPointF &point, float &rslope_angle, float &rslope_
     }
 }
 
-float DEM::topographicPositionIndex(const QPointF &point, float radius) const
+const FloatGrid *DEM::tpiGrid(const float radius) const
 {
-    int rpix = radius / cHeightSize;
-    QPoint o = indexAt(point);
-    double point_elevation = (*this)(o.x(), o.y());
-    int n = 0;
-    double avg_elevation=0.;
-    for (int iy = std::max(0, o.y() - rpix); iy < std::min(sizeY(), o.y() + rpix); ++iy)
-        for (int ix = std::max(0, o.x() - rpix); ix < std::min(sizeX(), o.x() + rpix); ++ix) {
-            int dist = (ix - o.x())*(ix - o.x()) + (iy - o.y())*(iy - o.y());
-            if (dist <= rpix*rpix) {
-                avg_elevation += (*this)(ix, iy);
-                ++n;
+    const int rpix = static_cast<int>(radius / cHeightSize);
+    QMutexLocker lock(&mTPILock);
+    if (mTPIGrids.contains(rpix))
+        return mTPIGrids[rpix];
+
+    FloatGrid *tpi = new FloatGrid();
+    tpi->setup(*this);
+    const QString type = QString("dem-tpi%1").arg(rpix);
+    if (!loadCache(type, *tpi)) {
+        calculateTPI(rpix, *tpi);
+        saveCache(type, *tpi);
+    }
+    mTPIGrids[rpix] = tpi;
+    return tpi;
+}
+
+/// The TPI is the difference between the elevation of a cell and the mean elevation of the cells within
+/// a circle with radius 'rpix' (in pixels). The circle is processed row by row: for each row of the window,
+/// the sum of elevations is derived from the prefix sums of the row (i.e. a row-wise summed area table), which
+/// reduces the costs per cell from O(rpix^2) to O(rpix).
+void DEM::calculateTPI(const int rpix, FloatGrid &tpi) const
+{
+    const int nx = sizeX();
+    const int ny = sizeY();
+    // prefix sums per row: row_sum[y*(nx+1) + x] = sum of the cells (0..x-1, y)
+    QVector<double> row_sum((nx+1) * ny);
+    forAllRows(ny, [&](const int y) {
+        double *s = row_sum.data() + y*(nx+1);
+        s[0] = 0.;
+        for (int x=0;x<nx;++x)
+            s[x+1] = s[x] + constValueAtIndex(x, y);
+    });
+    // half width of the circle for each row of the window (dy=-rpix..rpix-1): cells with dx*dx+dy*dy <= rpix*rpix
+    QVector<int> half_width(2*rpix);
+    for (int dy=-rpix; dy<rpix; ++dy) {
+        int w = 0;
+        while ((w+1)*(w+1) + dy*dy <= rpix*rpix)
+            ++w;
+        half_width[dy+rpix] = w;
+    }
+
+    // note: the window covers [x-rpix, x+rpix) and [y-rpix, y+rpix)
+    forAllRows(ny, [&](const int y) {
+        for (int x=0;x<nx;++x) {
+            double sum = 0.;
+            int n = 0;
+            for (int iy = std::max(0, y - rpix); iy < std::min(ny, y + rpix); ++iy) {
+                const int w = half_width[iy - y + rpix];
+                const int x0 = std::max(0, x - w);
+                const int x1 = std::min(nx, std::min(x + w + 1, x + rpix));
+                if (x1 <= x0)
+                    continue;
+                const double *s = row_sum.constData() + iy*(nx+1);
+                sum += s[x1] - s[x0];
+                n += x1 - x0;
             }
+            tpi.valueAtIndex(x, y) = n>0 ? static_cast<float>(constValueAtIndex(x, y) - sum / static_cast<double>(n)) : 0.f;
         }
-    if (n>0)
-        return point_elevation - (avg_elevation / static_cast<double>(n));
-    return 0.f;
+    });
 }
 
 void DEM::createSlopeGrid() const
@@ -190,33 +296,40 @@ void DEM::createSlopeGrid() const
     } else {
         return;
     }
-    float *slope = slope_grid.begin();
-    float *view = view_grid.begin();
-    float *aspect = aspect_grid.begin();
+    if (loadCache("dem-slope", slope_grid) && loadCache("dem-aspect", aspect_grid) && loadCache("dem-view", view_grid))
+        return;
 
     // use fixed values for azimuth (315) and angle (45 deg) and calculate
     // norm vectors
-    float sun_x = cos(315. * M_PI/180.) * cos(45.*M_PI/180.);
-    float sun_y = sin(315. * M_PI/180.) * cos(45.*M_PI/180.);
-    float sun_z = sin(45.*M_PI/180.);
-
-    float a_x, a_y, a_z;
-    for (float *p = begin(); p!=end(); ++p, ++slope, ++view, ++aspect) {
-        QPointF pt = cellCenterPoint(indexOf(p));
-        float height = orientation(pt, *slope, *aspect);
-        // calculate the view value:
-        if (height>0) {
-            float h = atan(*slope);
-            a_x = cos(*aspect * M_PI/180.) * cos(h);
-            a_y = sin(*aspect * M_PI/180.) * cos(h);
-            a_z = sin(h);
-
-            // use the scalar product to calculate the angle, and then
-            // transform from [-1,1] to [0,1]
-            *view = (a_x*sun_x + a_y*sun_y + a_z*sun_z + 1.)/2.;
-        } else {
-            *view = 0.;
-        }
-    }
+    const float sun_x = cos(315. * M_PI/180.) * cos(45.*M_PI/180.);
+    const float sun_y = sin(315. * M_PI/180.) * cos(45.*M_PI/180.);
+    const float sun_z = sin(45.*M_PI/180.);
+
+    // the rows are processed in parallel
+    forAllRows(sizeY(), [&](const int y) {
+        float a_x, a_y, a_z;
+        for (int x=0;x<sizeX();++x) {
+            float &slope = slope_grid.valueAtIndex(x, y);
+            float &aspect = aspect_grid.valueAtIndex(x, y);
+            float &view = view_grid.valueAtIndex(x, y);
+            QPointF pt = cellCenterPoint(QPoint(x, y));
+            float height = orientation(pt, slope, aspect);
+            // calculate the view value:
+            if (height>0) {
+                float h = atan(slope);
+                a_x = cos(aspect * M_PI/180.) * cos(h);
+                a_y = sin(aspect * M_PI/180.) * cos(h);
+                a_z = sin(h);
 
+                // use the scalar product to calculate the angle, and then
+                // transform from [-1,1] to [0,1]
+                view = (a_x*sun_x + a_y*sun_y + a_z*sun_z + 1.)/2.;
+            } else {
+                view = 0.;
+            }
+        }
+    });
+    saveCache("dem-slope", slope_grid);
+    saveCache("dem-aspect", aspect_grid);
+    saveCache("dem-view", view_grid);
 }
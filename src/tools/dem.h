@@ -20,6 +20,8 @@
 #ifndef DEM_H
 #define DEM_H
 #include "grid.h"
+#include <QMap>
+#include <QMutex>
 /** DEM is a digital elevation model class.
   @ingroup tools
    It uses a float grid internally.
@@ -34,15 +36,22 @@
 
    Values for height of -1 indicate "out of scope", "invalid" values
 
+   Terrain derivatives (slope, aspect, hillshade ("view") and the topographic position index (TPI) for
+   a given radius) are calculated once for the full grid (in parallel) and stored in grids; if the
+   raster cache is enabled (see GridFile), the derived grids are stored as cache files next to the DEM file.
+
   */
 
 class DEM: public FloatGrid
 {
 public:
     DEM(const QString &fileName) { loadFromFile(fileName); }
+    ~DEM();
     bool loadFromFile(const QString &fileName);
     // create and fill grids for aspect/slope
     void createSlopeGrid() const;
+    /// grid with the topographic position index for 'radius' (m); the grid is created (and cached) with the first call
+    const FloatGrid *tpiGrid(const float radius) const;
     /// grid with aspect, i.e. slope direction in degrees (0: North, 90: east, 180: south, 270: west)
     const FloatGrid *aspectGrid() const { createSlopeGrid(); return &aspect_grid; }
     /// grid with slope, given as slope angle as percentage (i.e: 1:=45 degrees)
@@ -63,13 +72,19 @@ public:
     /// topographic position index
     /// TPI measures the difference between elevation at the central point
     ///  and the average elevation (z) around it within a predetermined radius (radius in m)
-    float topographicPositionIndex(const QPointF &point, float radius) const;
+    float topographicPositionIndex(const QPointF &point, float radius) const { return tpiGrid(radius)->constValueAt(point); }
 
 
 private:
+    void calculateTPI(const int rpix, FloatGrid &tpi) const; ///< calculate the TPI for all cells (radius in pixels)
+    bool loadCache(const QString &type, FloatGrid &grid) const; ///< load a derived grid from the cache
+    void saveCache(const QString &type, const FloatGrid &grid) const; ///< save a derived grid to the cache
+    QString mFileName;
     mutable FloatGrid aspect_grid;
     mutable FloatGrid slope_grid;
     mutable FloatGrid view_grid;
+    mutable QMap<int, FloatGrid*> mTPIGrids; ///< TPI grids (key: radius in pixels)
+    mutable QMutex mTPILock;
 };
 
 #endif // DEM_H
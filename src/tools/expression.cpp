@@ -758,6 +758,16 @@ double Expression::getExternVar(int Index) const
     return m_externVarSpace[Index-1000];
 }
 
+bool Expression::usesIncSum() const
+{
+    if (!m_parsed || !m_execList)
+        return false;
+    for (const ExtExecListItem *exec=m_execList; exec->Type!=etStop; ++exec)
+        if (exec->Type==etFunction && exec->Index==9) // incsum
+            return true;
+    return false;
+}
+
 void Expression::enableIncSum()
 {
     // Funktion "inkrementelle summe" einschalten.
@@ -83,6 +83,9 @@ public:
         void setCatchExceptions(bool docatch=true) { m_catchExceptions = docatch; }
         void   setExternalVarSpace(const QStringList& ExternSpaceNames, double* ExternSpace);
         void enableIncSum();
+        /// returns true if the (parsed) expression uses incsum(), i.e. the result depends on the order of executions
+        /// (such expressions must not be executed in parallel).
+        bool usesIncSum() const;
         // other maintenance
         static void addConstant(const QString const_name, const double const_value);
 private:
@@ -3,6 +3,9 @@
 
 #include "grid.h"
 
+#include <numeric>
+#include <QtConcurrent/QtConcurrent>
+
 #include "../3rdparty/FreeImage/FreeImage.h"
 
 FIBITMAP *GeoTIFF::mProjectionBitmap = nullptr;
@@ -160,6 +163,31 @@ void GeoTIFF::copyToIntGrid(Grid<int> *grid)
 
 }
 
+/// copy the scan lines of the bitmap 'dib' (cell type 'S') to 'grid' (cell type 'D'). The rows are converted
+/// in parallel; source values equal to 'src_null' are set to 'dst_null' (if 'handle_null' is true).
+template <typename S, typename D>
+static void copyScanLines(FIBITMAP *dib, Grid<D> *grid, const bool handle_null, const S src_null, const D dst_null)
+{
+    const int width = static_cast<int>(FreeImage_GetWidth(dib));
+    const int height = static_cast<int>(FreeImage_GetHeight(dib));
+    if (grid->sizeX() != width || grid->sizeY() != height)
+        throw IException(QString("Copy TIF to grid: size mismatch (TIF: %1/%2, grid: %3/%4).").arg(width).arg(height).arg(grid->sizeX()).arg(grid->sizeY()));
+    QVector<int> rows(height);
+    std::iota(rows.begin(), rows.end(), 0);
+    QtConcurrent::blockingMap(rows, [=](const int y) {
+        const S *bits = reinterpret_cast<const S*>(FreeImage_GetScanLine(dib, y));
+        D *target = grid->ptr(0, y);
+        // simple loops (without branches), that can be vectorized by the compiler
+        if (handle_null) {
+            for (int x = 0; x < width; x++)
+                target[x] = bits[x] == src_null ? dst_null : static_cast<D>(bits[x]);
+        } else {
+            for (int x = 0; x < width; x++)
+                target[x] = static_cast<D>(bits[x]);
+        }
+    });
+}
+
 void GeoTIFF::copyToDoubleGrid(Grid<double> *grid)
 {
     if (!dib)
@@ -172,43 +200,18 @@ void GeoTIFF::copyToDoubleGrid(Grid<double> *grid)
         throw IException("Copy TIF to grid: wrong data type, double, float, int16, int32 expected!");
     }
     switch (FreeImage_GetImageType(dib)) {
-    case FIT_DOUBLE: {
-
-        for(uint y = 0; y < FreeImage_GetHeight(dib); y++) {
-            double *bits = (double*)FreeImage_GetScanLine(dib, y);
-            for(uint x = 0; x < FreeImage_GetWidth(dib); x++) {
-                grid->valueAtIndex(x,y) = bits[x] == noDataDouble() ? noDataDouble() : bits[x];
-            }
-        }
+    case FIT_DOUBLE:
+        copyScanLines<double, double>(dib, grid, true, noDataDouble(), noDataDouble());
         return;
-    }
-    case FIT_FLOAT: {
-        for(uint y = 0; y < FreeImage_GetHeight(dib); y++) {
-            float *bits = (float*)FreeImage_GetScanLine(dib, y);
-            for(uint x = 0; x < FreeImage_GetWidth(dib); x++) {
-                grid->valueAtIndex(x,y) = bits[x] == noDataFloat() ? noDataDouble() : bits[x];
-            }
-        }
+    case FIT_FLOAT:
+        copyScanLines<float, double>(dib, grid, true, noDataFloat(), noDataDouble());
         return;
-    }
-    case FIT_INT16:  {
-        for(uint y = 0; y < FreeImage_GetHeight(dib); y++) {
-            short int *bits = (short int *)FreeImage_GetScanLine(dib, y);
-            for(uint x = 0; x < FreeImage_GetWidth(dib); x++) {
-                grid->valueAtIndex(x,y) = bits[x] == noDataShort() ? noDataDouble() : bits[x];
-            }
-        }
+    case FIT_INT16:
+        copyScanLines<short int, double>(dib, grid, true, noDataShort(), noDataDouble());
         return;
-    }
-    case FIT_INT32:  {
-        for(uint y = 0; y < FreeImage_GetHeight(dib); y++) {
-            int *bits = (int *)FreeImage_GetScanLine(dib, y);
-            for(uint x = 0; x < FreeImage_GetWidth(dib); x++) {
-                grid->valueAtIndex(x,y) = bits[x] == noDataInt() ? noDataDouble() : bits[x];
-            }
-        }
+    case FIT_INT32:
+        copyScanLines<int, double>(dib, grid, true, noDataInt(), noDataDouble());
         return;
-    }
 
     default:
         throw IException("Geotiff::copyToDoubleGrid: invalid data type.");
@@ -230,43 +233,18 @@ void GeoTIFF::copyToFloatGrid(Grid<float> *grid)
     }
 
     switch (FreeImage_GetImageType(dib)) {
-    case FIT_DOUBLE: {
-
-        for(uint y = 0; y < FreeImage_GetHeight(dib); y++) {
-            double *bits = (double*)FreeImage_GetScanLine(dib, y);
-            for(uint x = 0; x < FreeImage_GetWidth(dib); x++) {
-                grid->valueAtIndex(x,y) = bits[x];
-            }
-        }
+    case FIT_DOUBLE:
+        copyScanLines<double, float>(dib, grid, false, 0., 0.f);
         return;
-    }
-    case FIT_FLOAT: {
-        for(uint y = 0; y < FreeImage_GetHeight(dib); y++) {
-            float *bits = (float*)FreeImage_GetScanLine(dib, y);
-            for(uint x = 0; x < FreeImage_GetWidth(dib); x++) {
-                grid->valueAtIndex(x,y) = bits[x];
-            }
-        }
+    case FIT_FLOAT:
+        copyScanLines<float, float>(dib, grid, false, 0.f, 0.f);
         return;
-    }
-    case FIT_INT16:  {
-        for(uint y = 0; y < FreeImage_GetHeight(dib); y++) {
-            short int *bits = (short int *)FreeImage_GetScanLine(dib, y);
-            for(uint x = 0; x < FreeImage_GetWidth(dib); x++) {
-                grid->valueAtIndex(x,y) = bits[x];
-            }
-        }
+    case FIT_INT16:
+        copyScanLines<short int, float>(dib, grid, false, 0, 0.f);
         return;
-    }
-    case FIT_INT32:  {
-        for(uint y = 0; y < FreeImage_GetHeight(dib); y++) {
-            int *bits = (int *)FreeImage_GetScanLine(dib, y);
-            for(uint x = 0; x < FreeImage_GetWidth(dib); x++) {
-                grid->valueAtIndex(x,y) = bits[x];
-            }
-        }
+    case FIT_INT32:
+        copyScanLines<int, float>(dib, grid, false, 0, 0.f);
         return;
-    }
 
     default:
         throw IException("Geotiff::copyToFloatGrid: invalid data type.");
@@ -42,6 +42,11 @@ void setupGISTransformation(double offsetx, double offsety, double offsetz, doub
     GISCoordTrans.setupTransformation(offsetx, offsety, offsetz, angle_degree);
 }
 
+const SCoordTrans &GISTransformation()
+{
+    return GISCoordTrans;
+}
+
 void worldToModel(const Vector3D &From, Vector3D &To)
 {
     double x=From.x() - GISCoordTrans.offsetX;
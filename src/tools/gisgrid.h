@@ -57,6 +57,8 @@ void setupGISTransformation(const double offsetx,
                             const double offsety,
                             const double offsetz,
                             const double angle_degree);
+// the current transformation
+const SCoordTrans &GISTransformation();
 // transformation routines.
 void worldToModel(const Vector3D &From, Vector3D &To);
 void modelToWorld(const Vector3D &From, Vector3D &To);
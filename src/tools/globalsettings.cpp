@@ -218,51 +218,132 @@ GlobalSettings::DebugOutputs GlobalSettings::debugOutputId(const QString debug_n
 
 
 
+/***************************************************************************/
+/*************************  DebugList  *************************************/
+/***************************************************************************/
+DebugList &DebugList::operator<<(const QVariant &value)
+{
+    switch (value.userType()) {
+    case QMetaType::Bool: return *this << value.toBool();
+    case QMetaType::Int: case QMetaType::UInt: case QMetaType::Long: case QMetaType::ULong: case QMetaType::LongLong: case QMetaType::ULongLong: return *this << value.toLongLong();
+    case QMetaType::Float: return *this << value.toFloat();
+    case QMetaType::Double: return *this << value.toDouble();
+    default: return *this << value.toString();
+    }
+}
+
+void DebugList::clear()
+{
+    DebugTable *t = table();
+    Q_ASSERT(mRow == t->rows.size()-1);
+    const int begin = t->rowBegin(mRow);
+    t->values.resize(begin);
+    t->types.resize(begin);
+    if (!mTable)
+        t->strings.clear(); // the own table has only a single row
+}
+
+QVariant DebugList::value(const int index) const
+{
+    const DebugTable *t = table();
+    const int i = t->rowBegin(mRow) + index;
+    switch (t->types[i]) {
+    case tFloat: return QVariant(static_cast<float>(t->values[i]));
+    case tInt: return QVariant(static_cast<qlonglong>(t->values[i]));
+    case tBool: return QVariant(t->values[i] != 0.);
+    case tString: return QVariant(t->strings[static_cast<int>(t->values[i])]);
+    default: return QVariant(t->values[i]);
+    }
+}
+
+QStringList DebugList::toStringList() const
+{
+    QStringList result;
+    for (int i=0;i<count();++i)
+        result.push_back(toString(i));
+    return result;
+}
+
+QDebug operator<<(QDebug dbg, const DebugList &list)
+{
+    dbg << list.toStringList();
+    return dbg;
+}
+
+// Storage of the debug outputs: every thread appends to its own tables (one per output type);
+// thus, no locking and no hash lookup is necessary when debug data is created. The rows
+// of a table are stored in a few contiguous arrays (i.e. no allocations per row).
+static const int cDebugOutputTypes = 10; // number of debug output types (see GlobalSettings::DebugOutputs)
+struct DebugThreadStore {
+    DebugTable tables[cDebugOutputTypes];
+    DebugList current[cDebugOutputTypes]; ///< the row that is currently filled
+};
+static QMutex debugListMutex; // protects the list of stores
+static QList<DebugThreadStore*> debug_stores; // all stores (owned)
+static thread_local DebugThreadStore *debug_thread_store = nullptr;
+
+// index of the output type (1->0, 2->1, 4->2, ...)
+inline int debugTypeIndex(const int dbg) { return qMin(static_cast<int>(qCountTrailingZeroBits(static_cast<quint32>(dbg))), cDebugOutputTypes-1); }
+// the key of a debug row: negative values are used for debug-outputs on RU - level
+inline int debugKey(const DebugList &list)
+{
+    int type = static_cast<int>(list.number(1));
+    int id = static_cast<int>(list.number(0));
+    // Note: at some point we will also have to handle RUS-level...
+    if (type == GlobalSettings::dEstablishment || type == GlobalSettings::dCarbonCycle || type == GlobalSettings::dSaplingGrowth)
+        return -id;
+    return id;
+}
+
 void GlobalSettings::clearDebugLists()
 {
-    mDebugLists.clear();
+    QMutexLocker m(&debugListMutex);
+    foreach(DebugThreadStore *store, debug_stores)
+        for (int i=0;i<cDebugOutputTypes;++i) {
+            store->tables[i] = DebugTable(); // release the memory
+            store->current[i] = DebugList();
+        }
 }
 
-static QMutex debugListMutex;
 DebugList &GlobalSettings::debugList(const int ID, const DebugOutputs dbg)
 {
-    QMutexLocker m(&debugListMutex); // serialize creation of debug outputs
-    DebugList dbglist;
+    if (!debug_thread_store) {
+        // first debug output of this thread: create and register a store
+        QMutexLocker m(&debugListMutex);
+        debug_thread_store = new DebugThreadStore();
+        debug_stores.push_back(debug_thread_store);
+    }
+    const int t = debugTypeIndex(dbg);
+    DebugTable &table = debug_thread_store->tables[t];
+    // a new row starts after the values of the last row (the first row of a table exists already)
+    if (!table.values.isEmpty())
+        table.rows.push_back(table.values.size());
+    DebugList &dbglist = debug_thread_store->current[t];
+    dbglist = DebugList(&table, table.rows.size()-1);
     dbglist << ID << dbg << currentYear();
-    int id = ID;
-    // use negative values for debug-outputs on RU - level
-    // Note: at some point we will also have to handle RUS-level...
-    if (dbg == dEstablishment || dbg == dCarbonCycle || dbg == dSaplingGrowth)
-        id = -id;
-    QMultiHash<int, DebugList>::iterator newitem = mDebugLists.insert(id, dbglist);
-    return *newitem;
+    return dbglist;
 }
-bool debuglist_sorter (const DebugList *i,const DebugList *j)
+bool debuglist_sorter (const DebugList &i,const DebugList &j)
 {
-    return ((*i)[0].toInt() < (*j)[0].toInt());
+    return i.number(0) < j.number(0);
 }
-const QList<const DebugList*> GlobalSettings::debugLists(const int ID, const DebugOutputs dbg)
+const QList<DebugList> GlobalSettings::debugLists(const int ID, const DebugOutputs dbg)
 {
-    QList<const DebugList*> result_list;
-    if (ID==-1) {
-        foreach(const DebugList &list, mDebugLists)
-            if (list.count()>2)  // contains data
-                if (int(dbg)==-1 || (list[1]).toInt() & int(dbg) ) // type fits or is -1 for all
-                    result_list << &list;
-    } else {
-        // search a specific id
-        QMultiHash<int, DebugList>::const_iterator res = mDebugLists.find(ID);
-        while (res != mDebugLists.end() && res.key() == ID)  {
-            const DebugList &list = res.value();
-            if (list.count()>2)  // contains data
-                if (int(dbg)==-1 || (list[1]).toInt() & int(dbg) ) // type fits or is -1 for all
-                    result_list << &list;
-            ++res;
+    QList<DebugList> result_list;
+    QMutexLocker m(&debugListMutex);
+    foreach(DebugThreadStore *store, debug_stores)
+        for (int t=0;t<cDebugOutputTypes;++t) {
+            if (int(dbg)!=-1 && !((1 << t) & int(dbg)))
+                continue; // type does not fit (-1: all types)
+            DebugTable *table = &store->tables[t];
+            for (int r=0;r<table->rows.size();++r) {
+                DebugList row(table, r);
+                if (row.count()>2 && (ID==-1 || debugKey(row)==ID))  // contains data, and id fits (or all ids: -1)
+                    result_list << row;
+            }
         }
-    }
     // sort result list
-    //std::sort(result_list.begin(), result_list.end(), debuglist_sorter); // changed because of compiler warnings
-    std::sort(result_list.begin(), result_list.end(), debuglist_sorter);
+    std::stable_sort(result_list.begin(), result_list.end(), debuglist_sorter);
     return result_list;
 }
 
@@ -349,7 +430,7 @@ QStringList GlobalSettings::debugDataTable(GlobalSettings::DebugOutputs type,
 {
 
     GlobalSettings *g = GlobalSettings::instance();
-    QList<const DebugList*> ddl = g->debugLists(-1, type); // get all debug data
+    const QList<DebugList> ddl = g->debugLists(-1, type); // get all debug data
 
     QStringList result;
     if (ddl.count()==0)
@@ -374,13 +455,7 @@ QStringList GlobalSettings::debugDataTable(GlobalSettings::DebugOutputs type,
     }
 
     for (int i=ddl.count()-1; i>=0; --i) {
-        QString line;
-        int c=0;
-        foreach(const QVariant &value, *ddl.at(i)) {
-            if (c++)
-                line+=separator;
-            line += value.toString();
-        }
+        QString line = ddl.at(i).toStringList().join(separator);
         // save data to the file, or to the
         if (out_file.isOpen())
             ts << line << Qt::endl;
@@ -397,19 +472,14 @@ QList<QPair<QString, QVariant> > GlobalSettings::debugValues(const int ID)
 {
 
     QList<QPair<QString, QVariant> > result;
-    QMultiHash<int, DebugList>::iterator res = mDebugLists.find(ID);
-    while (res != mDebugLists.end() && res.key() == ID)  {
-        DebugList &list = res.value();
-        if (list.count()>2) { // contains data
-           QStringList cap = debugListCaptions( DebugOutputs(list[1].toInt()) );
-           result.append(QPair<QString, QVariant>("Debug data", "Debug data") );
-           int first_index = 3;
-           if (list[3]=="Id")  // skip default data fields (not needed for drill down)
-               first_index=14;
-           for (int i=first_index;i<list.count();++i)
-               result.append(QPair<QString, QVariant>(cap[i], list[i]));
-        }
-        ++res;
+    foreach(const DebugList &list, debugLists(ID, DebugOutputs(-1))) {
+        QStringList cap = debugListCaptions( DebugOutputs(list[1].toInt()) );
+        result.append(QPair<QString, QVariant>("Debug data", "Debug data") );
+        int first_index = 3;
+        if (list.count()>3 && list[3]=="Id")  // skip default data fields (not needed for drill down)
+            first_index=14;
+        for (int i=first_index;i<list.count() && i<cap.count();++i)
+            result.append(QPair<QString, QVariant>(cap[i], list[i]));
     }
     return result;
 }
@@ -460,10 +530,17 @@ bool GlobalSettings::setupDatabaseConnection(const QString& dbname, const QStrin
         // db.exec("pragma temp_store(2)"); // temp storage in memory
         // db.exec("pragma synchronous(1)"); // medium synchronization between memory and disk (faster than "full", more than "none")
         // db.exec("pragma journal_mode(OFF)"); // disable transactions
-        QSqlQuery query;
         // https://stackoverflow.com/questions/1711631/improve-insert-per-second-performance-of-sqlite
-        query.exec("PRAGMA synchronous = OFF");
-        query.exec("PRAGMA journal_mode = MEMORY");
+        // the defaults favor speed; e.g. 'WAL' and 'NORMAL' are safer in case of a crash.
+        QString synchronous = settings().value("system.database.outSynchronous", "OFF").toUpper();
+        QString journal_mode = settings().value("system.database.outJournalMode", "MEMORY").toUpper();
+        if (!QStringList({"OFF", "NORMAL", "FULL", "EXTRA"}).contains(synchronous))
+            throw IException(QString("Invalid value '%1' for 'system.database.outSynchronous' (allowed: OFF, NORMAL, FULL, EXTRA).").arg(synchronous));
+        if (!QStringList({"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"}).contains(journal_mode))
+            throw IException(QString("Invalid value '%1' for 'system.database.outJournalMode' (allowed: DELETE, TRUNCATE, PERSIST, MEMORY, WAL, OFF).").arg(journal_mode));
+        QSqlQuery query(db);
+        query.exec(QString("PRAGMA synchronous = %1").arg(synchronous));
+        query.exec(QString("PRAGMA journal_mode = %1").arg(journal_mode));
     }
     return true;
 }
@@ -35,7 +35,68 @@
 #define QT_USE_FAST_CONCATENATION
 #define QT_USE_FAST_OPERATOR_PLUS
 
-typedef QList<QVariant> DebugList;
+/** @class DebugTable is the columnar storage of the rows of a debug output (see DebugList).
+  The values of all rows are stored contiguously (unboxed as double, plus a type tag per value), strings are
+  stored once per table, and 'rows' holds the index of the first value of each row.
+*/
+struct DebugTable
+{
+    DebugTable() { rows.push_back(0); } ///< a table starts with one (empty) row
+    QVector<double> values; ///< values of all rows (strings: index in 'strings')
+    QVector<char> types; ///< type tag of each value (see DebugList)
+    QStringList strings;
+    QVector<int> rows; ///< index of the first value of each row
+    int rowBegin(const int row) const { return rows[row]; }
+    int rowEnd(const int row) const { return row+1 < rows.size() ? rows[row+1] : values.size(); }
+    void clear() { values.clear(); types.clear(); strings.clear(); rows.clear(); rows.push_back(0); }
+};
+
+/** @class DebugList is a row of a fine grained debug output (see GlobalSettings::debugList()).
+  A DebugList is a view of a row in a DebugTable; values are stored typed and unboxed, and a QVariant is only created
+  when the data is read (e.g. when writing the debug output files). The first three values are the id, the type and the year.
+  Values can only be added to the last row of a table. A default constructed DebugList uses its own table (e.g. Tree::dumpList()).
+*/
+class DebugList
+{
+public:
+    DebugList(): mTable(nullptr), mRow(0) {}
+    DebugList(DebugTable *table, const int row): mTable(table), mRow(row) {}
+    DebugList &operator<<(const double value) { add(value, tDouble); return *this; }
+    DebugList &operator<<(const float value) { add(value, tFloat); return *this; }
+    DebugList &operator<<(const int value) { add(value, tInt); return *this; }
+    DebugList &operator<<(const unsigned int value) { add(value, tInt); return *this; }
+    DebugList &operator<<(const long value) { add(value, tInt); return *this; }
+    DebugList &operator<<(const unsigned long value) { add(value, tInt); return *this; }
+    DebugList &operator<<(const long long value) { add(value, tInt); return *this; }
+    DebugList &operator<<(const unsigned long long value) { add(value, tInt); return *this; }
+    DebugList &operator<<(const bool value) { add(value ? 1. : 0., tBool); return *this; }
+    DebugList &operator<<(const QString &value) { add(table()->strings.size(), tString); table()->strings.push_back(value); return *this; }
+    DebugList &operator<<(const char *value) { return *this << QString(value); }
+    DebugList &operator<<(const QVariant &value);
+    DebugList &operator<<(const QList<QVariant> &values) { for (const QVariant &v : values) *this << v; return *this; }
+
+    int count() const { return table()->rowEnd(mRow) - table()->rowBegin(mRow); }
+    bool isEmpty() const { return count()==0; }
+    void clear(); ///< remove the values of the row (only for the last row of the table)
+    QVariant value(const int index) const; ///< value at 'index' (boxed)
+    QVariant operator[](const int index) const { return value(index); }
+    double number(const int index) const { return table()->values[table()->rowBegin(mRow) + index]; } ///< numeric value (index of the text for strings)
+    QString toString(const int index) const { return value(index).toString(); }
+    QStringList toStringList() const; ///< all values as text
+private:
+    enum ValueType { tDouble, tFloat, tInt, tBool, tString };
+    DebugTable *table() { return mTable ? mTable : &mOwnTable; }
+    const DebugTable *table() const { return mTable ? mTable : &mOwnTable; }
+    void add(const double value, const ValueType type) {
+        DebugTable *t = table();
+        Q_ASSERT(mRow == t->rows.size()-1); // only the last row can be extended
+        t->values.push_back(value); t->types.push_back(static_cast<char>(type));
+    }
+    DebugTable *mTable; ///< the table with the data (null: use 'mOwnTable')
+    int mRow; ///< index of the row in the table
+    DebugTable mOwnTable; ///< storage of lists that are not part of a debug output
+};
+QDebug operator<<(QDebug dbg, const DebugList &list);
 
 class Model;
 class OutputManager;
@@ -84,8 +145,10 @@ public:
     int currentDebugOutput() const { return mDebugOutputs; }
     QString debugOutputName(const DebugOutputs d); ///< returns the name attached to 'd' or an empty string if not found
     DebugOutputs debugOutputId(const QString debug_name); ///< returns the DebugOutputs bit or 0 if not found
-    DebugList &debugList(const int ID, const DebugOutputs dbg); ///< returns a ref to a list ready to be filled with debug output of a type/id combination.
-    const QList<const DebugList*> debugLists(const int ID, const DebugOutputs dbg); ///< return a list of debug outputs
+    /// returns a ref to a list ready to be filled with debug output of a type/id combination.
+    /// The list is valid until the next call of debugList() for the same type in the same thread.
+    DebugList &debugList(const int ID, const DebugOutputs dbg);
+    const QList<DebugList> debugLists(const int ID, const DebugOutputs dbg); ///< return a list of debug outputs (views of the rows)
     QStringList debugListCaptions(const DebugOutputs dbg); ///< returns stringlist of captions for a specific output type
     QList<QPair<QString, QVariant> > debugValues(const int ID); ///< all debug values for object with given ID
     /// clear all debug data
@@ -100,6 +163,7 @@ public:
 
     // path and directory
     QString path(const QString &fileName, const QString &type="home");
+    void setPath(const QString &type, const QString &path) { mFilePath[type] = path; } ///< redirect the directory of a path type (e.g. "output")
     bool fileExists(const QString &fileName, const QString &type="home");
 
     // xml project file
@@ -131,8 +195,7 @@ private:
     int mRunYear;
     SystemStatistics *mSystemStatistics;
 
-    // special debug outputs
-    QMultiHash<int, DebugList> mDebugLists;
+    // special debug outputs (the data is stored per thread, see debugList())
     int mDebugOutputs; // "bitmap" of enabled debugoutputs.
 
     QHash<QString, QString> mFilePath; ///< storage for file paths
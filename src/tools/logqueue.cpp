@@ -0,0 +1,258 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#include "global.h"
+#include "logqueue.h"
+#include "globalsettings.h"
+
+#include <QTime>
+
+thread_local int LogContext::mRU = -1;
+thread_local int LogContext::mStand = -1;
+
+// The queue is a bounded multi-producer ring buffer (see D. Vyukov, "Bounded MPMC queue"):
+// each slot has a sequence number; a producer claims a position with a compare-and-swap, writes the record and
+// publishes the slot by advancing its sequence. The (single) consumer reads published slots in order.
+
+LogQueue::LogQueue(WriterFunc writer, const int capacity)
+{
+    int size = 1;
+    while (size < capacity)
+        size *= 2;
+    mSlots = new Slot[size];
+    for (int i=0;i<size;++i)
+        mSlots[i].sequence.store(static_cast<size_t>(i), std::memory_order_relaxed);
+    mMask = static_cast<size_t>(size - 1);
+    mEnqueuePos.store(0);
+    mDequeuePos = 0;
+    mProcessed.store(0);
+    mDropped.store(0);
+    mStop.store(false);
+    mWriter = writer;
+    mJson = false;
+    mDefaultLimit = 0;
+    mIntervalStart = QTime::currentTime().msecsSinceStartOfDay();
+    mThread = QThread::create([this]() { writerLoop(); });
+    mThread->start();
+}
+
+LogQueue::~LogQueue()
+{
+    mStop.store(true);
+    mThread->wait();
+    delete mThread;
+    delete[] mSlots;
+}
+
+void LogQueue::setRateLimits(const QString &limits)
+{
+    mLimits.clear();
+    mDefaultLimit = 0;
+    if (limits.trimmed().isEmpty())
+        return;
+    const QStringList items = limits.split(',');
+    for (const QString &item : items) {
+        int pos = item.indexOf('=');
+        if (pos < 0) {
+            mDefaultLimit = item.trimmed().toInt();
+            continue;
+        }
+        QString category = item.left(pos).trimmed();
+        int limit = item.mid(pos+1).trimmed().toInt();
+        if (category == "*")
+            mDefaultLimit = limit;
+        else
+            mLimits[category] = limit;
+    }
+}
+
+bool LogQueue::enqueue(LogRecord &record)
+{
+    Slot *slot;
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        slot = &mSlots[pos & mMask];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (dif == 0) {
+            if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return false; // the queue is full
+        } else {
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->record = std::move(record);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool LogQueue::dequeue(LogRecord &record)
+{
+    Slot &slot = mSlots[mDequeuePos & mMask];
+    size_t seq = slot.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(mDequeuePos + 1) < 0)
+        return false; // empty (or the slot is not yet published)
+    record = std::move(slot.record);
+    slot.sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+    ++mDequeuePos;
+    return true;
+}
+
+void LogQueue::log(const QtMsgType type, const char *category, const QString &message)
+{
+    LogRecord record;
+    record.type = type;
+    record.category = category ? category : "default";
+    record.time = QTime::currentTime().msecsSinceStartOfDay();
+    record.year = GlobalSettings::instance()->currentYear();
+    record.ru = LogContext::resourceUnit();
+    record.stand = LogContext::stand();
+    record.message = message;
+    if (isWriterThread()) {
+        // a message created while writing: write directly
+        mWriter(record, format(record));
+        return;
+    }
+    while (!enqueue(record)) {
+        if (type == QtDebugMsg) {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        QThread::yieldCurrentThread(); // warnings are not dropped: wait for the writer
+    }
+}
+
+void LogQueue::flush()
+{
+    if (isWriterThread())
+        return;
+    const size_t target = mEnqueuePos.load();
+    while (mProcessed.load() < target)
+        QThread::msleep(1);
+}
+
+void LogQueue::writerLoop()
+{
+    while (!mStop.load()) {
+        if (!processQueue())
+            QThread::msleep(5);
+    }
+    processQueue(); // the remaining messages
+    reportSuppressed();
+}
+
+bool LogQueue::processQueue()
+{
+    LogRecord record;
+    bool any = false;
+    while (dequeue(record)) {
+        any = true;
+        if (passRateLimit(record))
+            mWriter(record, format(record));
+        mProcessed.fetch_add(1);
+    }
+    size_t dropped = mDropped.exchange(0);
+    if (dropped > 0)
+        writeNote(QString("%1 log messages dropped (log queue full)").arg(dropped));
+    return any;
+}
+
+bool LogQueue::passRateLimit(const LogRecord &record)
+{
+    if (record.type != QtDebugMsg || (mDefaultLimit == 0 && mLimits.isEmpty()))
+        return true;
+    // a new interval (1 second) starts: report suppressed messages of the last interval
+    if (record.time < mIntervalStart || record.time - mIntervalStart >= 1000) {
+        reportSuppressed();
+        mCounts.clear();
+        mIntervalStart = record.time;
+    }
+    int limit = mLimits.value(QString::fromLatin1(record.category), mDefaultLimit);
+    if (limit <= 0)
+        return true;
+    int &count = mCounts[record.category];
+    if (count < limit) {
+        ++count;
+        return true;
+    }
+    ++mSuppressed[record.category];
+    return false;
+}
+
+void LogQueue::reportSuppressed()
+{
+    for (QHash<const char*, int>::const_iterator it=mSuppressed.constBegin(); it!=mSuppressed.constEnd(); ++it)
+        writeNote(QString("%1 messages of category '%2' suppressed (rate limit)").arg(it.value()).arg(it.key()));
+    mSuppressed.clear();
+}
+
+void LogQueue::writeNote(const QString &message)
+{
+    LogRecord record;
+    record.type = QtDebugMsg;
+    record.category = "default";
+    record.time = QTime::currentTime().msecsSinceStartOfDay();
+    record.year = GlobalSettings::instance()->currentYear();
+    record.ru = -1;
+    record.stand = -1;
+    record.message = message;
+    mWriter(record, format(record));
+}
+
+static QString jsonEscape(const QString &s)
+{
+    QString result;
+    result.reserve(s.size() + 8);
+    for (const QChar c : s) {
+        switch (c.unicode()) {
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if (c.unicode() < 0x20)
+                result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+            else
+                result += c;
+        }
+    }
+    return result;
+}
+
+QString LogQueue::format(const LogRecord &record) const
+{
+    QString time = QTime::fromMSecsSinceStartOfDay(record.time).toString("hh:mm:ss:zzz");
+    if (!mJson) {
+        // the same format as the synchronous logging
+        if (record.type == QtCriticalMsg || record.type == QtFatalMsg)
+            return record.message;
+        return QString("%1: %2").arg(time, record.message);
+    }
+    static const char *levels[] = {"debug", "warning", "critical", "fatal", "info"};
+    QString line = QString("{\"time\":\"%1\",\"level\":\"%2\",\"year\":%3,\"module\":\"%4\"")
+            .arg(time, levels[qBound(0, static_cast<int>(record.type), 4)]).arg(record.year).arg(jsonEscape(QString::fromLatin1(record.category)));
+    if (record.ru >= 0)
+        line += QString(",\"ru\":%1").arg(record.ru);
+    if (record.stand >= 0)
+        line += QString(",\"stand\":%1").arg(record.stand);
+    line += QString(",\"msg\":\"%1\"}").arg(jsonEscape(record.message));
+    return line;
+}
@@ -0,0 +1,119 @@
+/********************************************************************************************
+**    iLand - an individual based forest landscape and disturbance model
+**    https://iland-model.org
+**    Copyright (C) 2009-  Werner Rammer, Rupert Seidl
+**
+**    This program is free software: you can redistribute it and/or modify
+**    it under the terms of the GNU General Public License as published by
+**    the Free Software Foundation, either version 3 of the License, or
+**    (at your option) any later version.
+**
+**    This program is distributed in the hope that it will be useful,
+**    but WITHOUT ANY WARRANTY; without even the implied warranty of
+**    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**    GNU General Public License for more details.
+**
+**    You should have received a copy of the GNU General Public License
+**    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+********************************************************************************************/
+#ifndef LOGQUEUE_H
+#define LOGQUEUE_H
+
+#include <QString>
+#include <QHash>
+#include <QThread>
+#include <atomic>
+
+/** @class LogContext sets structured fields of log messages (resource unit, stand) for the current thread.
+  @ingroup tools
+  The context is set for the lifetime of the object (and restored afterwards), e.g.:
+  @code
+  LogContext context(ru->index()); // messages of this thread refer to the resource unit
+  @endcode
+  */
+class LogContext
+{
+public:
+    LogContext(const int ru_index, const int stand_id=-1): mPrevRU(mRU), mPrevStand(mStand) { mRU = ru_index; mStand = stand_id; }
+    ~LogContext() { mRU = mPrevRU; mStand = mPrevStand; }
+    static int resourceUnit() { return mRU; } ///< index of the resource unit (-1: not set)
+    static int stand() { return mStand; } ///< id of the ABE stand (-1: not set)
+private:
+    static thread_local int mRU;
+    static thread_local int mStand;
+    int mPrevRU, mPrevStand;
+};
+
+/** LogRecord is a single log message with its structured fields. */
+struct LogRecord {
+    QtMsgType type;
+    const char *category; ///< name of the logging category (static string, e.g. "abe", "default")
+    int time; ///< time of the message (ms since midnight)
+    int year; ///< simulation year
+    int ru; ///< resource unit index (-1: not set)
+    int stand; ///< ABE stand id (-1: not set)
+    QString message;
+};
+
+/** @class LogQueue is an asynchronous log writer.
+  @ingroup tools
+  Log messages are added by any thread to a bounded lock-free multi-producer queue (a ring buffer), and are formatted and
+  written by a background thread. The calling thread does not wait for the log file (and does not lock a mutex).
+  - bounded memory: if the queue is full, debug messages are dropped (and the number of dropped messages is logged);
+    warnings and more severe messages wait for free space.
+  - rate limits: the number of debug messages per category and second can be limited (e.g. "abe=100, *=1000");
+    suppressed messages are counted and reported.
+  - structured fields: the simulation year, the resource unit and ABE stand (see LogContext) and the logging category
+    are stored with each message; with the 'json' format, each message is written as a JSON object (one per line).
+  */
+class LogQueue
+{
+public:
+    /// the function that writes a message ('line' is the formatted message; called in the writer thread)
+    typedef void (*WriterFunc)(const LogRecord &record, const QString &line);
+    /// create the queue with (at least) 'capacity' slots and start the writer thread
+    LogQueue(WriterFunc writer, const int capacity=65536);
+    ~LogQueue(); ///< write all pending messages and stop the writer thread
+    /// rate limits (debug messages per category and second): a single number, or a list of category=limit (* for all other categories)
+    void setRateLimits(const QString &limits);
+    void setJsonFormat(const bool json) { mJson = json; }
+
+    /// add a message (thread safe, non-blocking for debug messages)
+    void log(const QtMsgType type, const char *category, const QString &message);
+    /// wait until all messages added so far are written
+    void flush();
+    /// true if called from the writer thread
+    bool isWriterThread() const { return QThread::currentThread() == mThread; }
+    /// format a message as a line of text (plain or JSON)
+    QString format(const LogRecord &record) const;
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+    bool enqueue(LogRecord &record);
+    bool dequeue(LogRecord &record);
+    void writerLoop();
+    bool processQueue(); ///< write the messages in the queue, returns false if the queue was empty
+    bool passRateLimit(const LogRecord &record); ///< true, if the message is not suppressed by the rate limit
+    void reportSuppressed();
+    void writeNote(const QString &message); ///< write a message of the logger itself
+    Slot *mSlots; ///< the ring buffer
+    size_t mMask;
+    std::atomic<size_t> mEnqueuePos;
+    size_t mDequeuePos; ///< only used by the writer thread
+    std::atomic<size_t> mProcessed; ///< number of messages processed by the writer
+    std::atomic<size_t> mDropped; ///< messages dropped because the queue was full
+    std::atomic<bool> mStop;
+    WriterFunc mWriter;
+    QThread *mThread;
+    bool mJson;
+    // rate limits (writer thread only)
+    int mDefaultLimit; ///< max. debug messages per second for categories without an explicit limit (0: no limit)
+    QHash<QString, int> mLimits; ///< max. debug messages per category and second
+    QHash<const char*, int> mCounts; ///< messages of the current interval per category
+    QHash<const char*, int> mSuppressed; ///< suppressed messages per category
+    int mIntervalStart; ///< start time of the current interval (ms since midnight)
+};
+
+#endif // LOGQUEUE_H
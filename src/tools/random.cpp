@@ -126,6 +126,17 @@ int RandomWeighted::get()
 
 }
 
+int RandomWeighted::get(const double u) const
+{
+    if (!mGrid || !mUpdated)
+        return -1;
+    int rnd = std::min(int(u * mMaxVal), mMaxVal-1);
+    int index=0;
+    while (rnd>=mGrid[index] && index<mSize)
+        index++;
+    return index;
+}
+
 double RandomWeighted::getRelWeight(const int index)
 {
     // das relative gewicht der Zelle "Index".
@@ -233,6 +244,7 @@ void RandomCustomPDF::setup(const QString &funcExpr,
         // tsetWeightghted operiert mit integers -> umrechnung: * huge_val
         mRandomIndex.setWeight(i, int(areaval*BIGINTVAL));
     }
+    mRandomIndex.update(); // the weights are fixed (required for the thread safe get())
 }
 
 double RandomCustomPDF::get()
@@ -249,6 +261,15 @@ double RandomCustomPDF::get()
     return value;
 }
 
+double RandomCustomPDF::get(const double u_slot, const double u_value) const
+{
+    if (!mExpression)
+        throw IException("TRandomCustomPDF: get() without setup()!"); // not set up properly
+    int slot = mRandomIndex.get(u_slot);
+    double basevalue = mLowerBound + slot*mDeltaX;
+    return basevalue + u_value*mDeltaX;
+}
+
 double RandomCustomPDF::getProbOfRange(const double lowerBound, const double upperBound)
 {
     if (mSumFunction) {
@@ -45,6 +45,9 @@ public:
         void setup(const int gridSize);
         void setWeight(const int index, const int value);
         int get();
+        /// get an index for the uniform random number 'u' (0..1). Thread safe, if the weights are not changed (see update()).
+        int get(const double u) const;
+        void update() { if (!mUpdated) updateValues(); } ///< update the internal (cumulative) weights after changing weights
         double getRelWeight(const int index);
         double getRelWeight(const int from, const int to);
 private:
@@ -69,6 +72,8 @@ public:
         const QString &densityFunction() const { return mFunction; }
         // operation
         double get(); ///< get a random number
+        /// get a random number for the two uniform random numbers 'u_slot' and 'u_value' (0..1), e.g. from a separate random stream. Thread safe.
+        double get(const double u_slot, const double u_value) const;
         double getProbOfRange(const double lowerBound, const double upperBound); ///< get probability of random numbers between given bounds.
 private:
         QString mFunction;
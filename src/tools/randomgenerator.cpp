@@ -115,6 +115,7 @@ unsigned int RandomGenerator::mBuffer[RANDOMGENERATORSIZE+5];
 int RandomGenerator::mIndex = 0;
 int RandomGenerator::mRotationCount = RANDOMGENERATORROTATIONS + 1;
 int RandomGenerator::mRefillCounter = 0;
+unsigned int RandomGenerator::mBufferSeed = 0;
 RandomGenerator::ERandomGenerators RandomGenerator::mGeneratorType = RandomGenerator::ergFastRandom;
 
 
@@ -136,6 +137,7 @@ void RandomGenerator::refill() {
     }
 
     RGenerators gen;
+    mBufferSeed = mBuffer[RANDOMGENERATORSIZE+4];
     gen.seed(mBuffer[RANDOMGENERATORSIZE+4]); // use the last value as seed for the next round....
     switch (mGeneratorType) {
     case ergMersenneTwister: {
@@ -177,3 +179,23 @@ void RandomGenerator::seed(const unsigned oneSeed)
         mBuffer[RANDOMGENERATORSIZE+4] = oneSeed; // set a specific seed as seed for the next round
     }
 }
+
+void RandomGenerator::state(unsigned int rState[5])
+{
+    rState[0] = static_cast<unsigned int>(mGeneratorType);
+    rState[1] = mBufferSeed;
+    rState[2] = static_cast<unsigned int>(mIndex);
+    rState[3] = static_cast<unsigned int>(mRotationCount);
+    rState[4] = static_cast<unsigned int>(mRefillCounter);
+}
+
+void RandomGenerator::setState(const unsigned int state[5])
+{
+    // re-create the buffer from the seed, then jump to the stored position
+    setGeneratorType(static_cast<ERandomGenerators>(state[0]));
+    mBuffer[RANDOMGENERATORSIZE+4] = state[1];
+    refill();
+    mIndex = static_cast<int>(state[2]);
+    mRotationCount = static_cast<int>(state[3]);
+    mRefillCounter = static_cast<int>(state[4]);
+}
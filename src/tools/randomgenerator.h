@@ -41,6 +41,10 @@ public:
     static void setup(const ERandomGenerators gen, const unsigned oneSeed) { setGeneratorType(gen); seed(oneSeed); checkGenerator(); }
     /// set a random generator seed. If oneSeed is 0, then a random number (provided by system time) is used as initial seed.
     static void seed(const unsigned oneSeed);
+    /// retrieve the state of the generator (generator type, seed of the current buffer, index, rotation and refill counter), e.g. for checkpoints.
+    static void state(unsigned int rState[5]);
+    /// restore a state retrieved by state(): the buffer is re-created from the stored seed, and the position within the buffer restored.
+    static void setState(const unsigned int state[5]);
     /// get a random value from [0., 1.]
     static inline double rand() { return next() * (1.0/4294967295.0); }
     static inline double rand(const double max_value) { return max_value * rand(); }
@@ -56,6 +60,7 @@ private:
     static int mIndex;
     static int mRotationCount;
     static int mRefillCounter;
+    static unsigned int mBufferSeed; ///< seed that was used to fill the current buffer
     static ERandomGenerators mGeneratorType;
     static void refill();
 };
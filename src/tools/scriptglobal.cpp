@@ -35,6 +35,7 @@
 #include "modelcontroller.h"
 #include "grid.h"
 #include "snapshot.h"
+#include "soilspinup.h"
 #include "speciesset.h"
 #include "species.h"
 #include "seeddispersal.h"
@@ -1041,6 +1042,20 @@ bool ScriptGlobal::loadStandCarbon()
 
 }
 
+int ScriptGlobal::soilSpinup(int max_cycles, double tolerance, QString file_name)
+{
+    try {
+        SoilSpinup spinup(max_cycles, tolerance);
+        int n = spinup.run();
+        if (!file_name.isEmpty())
+            spinup.saveState(GlobalSettings::instance()->path(file_name));
+        return n;
+    } catch (const IException &e) {
+        throwError(e.message());
+    }
+    return 0;
+}
+
 void ScriptGlobal::reloadABE()
 {
     qDebug() << "attempting to reload ABE";
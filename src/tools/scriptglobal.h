@@ -206,6 +206,8 @@ public slots:
     bool loadStandSnapshot(int stand_id, QString file_name);
     bool saveStandCarbon(int stand_id, QList<int> ru_ids, bool rid_mode=true);
     bool loadStandCarbon();
+    /// spin-up of the soil pools with the recorded soil inputs (see SoilSpinup). The pools are saved to 'file_name' (if provided).
+    int soilSpinup(int max_cycles=100, double tolerance=0.0001, QString file_name=QString());
     // agent-based-model of forest management
     void reloadABE();
 
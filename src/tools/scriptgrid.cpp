@@ -26,14 +26,47 @@
 #include "expressionwrapper.h"
 #include "model.h"
 #include "tree.h"
+#include "resourceunit.h"
 
 
 #include <QJSEngine>
 #include <QJSValueIterator>
+#include <QtConcurrent/QtConcurrent>
 
 int ScriptGrid::mDeleted = 0;
 int ScriptGrid::mCreated = 0;
 
+// number of grid cells that are processed as one block by a thread
+static const int cCellBlockSize = 16384;
+
+// run 'func(begin, end)' for blocks of 'n' items (grid cells, resource units) in parallel (if
+// multithreading is enabled). Errors of the workers are collected and thrown after all blocks are processed.
+template <typename F>
+static void runBlocks(const int n, const int block_size, F func)
+{
+    QVector<int> blocks;
+    for (int i=0;i<n;i+=block_size)
+        blocks.push_back(i);
+    QString error;
+    QMutex error_lock;
+    auto run_block = [&](const int start) {
+        try {
+            func(start, qMin(start + block_size, n));
+        } catch (const IException &e) {
+            QMutexLocker lock(&error_lock);
+            error = e.message();
+        }
+    };
+    Model *model = GlobalSettings::instance()->model();
+    if (blocks.size()>1 && model && model->multithreading())
+        QtConcurrent::blockingMap(blocks, run_block);
+    else
+        for (int i=0;i<blocks.size();++i)
+            run_block(blocks[i]);
+    if (!error.isEmpty())
+        throw IException(error);
+}
+
 ScriptGrid::ScriptGrid(QObject *parent) : QObject(parent)
 {
     mGrid = nullptr;
@@ -182,7 +215,7 @@ void ScriptGrid::apply(QString expression)
         return;
 
     Expression expr;
-    double *varptr = expr.addVar(mVariableName);
+    expr.addVar(mVariableName);
     try {
         expr.setExpression(expression);
         expr.parse();
@@ -191,11 +224,17 @@ void ScriptGrid::apply(QString expression)
         return;
     }
 
-    // now apply function on grid
-    for (double *p = mGrid->begin(); p!=mGrid->end(); ++p) {
-        *varptr = *p;
-        *p = expr.execute();
-    }
+    // now apply function on grid (in parallel, each block uses its own variable space)
+    // note: incsum() depends on the order of cells, i.e. such expressions are executed sequentially
+    const int var_index = expr.variables().indexOf(mVariableName);
+    double *data = mGrid->begin();
+    runBlocks(mGrid->count(), expr.usesIncSum() ? mGrid->count() : cCellBlockSize, [&](const int begin, const int end) {
+        double var_space[EXPRNLOCALVARS] = {0.};
+        for (double *p = data + begin; p != data + end; ++p) {
+            var_space[var_index] = *p;
+            *p = expr.execute(var_space);
+        }
+    });
 
 }
 
@@ -225,9 +264,8 @@ void ScriptGrid::combine(QString expression, QJSValue grid_object)
     }
     // now add names
     Expression expr;
-    QVector<double *> vars;
     for (int i=0;i<names.count();++i)
-        vars.push_back( expr.addVar(names[i]) );
+        expr.addVar(names[i]);
     try {
         expr.setExpression(expression);
         expr.parse();
@@ -236,14 +274,20 @@ void ScriptGrid::combine(QString expression, QJSValue grid_object)
         return;
     }
 
-    // now apply function on grid
-    for (int i=0;i<mGrid->count();++i) {
-        // set variable values in the expression object
-        for (int v=0;v<names.count();++v)
-            *vars[v] = grids[v]->valueAtIndex(i);
-        double result = expr.execute();
-        mGrid->valueAtIndex(i) = result; // write back value
-    }
+    QVector<int> var_index;
+    for (int v=0;v<names.count();++v)
+        var_index.push_back(expr.variables().indexOf(names[v]));
+
+    // now apply function on grid (in parallel, each block uses its own variable space; sequentially with incsum())
+    runBlocks(mGrid->count(), expr.usesIncSum() ? mGrid->count() : cCellBlockSize, [&](const int begin, const int end) {
+        double var_space[EXPRNLOCALVARS] = {0.};
+        for (int i=begin;i<end;++i) {
+            // set variable values
+            for (int v=0;v<var_index.size();++v)
+                var_space[var_index[v]] = grids[v]->constValueAtIndex(i);
+            mGrid->valueAtIndex(i) = expr.execute(var_space); // write back value
+        }
+    });
 }
 
 QJSValue ScriptGrid::resample(QJSValue grid_object)
@@ -287,9 +331,22 @@ void ScriptGrid::aggregate(int factor)
     if (!mGrid) {
         throw IException("ERROR in ScriptGrid::aggregate(): not a valid grid!");
     }
-    Grid<double> res = mGrid->averaged(factor);
-    // make a copy on the heap
-    Grid<double> *new_grid = new Grid<double>(res);
+    if (factor<1)
+        throw IException("ERROR in ScriptGrid::aggregate(): invalid factor!");
+    // the same as Grid::averaged(), but rows of the target grid are processed in parallel
+    Grid<double> *new_grid = new Grid<double>(mGrid->metricRect(), mGrid->cellsize()*factor);
+    new_grid->initialize(0.);
+    const Grid<double> &src = *mGrid;
+    const double fsquare = factor*factor;
+    runBlocks(new_grid->sizeY(), 1, [&](const int ty, const int) {
+        for (int tx=0;tx<new_grid->sizeX();++tx) {
+            double sum = 0.;
+            for (int x=tx*factor; x<qMin((tx+1)*factor, src.sizeX()); ++x)
+                for (int y=ty*factor; y<qMin((ty+1)*factor, src.sizeY()); ++y)
+                    sum += src.constValueAtIndex(x, y);
+            new_grid->valueAtIndex(tx, ty) = sum / fsquare;
+        }
+    });
     // delete the old data, and use the new data instead
     delete mGrid;
     mGrid = new_grid;
@@ -315,7 +372,7 @@ double ScriptGrid::sum(QString expression)
         return -1.;
 
     Expression expr;
-    double *varptr = expr.addVar(mVariableName);
+    expr.addVar(mVariableName);
     try {
         expr.setExpression(expression);
         expr.parse();
@@ -324,12 +381,23 @@ double ScriptGrid::sum(QString expression)
         return -1.;
     }
 
-    // now apply function on grid
+    // now apply function on grid: sum up blocks in parallel, and then the partial sums (sequentially with incsum())
+    const int var_index = expr.variables().indexOf(mVariableName);
+    const double *data = mGrid->begin();
+    const int block_size = expr.usesIncSum() ? mGrid->count() : cCellBlockSize;
+    QVector<double> partial_sum(mGrid->count() / block_size + 1, 0.);
+    runBlocks(mGrid->count(), block_size, [&](const int begin, const int end) {
+        double var_space[EXPRNLOCALVARS] = {0.};
+        double block_sum = 0.;
+        for (const double *p = data + begin; p != data + end; ++p) {
+            var_space[var_index] = *p;
+            block_sum += expr.execute(var_space);
+        }
+        partial_sum[begin / block_size] = block_sum;
+    });
     double sum = 0.;
-    for (double *p = mGrid->begin(); p!=mGrid->end(); ++p) {
-        *varptr = *p;
-        sum += expr.execute();
-    }
+    for (int i=0;i<partial_sum.size();++i)
+        sum += partial_sum[i];
     return sum;
 }
 
@@ -345,30 +413,68 @@ void ScriptGrid::sumTrees(QString expression, QString filter)
         TreeWrapper tw;
         Expression custom_expr;
         custom_expr.setExpression(expression);
-        custom_expr.setModelObject(&tw);
+        custom_expr.parse(&tw); // check the expressions before the parallel execution
 
         Expression filterexpr;
         bool do_filter = !filter.isEmpty();
-        filterexpr.setExpression(filter);
-        filterexpr.setModelObject(&tw);
-
-        AllTreeIterator ati(GlobalSettings::instance()->model());
-        while (Tree *t = ati.next()) {
-
-            // only trees on the grid area:
-            if (!mGrid->coordValid(t->position()))
-                continue;
-
-            // apply filter
-            tw.setTree(t);
-            if (do_filter && !filterexpr.execute())
-                continue;
-
-            // calculate
-            double val=custom_expr.execute();
-            mGrid->valueAt(t->position()) += val;
+        if (do_filter) {
+            filterexpr.setExpression(filter);
+            filterexpr.parse(&tw);
         }
 
+        // trees are processed in parallel (blocks of resource units); each block writes
+        // to its own partial grid, and the partial grids are summed up afterwards.
+        // Each block uses its own copy of the expressions (calculate() is not thread safe),
+        // expressions with incsum() are executed sequentially.
+        Model *model = GlobalSettings::instance()->model();
+        const QList<ResourceUnit*> &rus = model->ruList();
+        const bool sequential = custom_expr.usesIncSum() || (do_filter && filterexpr.usesIncSum());
+        const int n_parts = model->multithreading() && !sequential ? qMax(QThreadPool::globalInstance()->maxThreadCount(), 1) : 1;
+        const int ru_block_size = qMax((rus.count() + n_parts - 1) / n_parts, 1);
+        QVector< QVector<double> > partial_grids((rus.count() + ru_block_size - 1) / ru_block_size);
+        Grid<double> &grid = *mGrid;
+        runBlocks(rus.count(), ru_block_size, [&](const int begin, const int end) {
+            QVector<double> &part = partial_grids[begin / ru_block_size];
+            part.fill(0., grid.count());
+            TreeWrapper local_tw;
+            Expression local_expr(expression);
+            local_expr.parse(&local_tw);
+            Expression local_filter;
+            if (do_filter) {
+                local_filter.setExpression(filter);
+                local_filter.parse(&local_tw);
+            }
+            for (int r=begin;r<end;++r) {
+                QVector<Tree> &trees = rus[r]->trees();
+                for (int i=0;i<trees.size();++i) {
+                    Tree *t = &trees[i];
+                    // only trees on the grid area:
+                    const QPointF pos = t->position();
+                    if (!grid.coordValid(pos))
+                        continue;
+
+                    // apply filter
+                    local_tw.setTree(t);
+                    if (do_filter && !local_filter.calculateBool(local_tw))
+                        continue;
+
+                    // calculate
+                    part[grid.index(grid.indexAt(pos))] += local_expr.calculate(local_tw);
+                }
+            }
+        });
+
+        // sum up the partial grids
+        runBlocks(grid.count(), cCellBlockSize, [&](const int begin, const int end) {
+            for (int p=0;p<partial_grids.size();++p) {
+                if (partial_grids[p].isEmpty())
+                    continue;
+                const double *src = partial_grids[p].constData();
+                for (int i=begin;i<end;++i)
+                    grid.valueAtIndex(i) += src[i];
+            }
+        });
+
     } catch(const IException &e) {
         qDebug() << "ScriptGrid::sumTrees: an error occured." << e.message();
     }
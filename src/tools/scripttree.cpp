@@ -84,6 +84,71 @@ void ScriptTreeExpr::addToScriptEngine(QJSEngine &engine)
     engine.globalObject().setProperty("TreeExpr", jsMetaObject);
 }
 
+static const char *column_names[] = { "dbh", "height", "x", "y", "species", "age", "flags", "id", "ru",
+                                      "leafArea", "basalArea", "volume", "lri", "stressIndex" };
+
+ScriptTreeColumns::Column ScriptTreeColumns::column(const QString &name)
+{
+    for (int i=0;i<ColCount;++i)
+        if (name == QLatin1String(column_names[i]))
+            return static_cast<Column>(i);
+    throw IException(QString("invalid tree column '%1'. Available columns: %2").arg(name).arg(columnNames().join(", ")));
+}
+
+QStringList ScriptTreeColumns::columnNames()
+{
+    QStringList names;
+    for (int i=0;i<ColCount;++i)
+        names.push_back(column_names[i]);
+    return names;
+}
+
+QJSValue ScriptTreeColumns::typedArray(QJSEngine *engine, const QByteArray &data, const QString &type)
+{
+    // the QByteArray is converted to an ArrayBuffer, the typed array is a view on this buffer
+    QJSValue buffer = engine->toScriptValue(data);
+    return engine->globalObject().property(type).callAsConstructor(QJSValueList() << buffer);
+}
+
+QVector<bool> ScriptTreeColumns::mask(QJSEngine *engine, const QJSValue &mask, const int n)
+{
+    QVector<bool> result(n, false);
+    const QString type = mask.property("constructor").property("name").toString();
+    const int len = mask.property("length").toInt();
+    if (len != n)
+        throw IException(QString("invalid mask: the length (%1) differs from the number of trees (%2).").arg(len).arg(n));
+
+    if (type.endsWith("Array") && type!="Array" && mask.hasProperty("buffer")) {
+        // typed array: read directly from the underlying buffer
+        const QByteArray buffer = engine->fromScriptValue<QByteArray>(mask.property("buffer"));
+        const int offset = mask.property("byteOffset").toInt();
+        const int elem_size = mask.property("BYTES_PER_ELEMENT").toInt();
+        if (elem_size<1 || offset + n*elem_size > buffer.size())
+            throw IException("invalid mask: cannot access the buffer of the typed array.");
+        const char *p = buffer.constData() + offset;
+        if (type == "Float32Array") {
+            const float *f = reinterpret_cast<const float*>(p);
+            for (int i=0;i<n;++i)
+                result[i] = f[i] != 0.f;
+        } else if (type == "Float64Array") {
+            const double *d = reinterpret_cast<const double*>(p);
+            for (int i=0;i<n;++i)
+                result[i] = d[i] != 0.;
+        } else {
+            // integer types: true if any byte of the element is not 0
+            for (int i=0;i<n;++i, p+=elem_size)
+                for (int b=0;b<elem_size;++b)
+                    if (p[b]) { result[i] = true; break; }
+        }
+        return result;
+    }
+    if (!mask.isArray())
+        throw IException("invalid mask: expected a typed array or an array.");
+    for (int i=0;i<n;++i)
+        result[i] = mask.property(static_cast<quint32>(i)).toBool();
+    return result;
+}
+
 double ScriptTreeExpr::value(ScriptTree *script_tree)
 {
     if (!script_tree->tree()) {
@@ -2,8 +2,11 @@
 #define SCRIPTTREE_H
 
 #include <QObject>
+#include <QJSValue>
+#include <QJSEngine>
 #include "tree.h"
 #include "species.h"
+#include "resourceunit.h"
 #include "expressionwrapper.h"
 
 class ScriptTree : public QObject
@@ -75,4 +78,76 @@ private:
     TreeWrapper mTW;
 };
 
+/** ScriptTreeColumns provides column-wise access to attributes of a list of trees from JavaScript.
+  The values are copied into a contiguous buffer and returned as typed arrays (Float32Array / Int32Array),
+  masks (typed arrays or JS arrays with one value per tree) are used for bulk operations on the list.
+  Used by Management and ABE::FMTreeList. */
+class ScriptTreeColumns
+{
+public:
+    enum Column { ColDbh, ColHeight, ColX, ColY, ColSpecies, ColAge, ColFlags, ColId, ColRU,
+                  ColLeafArea, ColBasalArea, ColVolume, ColLRI, ColStressIndex, ColCount };
+    static Column column(const QString &name); ///< get the column for 'name', throws an exception for invalid names
+    static QStringList columnNames(); ///< list of all available columns
+    /// create a typed array with the values of column 'name' for all trees in 'trees' (a container of QPair<Tree*, double>)
+    template<class C> static QJSValue values(QJSEngine *engine, const C &trees, const QString &name);
+    /// create a JS object with one typed array per element of 'names'
+    template<class C> static QJSValue values(QJSEngine *engine, const C &trees, const QStringList &names);
+    /// read 'mask' (typed array or JS array) with 'n' elements, throws an exception if the length does not match
+    static QVector<bool> mask(QJSEngine *engine, const QJSValue &mask, const int n);
+private:
+    static bool isInteger(const Column col) { return col==ColSpecies || col==ColAge || col==ColFlags || col==ColId || col==ColRU; }
+    static inline double value(const Tree *t, const Column col);
+    static QJSValue typedArray(QJSEngine *engine, const QByteArray &data, const QString &type);
+};
+
+double ScriptTreeColumns::value(const Tree *t, const Column col)
+{
+    switch (col) {
+    case ColDbh: return t->dbh();
+    case ColHeight: return t->height();
+    case ColX: return t->position().x();
+    case ColY: return t->position().y();
+    case ColSpecies: return t->species()->index();
+    case ColAge: return t->age();
+    case ColFlags: return t->flags();
+    case ColId: return t->id();
+    case ColRU: return t->ru()->index();
+    case ColLeafArea: return t->leafArea();
+    case ColBasalArea: return t->basalArea();
+    case ColVolume: return t->volume();
+    case ColLRI: return t->lightResourceIndex();
+    case ColStressIndex: return t->stressIndex();
+    default: return 0.;
+    }
+}
+
+template<class C>
+QJSValue ScriptTreeColumns::values(QJSEngine *engine, const C &trees, const QString &name)
+{
+    const Column col = column(name);
+    const int n = trees.size();
+    if (isInteger(col)) {
+        QByteArray data(n * int(sizeof(qint32)), Qt::Uninitialized);
+        qint32 *p = reinterpret_cast<qint32*>(data.data());
+        for (typename C::const_iterator it=trees.constBegin(); it!=trees.constEnd(); ++it)
+            *p++ = static_cast<qint32>(value(it->first, col));
+        return typedArray(engine, data, QStringLiteral("Int32Array"));
+    }
+    QByteArray data(n * int(sizeof(float)), Qt::Uninitialized);
+    float *p = reinterpret_cast<float*>(data.data());
+    for (typename C::const_iterator it=trees.constBegin(); it!=trees.constEnd(); ++it)
+        *p++ = static_cast<float>(value(it->first, col));
+    return typedArray(engine, data, QStringLiteral("Float32Array"));
+}
+
+template<class C>
+QJSValue ScriptTreeColumns::values(QJSEngine *engine, const C &trees, const QStringList &names)
+{
+    QJSValue result = engine->newObject();
+    for (const QString &name : names)
+        result.setProperty(name, values(engine, trees, name));
+    return result;
+}
+
 #endif // SCRIPTTREE_H
@@ -28,6 +28,8 @@
 
 #include <QJSEngine>
 #include <QJSValue>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
 void SpatialAnalysis::addToScriptEngine()
 {
     QJSValue jsMetaObject = GlobalSettings::instance()->scriptEngine()->newQMetaObject(&SpatialAnalysis::staticMetaObject);
@@ -48,83 +50,174 @@ double SpatialAnalysis::rumpleIndexFullArea()
     return rum;
 }
 
+/* Patch extraction (connected component labelling)
+   The labelling is a two-pass union-find algorithm on pixel indices, which runs in parallel for bands of rows:
+   (1) each band is labelled independently, (2) the trees of adjacent bands are merged along the band borders,
+   (3) the statistics of the patches are collected (in parallel for each band), and (4) the final patch ids are written.
+   The root of a set is always the pixel with the smallest index (i.e., the first pixel of the patch in scan order), therefore
+   the patch ids are identical to a sequential flood fill (patch 1 is the patch with the first pixel, ...). */
+struct PatchAccumulator {
+    PatchAccumulator(): size(0), x_min(std::numeric_limits<int>::max()), y_min(std::numeric_limits<int>::max()), x_max(-1), y_max(-1), x_sum(0.), y_sum(0.) {}
+    void add(const int x, const int y) { ++size; x_min=qMin(x_min, x); x_max=qMax(x_max,x); y_min=qMin(y_min,y); y_max=qMax(y_max, y); x_sum+=x; y_sum+=y; }
+    void add(const PatchAccumulator &other) { size+=other.size; x_min=qMin(x_min, other.x_min); x_max=qMax(x_max,other.x_max);
+                                              y_min=qMin(y_min,other.y_min); y_max=qMax(y_max, other.y_max); x_sum+=other.x_sum; y_sum+=other.y_sum; }
+    int size;
+    int x_min, y_min, x_max, y_max;
+    double x_sum, y_sum;
+};
+
+// find the root of the pixel 'i' (with path halving). Parents have always lower indices than their children.
+static inline int patchFind(int *parent, int i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+// find the root without modifying the trees (used when multiple threads access the trees)
+static inline int patchRoot(const int *parent, int i)
+{
+    while (parent[i] != i)
+        i = parent[i];
+    return i;
+}
+static inline void patchUnion(int *parent, const int a, const int b)
+{
+    int ra = patchFind(parent, a);
+    int rb = patchFind(parent, b);
+    if (ra < rb)
+        parent[rb] = ra;
+    else if (rb < ra)
+        parent[ra] = rb;
+}
+// link pixel 'i' with its already visited neighbors in the row below (y-1) and (for x-1) in the same row
+static inline void patchLinkNeighbors(int *parent, const int i, const int x, const int nx, const bool link_west, const bool link_south, const int connectivity)
+{
+    if (link_west && x>0 && parent[i-1]>=0)
+        patchUnion(parent, i-1, i);
+    if (link_south) {
+        const int j = i - nx;
+        if (parent[j]>=0)
+            patchUnion(parent, j, i);
+        if (connectivity==8) {
+            if (x>0 && parent[j-1]>=0)
+                patchUnion(parent, j-1, i);
+            if (x<nx-1 && parent[j+1]>=0)
+                patchUnion(parent, j+1, i);
+        }
+    }
+}
+
+// first pass for the rows [row_from, row_to): all operations stay within the band
+static void patchLabelBand(const Grid<double> &src, int *parent, const int row_from, const int row_to, const int connectivity)
+{
+    const int nx = src.sizeX();
+    for (int y=row_from; y<row_to; ++y)
+        for (int x=0; x<nx; ++x) {
+            const int i = y*nx + x;
+            if (!(src.constValueAtIndex(i) > 0.)) {
+                parent[i] = -1;
+                continue;
+            }
+            parent[i] = i;
+            patchLinkNeighbors(parent, i, x, nx, true, y>row_from, connectivity);
+        }
+    // flatten the trees: all pixels point directly to the root of the band
+    for (int i=row_from*nx; i<row_to*nx; ++i)
+        if (parent[i]>=0)
+            parent[i] = parent[parent[i]];
+}
+
 /// extract patches (clumps) from the grid 'src'.
-/// Patches are defined as adjacent pixels (8-neighborhood)
+/// Patches are defined as adjacent pixels (8-neighborhood or 4-neighborhood, see 'connectivity')
 /// Return: vector with number of pixels per patch (first element: patch 1, second element: patch 2, ...)
-QList<int> SpatialAnalysis::extractPatches(Grid<double> &src, int min_size, QString fileName)
+QList<int> SpatialAnalysis::extractPatches(Grid<double> &src, int min_size, QString fileName, int connectivity)
 {
+    if (connectivity!=4 && connectivity!=8)
+        throw IException(QString("SpatialAnalysis::extractPatches: invalid connectivity '%1' (allowed are 4 and 8).").arg(connectivity));
     mClumpGrid.setup(src.metricRect(), src.cellsize());
-    mClumpGrid.wipe();
+    mLastPatchStats.clear();
+    const int nx = src.sizeX();
+    const int ny = src.sizeY();
+    std::vector<int> parent_vec(size_t(src.count()));
+    int *parent = parent_vec.data();
+
+    // bands of rows (more bands than threads for a better load balance)
+    QVector<QPair<int, int> > bands;
+    const int n_bands = qMax(1, qMin(ny, QThread::idealThreadCount()*4));
+    for (int b=0;b<n_bands;++b) {
+        int from = int(qint64(ny)*b/n_bands), to = int(qint64(ny)*(b+1)/n_bands);
+        if (to>from)
+            bands.push_back(QPair<int,int>(from, to));
+    }
+
+    // (1) label the bands in parallel
+    QtConcurrent::blockingMap(bands, [&](const QPair<int,int> &band) {
+        patchLabelBand(src, parent, band.first, band.second, connectivity);
+    });
+    // (2) merge the bands along the borders (only a single row per band)
+    for (int b=1;b<bands.size();++b) {
+        const int y = bands[b].first;
+        for (int x=0;x<nx;++x) {
+            const int i = y*nx + x;
+            if (parent[i]>=0)
+                patchLinkNeighbors(parent, i, x, nx, false, true, connectivity);
+        }
+    }
 
-    // now loop over all pixels and run a floodfill algorithm
-    QPoint start;
-    QQueue<QPoint> pqueue; // for the flood fill algorithm
+    // (3) statistics per patch (the key is the root pixel)
+    QVector< QHash<int, PatchAccumulator> > band_stats(bands.size());
+    QVector<int> band_index(bands.size());
+    for (int b=0;b<bands.size();++b)
+        band_index[b] = b;
+    QtConcurrent::blockingMap(band_index, [&](const int b) {
+        QHash<int, PatchAccumulator> &stats = band_stats[b];
+        for (int y=bands[b].first; y<bands[b].second; ++y)
+            for (int x=0; x<nx; ++x) {
+                const int i = y*nx + x;
+                if (parent[i]>=0)
+                    stats[patchRoot(parent, i)].add(x, y);
+            }
+    });
+    QHash<int, PatchAccumulator> stats;
+    for (int b=0;b<band_stats.size();++b)
+        for (auto it=band_stats[b].constBegin(); it!=band_stats[b].constEnd(); ++it)
+            stats[it.key()].add(it.value());
+
+    // patch ids in the order of the first pixel of the patch; small patches are skipped (id=0)
+    QList<int> roots = stats.keys();
+    std::sort(roots.begin(), roots.end());
+    QHash<int, int> root_ids;
     QList<int> counts;
-    int patch_index = 0;
     int total_size = 0;
     int patches_skipped = 0;
-    for (int i=0;i<src.count();++i) {
-        if (src[i]>0. && mClumpGrid[i]==0) {
-            start = src.indexOf(i);
-            pqueue.clear();
-            patch_index++;
-
-            // quick and dirty implementation of the flood fill algroithm.
-            // based on: http://en.wikipedia.org/wiki/Flood_fill
-            // returns the number of pixels colored
-
-            pqueue.enqueue(start);
-            int found = 0;
-            while (!pqueue.isEmpty()) {
-                QPoint p = pqueue.dequeue();
-                if (!src.isIndexValid(p))
-                    continue;
-                if (src.valueAtIndex(p)>0. && mClumpGrid.valueAtIndex(p) == 0) {
-                    mClumpGrid.valueAtIndex(p) = patch_index;
-                    pqueue.enqueue(p+QPoint(-1,0));
-                    pqueue.enqueue(p+QPoint(1,0));
-                    pqueue.enqueue(p+QPoint(0,-1));
-                    pqueue.enqueue(p+QPoint(0,1));
-                    pqueue.enqueue(p+QPoint(1,1));
-                    pqueue.enqueue(p+QPoint(-1,1));
-                    pqueue.enqueue(p+QPoint(-1,-1));
-                    pqueue.enqueue(p+QPoint(1,-1));
-                    ++found;
-                }
-            }
-            if (found<min_size) {
-                // delete the patch again
-                pqueue.enqueue(start);
-                while (!pqueue.isEmpty()) {
-                    QPoint p = pqueue.dequeue();
-                    if (!src.isIndexValid(p))
-                        continue;
-                    if (mClumpGrid.valueAtIndex(p) == patch_index) {
-                        mClumpGrid.valueAtIndex(p) = -1;
-                        pqueue.enqueue(p+QPoint(-1,0));
-                        pqueue.enqueue(p+QPoint(1,0));
-                        pqueue.enqueue(p+QPoint(0,-1));
-                        pqueue.enqueue(p+QPoint(0,1));
-                        pqueue.enqueue(p+QPoint(1,1));
-                        pqueue.enqueue(p+QPoint(-1,1));
-                        pqueue.enqueue(p+QPoint(-1,-1));
-                        pqueue.enqueue(p+QPoint(1,-1));
-                    }
-                }
-                --patch_index;
-                patches_skipped++;
-
-            } else {
-                // save the patch in the result
-                counts.push_back(found);
-                total_size+=found;
-            }
+    const double cs = src.cellsize();
+    for (int root : roots) {
+        const PatchAccumulator &acc = stats[root];
+        if (acc.size < min_size) {
+            ++patches_skipped;
+            continue;
         }
+        PatchStatistics ps;
+        ps.id = counts.size() + 1;
+        ps.size = acc.size;
+        ps.rect = QRect(QPoint(acc.x_min, acc.y_min), QPoint(acc.x_max, acc.y_max));
+        ps.centroid = QPointF(src.metricRect().left() + (acc.x_sum/acc.size + 0.5)*cs,
+                              src.metricRect().top() + (acc.y_sum/acc.size + 0.5)*cs);
+        mLastPatchStats.push_back(ps);
+        root_ids[root] = ps.id;
+        counts.push_back(acc.size);
+        total_size += acc.size;
     }
-    // remove the -1 again...
-    mClumpGrid.limit(0,999999);
 
-    qDebug() << "extractPatches: found" << patch_index << "patches, total valid pixels:" << total_size << "skipped" << patches_skipped;
+    // (4) write the patch ids
+    QtConcurrent::blockingMap(band_index, [&](const int b) {
+        for (int i=bands[b].first*nx; i<bands[b].second*nx; ++i)
+            mClumpGrid[i] = parent[i]>=0 ? root_ids.value(patchRoot(parent, i), 0) : 0;
+    });
+
+    qDebug() << "extractPatches: found" << counts.size() << "patches, total valid pixels:" << total_size << "skipped" << patches_skipped;
     if (!fileName.isEmpty()) {
         qDebug() << "extractPatches: save to file:" << GlobalSettings::instance()->path(fileName);
         Helper::saveToTextFile(GlobalSettings::instance()->path(fileName), gridToESRIRaster(mClumpGrid) );
@@ -185,12 +278,12 @@ void SpatialAnalysis::saveCrownCoverGrid(QString fileName, QJSValue grid)
 
 }
 
-QJSValue SpatialAnalysis::patches(QJSValue grid, int min_size)
+QJSValue SpatialAnalysis::patches(QJSValue grid, int min_size, int connectivity)
 {
     ScriptGrid *sg = qobject_cast<ScriptGrid*>(grid.toQObject());
     if (sg) {
         // extract patches (keep patches with a size >= min_size
-        mLastPatches = extractPatches(*sg->grid(), min_size, QString());
+        mLastPatches = extractPatches(*sg->grid(), min_size, QString(), connectivity);
         // create a (double) copy of the internal clump grid, and return this grid
         // as a JS value
         QJSValue v = ScriptGrid::createGrid(mClumpGrid.toDouble(),"patch");
@@ -199,8 +292,24 @@ QJSValue SpatialAnalysis::patches(QJSValue grid, int min_size)
         areas = GlobalSettings::instance()->scriptEngine()->newArray(mLastPatches.length());
         for (int i=0;i<mLastPatches.size();++i)
             areas.setProperty(i, QJSValue(mLastPatches[i]));
+        // statistics per patch (the id, size, bounding box (cell indices) and centroid (metric coordinates))
+        QJSValue stats = GlobalSettings::instance()->scriptEngine()->newArray(mLastPatchStats.length());
+        for (int i=0;i<mLastPatchStats.size();++i) {
+            const PatchStatistics &ps = mLastPatchStats[i];
+            QJSValue s = GlobalSettings::instance()->scriptEngine()->newObject();
+            s.setProperty("id", ps.id);
+            s.setProperty("size", ps.size);
+            s.setProperty("xmin", ps.rect.left());
+            s.setProperty("ymin", ps.rect.top());
+            s.setProperty("xmax", ps.rect.right());
+            s.setProperty("ymax", ps.rect.bottom());
+            s.setProperty("x", ps.centroid.x());
+            s.setProperty("y", ps.centroid.y());
+            stats.setProperty(i, s);
+        }
         res.setProperty("grid", v);
         res.setProperty("areas", areas);
+        res.setProperty("patches", stats);
         return res;
     }
     return QJSValue();
@@ -43,11 +43,20 @@ public:
     ~SpatialAnalysis();
     static void addToScriptEngine();
 
+    /// statistics of a single patch (see extractPatches())
+    struct PatchStatistics {
+        int id; ///< the patch id (1, 2, ...)
+        int size; ///< number of pixels
+        QRect rect; ///< bounding box (cell indices)
+        QPointF centroid; ///< center of gravity (metric coordinates)
+    };
+
     double rumpleIndexFullArea(); ///< retrieve the rumple index for the full landscape (one value)
     /// extract patches ('clumps') and save the resulting grid to 'fileName' (if not empty). Returns a vector with
-    /// the number of pixels for each patch-id
-    QList<int> extractPatches(Grid<double> &src, int min_size, QString fileName);
+    /// the number of pixels for each patch-id. 'connectivity' is 8 (Moore neighborhood) or 4 (von Neumann neighborhood).
+    QList<int> extractPatches(Grid<double> &src, int min_size, QString fileName, int connectivity=8);
     QList<int> patchsizes() const { return mLastPatches; }
+    const QVector<PatchStatistics> &patchStatistics() const { return mLastPatchStats; } ///< statistics of the patches of the last extractPatches()
 
     static void runCrownProjection2m(FloatGrid *agrid=nullptr); ///< internal function that prepares crown cover for the whole landscape
 
@@ -57,7 +66,7 @@ public slots:
     void saveCrownCoverGrid(QString fileName); ///< save a grid if crown cover percentages (RU level) to a ESRI grid file (ascii)
     void saveCrownCoverGrid(QString fileName, QJSValue grid); ///< save a grid of crown cover with the extent/resolution given by 'grid'
 
-    QJSValue patches(QJSValue grid, int min_size);
+    QJSValue patches(QJSValue grid, int min_size, int connectivity=8);
 
 
 private:
@@ -67,6 +76,7 @@ private:
     FloatGrid mCrownCoverGrid;
     Grid<int> mClumpGrid;
     QList<int> mLastPatches;
+    QVector<PatchStatistics> mLastPatchStats;
     friend class SpatialLayeredGrid;
 
 };
@@ -77,13 +77,33 @@ double StatData::calculateSD() const
     return mSD;
 }
 
+/// the index of the percentile 'percent' (1..99) in a sorted list with 'count' elements.
+int StatData::percentileIndex(const int percent, const int count)
+{
+    int perc = limit(percent, 1, 99);
+    int k;
+    if (perc!=50) {
+        // irgendwelche perzentillen
+        int d = 100 / ( (perc>50?(100-perc):perc) );
+        k = count / d;
+        if (perc>50)
+          k=count - k - 1;
+    } else {
+        // median
+        if (count & 1)  // gerade/ungerade?
+          k = count / 2 ;  // mittlerer wert
+        else
+          k= count / 2 -1; // wert unter der mitte
+    }
+    return k;
+}
+
 double StatData::percentile(const int percent) const
 {
 // double *Values, int ValueCount,
     // code von: Fast median search: an ANSI C implementation, Nicolas Devillard, http://ndevilla.free.fr/median/median/index.html
         // algo. kommt von Wirth, hier nur an c++ angepasst.
 
-    int perc = limit(percent, 1, 99);
     int ValueCount = mData.count();
     int i,j,l,m, n, k ;
     double x, temp ;
@@ -91,19 +111,7 @@ double StatData::percentile(const int percent) const
       return 0;
     n = ValueCount;
     // k ist der "Index" des gesuchten wertes
-    if (perc!=50) {
-        // irgendwelche perzentillen
-        int d = 100 / ( (perc>50?(100-perc):perc) );
-        k = ValueCount / d;
-        if (perc>50)
-          k=ValueCount - k - 1;
-    } else {
-        // median
-        if (ValueCount & 1)  // gerade/ungerade?
-          k = ValueCount / 2 ;  // mittlerer wert
-        else
-          k= ValueCount / 2 -1; // wert unter der mitte
-    }
+    k = percentileIndex(percent, ValueCount);
     l=0 ; m=n-1 ;
     while (l<m) {
         x=mData[k] ;
@@ -43,6 +43,7 @@ public:
     // additional functions
     static QVector<int> calculateRanks(const QVector<double> &data, bool descending=false); ///< rank data.
     static void normalize(QVector<double> &data, double targetSum); ///< normalize, i.e. the sum of all items after processing is targetSum
+    static int percentileIndex(const int percent, const int count); ///< index of the value of percentile 'percent' in sorted data with 'count' values (see percentile())
 private:
     double calculateSD() const;
     mutable QVector<double> mData; // mutable to allow late calculation of percentiles (e.g. a call to "median()".)